@@ -428,13 +428,28 @@ struct VS_OUT {
 #ifdef VERTEX
 	layout (location = PositionIndex) 	in vec3 InputPositon;
 	layout (location = NormalIndex)		in vec3 InputNormal;
+#ifdef INSTANCING_ON
+	#define InstanceMatrixIndex 6
+	// rows of the row major model matrix
+	layout (location = InstanceMatrixIndex) in mat4 InstanceObjectToWorld;
+#endif
 
 	out VS_OUT vs_out;
 
 	void main()
 	{
+	#ifdef INSTANCING_ON
+		// world space, MATRIX_M is not valid for instanced draws
+		vec4 position = vec4(InputPositon, 1) * InstanceObjectToWorld;
+		// normals need the inverse-transpose of the model matrix (non-uniform scale).
+		// the cofactor matrix is inverse-transpose * det, the sign of det keeps mirrored objects facing out.
+		mat3 m = transpose(mat3(InstanceObjectToWorld));
+		mat3 cofactor = mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1]));
+		vec3 normal = cofactor * InputNormal * sign(dot(m[0], cofactor[0]));
+	#else
 		vec4 position = vec4(InputPositon, 1);
 		vec3 normal = InputNormal;
+	#endif
 		 
 		 
 		 
@@ -451,11 +466,19 @@ struct VS_OUT {
 	
 	float4 ClipSpaceShadowCasterPos(float4 vertex, float3 normal, float biasScale)
 	{
+	#ifdef INSTANCING_ON
+		float4 wPos = vertex;	// already in world space
+	#else
 		float4 wPos = mul(MATRIX_M, vertex);
+	#endif
 
 		if (unity_LightShadowBias.z != 0.0)
 		{
+		#ifdef INSTANCING_ON
+			float3 wNormal = normal;
+		#else
 			float3 wNormal = UnityObjectToWorldNormal(normal);
+		#endif
 			float3 wLight = normalize(UnityWorldSpaceLightDir(wPos.xyz));
 
 			 
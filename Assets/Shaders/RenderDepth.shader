@@ -63,9 +63,19 @@ layout(std140, row_major) uniform PerDrawUniforms
 
 layout (location = PositionIndex) in vec3 InputPosition;
 
+#ifdef INSTANCING_ON
+#define InstanceMatrixIndex 6
+// rows of the row major model matrix
+layout (location = InstanceMatrixIndex) in mat4 InstanceObjectToWorld;
+#endif
+
 void main()
 {
+#ifdef INSTANCING_ON
+    gl_Position = MATRIX_VP * (vec4(InputPosition, 1) * InstanceObjectToWorld);
+#else
     gl_Position = MATRIX_MVP * vec4(InputPosition, 1);
+#endif
 }
 
 #endif
@@ -135,6 +135,9 @@ namespace FishEditor
 			m_importTangents = importTangents;
 		}
 
+		ModelImporterAnimationCompression GetAnimationCompression() const { return m_animationCompression; }
+		void SetAnimationCompression(ModelImporterAnimationCompression value) { m_animationCompression = value; }
+
 		const std::map<int64_t, FishEngine::Object*>& GetFileIDToObject() const
 		{
 			return m_FileIDToObject;
@@ -184,6 +187,14 @@ namespace FishEditor
 		// Existing material search setting.
 		ModelImporterMaterialSearch m_materialSearch;
 
+		// Animation compression setting. Every mode except Off does key reduction and quantization.
+		ModelImporterAnimationCompression m_animationCompression = ModelImporterAnimationCompression::KeyframeReductionAndCompression;
+
+		// Allowed error of animation compression: position/scale per component(in scene units), rotation in degrees.
+		float m_animationPositionError = 0.001f;
+		float m_animationRotationError = 0.1f;
+		float m_animationScaleError = 0.001f;
+
 		// remove dummy nodes
 //		Meta(NonSerializable)
 		std::map<std::string, std::map<std::string, FishEngine::Matrix4x4>> m_nodeTransformations;
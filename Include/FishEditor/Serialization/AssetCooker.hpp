@@ -0,0 +1,40 @@
+#pragma once
+
+#include <FishEngine/Object.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace FishEditor
+{
+	// Cooks .unity/.prefab assets into the binary archive format(BinaryArchive.hpp).
+	// The cooked file of an asset is Library/Cooked/<guid>.bin, written by its importer after the YAML
+	// file was loaded, and loaded instead of the YAML file while it is up to date.
+	//
+	// A cooked file starts with the assets it depends on(the other assets its objects reference: the
+	// prefabs its prefab instances were flattened from, meshes, materials), each with the write time
+	// of its file at cook time, then the archive.
+	class AssetCooker
+	{
+	public:
+		static std::string GetCookedPath(const std::string& guid);
+
+		// the cooked file exists, is not older than the asset file at fullPath, and none of the assets
+		// it depends on was modified(or removed) since it was cooked
+		static bool IsUpToDate(const std::string& fullPath, const std::string& guid);
+
+		// the cooked file at cookedPath exists and is not older than any of sourcePaths. For the cooked
+		// files without a dependency table(Mesh::SaveCooked, AnimationClip::SaveCooked).
+		static bool IsCookedFileUpToDate(const std::string& cookedPath, const std::vector<std::string>& sourcePaths);
+
+		// the archive in the cooked file of the asset, empty if there is none
+		static std::string ReadCookedFile(const std::string& guid);
+
+		// Write objects(objects[0] is the main object) and every local object they reference.
+		// Prefab instances are written as the objects they instantiated.
+		// fileIDToObject: the fileIDs of the asset file, see BinaryOutputArchive::Dump.
+		static bool Cook(const std::vector<FishEngine::Object*>& objects,
+			const std::map<int64_t, FishEngine::Object*>& fileIDToObject, const std::string& guid);
+	};
+}
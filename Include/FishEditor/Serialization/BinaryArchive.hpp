@@ -0,0 +1,271 @@
+#pragma once
+
+#include <FishEngine/Serialization/Archive.hpp>
+#include <FishEngine/FishEngine2.hpp>
+
+#include <map>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace FishEngine;
+
+namespace FishEditor
+{
+	// Cooked scene/prefab layout, little endian:
+	//
+	//	header		magic "FEBA", version, checksum(FNV-1a of everything after it), class count, guid count,
+	//				object count, fileID count
+	//	classes		per class: classID, field count, field names. MapKey stores the index of the name
+	//				in the table of the class of the object being written, nested structs included.
+	//	guids		guids of the external assets referenced by the file
+	//	objects		per object: index of its class, fileID, offset of its value in the payload
+	//	fileIDs		per fileID of the file: fileID, index of its object. Not derived from the objects: the
+	//				objects of a flattened prefab instance keep the fileIDs of the prefab(two instances
+	//				have the same ones), and a prefab instance's fileID maps to its root GameObject.
+	//	payload		one value per object, a Map of its fields
+	//
+	// Every value starts with a BinaryTag. Integers are varints(zigzag for signed), Map and Sequence store
+	// their size in bytes, so a reader skips a value it does not ask for without parsing it.
+	// The reader checks the checksum and every size and index before creating any object: a damaged
+	// file loads as nothing, and the importers fall back to the YAML file.
+	enum class BinaryTag : uint8_t
+	{
+		Null,
+		Int,			// zigzag varint
+		UInt,			// varint
+		Float,			// 4 bytes
+		Double,			// 8 bytes
+		Bool,			// 1 byte
+		String,			// varint length, chars
+		Object,			// varint index into the object table
+		ExternalObject,	// zigzag varint fileID, varint index into the guid table
+		Sequence,		// uint32 size in bytes, uint32 count, values
+		Map,			// uint32 size in bytes, uint32 count, (varint field index, value) pairs
+	};
+
+	constexpr uint32_t BinaryArchiveMagic = 0x41424546;	// "FEBA"
+	constexpr uint32_t BinaryArchiveVersion = 3;
+
+
+	class BinaryInputArchive : public InputArchive
+	{
+	public:
+		BinaryInputArchive() = default;
+
+		// objects in the order of the object table, the first one is the main object.
+		// nullptr for the objects of the classes that can not be created.
+		// Empty if the data is not a cooked file of this version or is corrupt: nothing is created then.
+		std::vector<Object*> LoadAllFromBuffer(const char* data, size_t size);
+
+		std::vector<Object*> LoadAllFromString(const std::string& str)
+		{
+			return LoadAllFromBuffer(str.data(), str.size());
+		}
+
+		Object* GetObjectByFileID(int64_t fileID)
+		{
+			auto it = m_FileIDToObject.find(fileID);
+			if (it == m_FileIDToObject.end())
+			{
+				// fileID not found
+				abort();
+			}
+			return it->second;
+		}
+
+		const std::map<int64_t, Object*>& GetFileIDToObject() const
+		{
+			return m_FileIDToObject;
+		};
+
+	protected:
+		virtual Object* DeserializeObject() override;
+
+		virtual void Deserialize(short & t) override;
+		virtual void Deserialize(unsigned short & t) override;
+		virtual void Deserialize(int & t) override;
+		virtual void Deserialize(unsigned int & t) override;
+		virtual void Deserialize(long & t) override;
+		virtual void Deserialize(unsigned long & t) override;
+		virtual void Deserialize(long long & t) override;
+		virtual void Deserialize(unsigned long long & t) override;
+		virtual void Deserialize(float & t) override;
+		virtual void Deserialize(double & t) override;
+		virtual void Deserialize(bool & t) override;
+		virtual void Deserialize(std::string & t) override;
+
+		// Map
+		virtual bool MapKey(const char* name) override;
+		virtual void AfterValue() override { PopCursor(); }
+
+		// Sequence
+		virtual int BeginSequence() override;
+		virtual void BeginSequenceItem() override;
+		virtual void AfterSequenceItem() override;
+
+		// std::map, keys are the field names
+		virtual int BeginMap() override;
+		virtual void BeginMapKey() override;
+		virtual void AfterMapKey() override;
+		virtual void AfterMapValue() override;
+
+	private:
+		// a value being read, and the position of its next entry/item if it is a Map or a Sequence
+		struct Cursor
+		{
+			uint32_t			pos = 0;		// offset of the tag, ~0u if the key was not found
+			uint32_t			begin = 0;		// first entry/item
+			uint32_t			end = 0;
+			uint32_t			count = 0;
+			uint32_t			next = 0;		// next entry/item to look at
+			uint32_t			nextIndex = 0;
+			const std::string*	key = nullptr;	// reading the key of a std::map entry, not a value
+		};
+
+		struct ClassTable
+		{
+			int							classID;
+			std::vector<std::string>	fields;
+		};
+
+		template<class T>
+		T ReadNumber();
+
+		// the container of the current value, entries/items positioned at the first one
+		Cursor& OpenContainer(BinaryTag tag);
+
+		void PushCursor(uint32_t pos)
+		{
+			Cursor c;
+			c.pos = pos;
+			m_cursors.push_back(c);
+		}
+
+		void PopCursor()
+		{
+			m_cursors.pop_back();
+		}
+
+		// Move pos after the value at pos, false if it is malformed: it or one of its entries/items does
+		// not fit before end, or a field/object/guid index is out of range. table: class of the object.
+		bool CheckValue(uint32_t& pos, uint32_t end, const ClassTable& table, int depth) const;
+
+		// offset after the value at pos
+		uint32_t SkipValue(uint32_t pos) const;
+
+		uint8_t ReadByte(uint32_t& pos) const;
+		uint32_t ReadUInt32(uint32_t& pos) const;
+		uint64_t ReadVarint(uint32_t& pos) const;
+
+	private:
+		const uint8_t*				m_data = nullptr;	// payload
+		uint32_t					m_size = 0;
+		std::vector<Cursor>			m_cursors;
+
+		std::vector<ClassTable>		m_classes;
+		const ClassTable*			m_class = nullptr;	// class of the object being read
+		std::vector<std::string>	m_guids;
+		std::vector<Object*>		m_objects;
+
+		// local
+		std::map<int64_t, Object*>	m_FileIDToObject;
+	};
+
+
+
+	class BinaryOutputArchive : public OutputArchive
+	{
+	public:
+		explicit BinaryOutputArchive(std::ostream& fout) : fout(fout)
+		{
+		}
+
+		// Write objects and every local object they reference. objects[0] is the main object.
+		// fileIDToObject: the fileIDs of the file(YAMLInputArchive::GetFileIDToObject), loaded back as is.
+		// Objects of other assets(anything with a guid in AssetDatabase except excludedGUID, the asset being
+		// cooked) are written as {fileID, guid} like YAMLOutputArchive does for Mesh and Material.
+		void Dump(const std::vector<Object*>& objects, const std::map<int64_t, Object*>& fileIDToObject,
+			const std::string& excludedGUID = "");
+
+		void Dump(Object* obj)
+		{
+			Dump(std::vector<Object*>{obj}, {{obj->GetLocalIdentifierInFile(), obj}});
+		}
+
+		// guids of the other assets referenced by the dumped objects(source prefabs, meshes, materials)
+		const std::vector<std::string>& GetExternalGUIDs() const
+		{
+			return m_guids;
+		}
+
+	protected:
+		virtual void Serialize(short t) override				{ WriteInt(t); }
+		virtual void Serialize(unsigned short t) override		{ WriteUInt(t); }
+		virtual void Serialize(int t) override					{ WriteInt(t); }
+		virtual void Serialize(unsigned int t) override			{ WriteUInt(t); }
+		virtual void Serialize(long t) override					{ WriteInt(t); }
+		virtual void Serialize(unsigned long t) override		{ WriteUInt(t); }
+		virtual void Serialize(long long t) override			{ WriteInt(t); }
+		virtual void Serialize(unsigned long long t) override	{ WriteUInt(t); }
+		virtual void Serialize(float t) override;
+		virtual void Serialize(double t) override;
+		virtual void Serialize(bool t) override;
+		virtual void Serialize(std::string const & t) override;
+		virtual void SerializeNullPtr() override;
+		virtual void SerializeObject(Object* t) override;
+
+		virtual void MapKey(const char* name) override;
+		virtual void AfterValue() override { EndValue(); }
+
+		virtual void BeginSequence(int size) override;
+		virtual void BeforeSequenceItem() override { BeginValue(); }
+		virtual void AfterSequenceItem() override { EndValue(); }
+
+	private:
+		// a value being written
+		struct Slot
+		{
+			bool		written = false;
+			BinaryTag	container = BinaryTag::Null;	// Map or Sequence once it is one
+			uint32_t	sizePos = 0;
+			uint32_t	count = 0;
+		};
+
+		struct ClassTable
+		{
+			int											classID;
+			std::vector<std::string>					fields;
+			std::unordered_map<std::string, uint32_t>	fieldIndices;
+		};
+
+		void BeginValue() { m_slots.emplace_back(); }
+		void EndValue();
+
+		// tag of the value in the current slot
+		void WriteTag(BinaryTag tag);
+		void WriteInt(int64_t t);
+		void WriteUInt(uint64_t t);
+
+		uint32_t GetObjectIndex(Object* obj);
+		uint32_t GetGUIDIndex(const std::string& guid);
+
+		std::ostream&						fout;
+		std::vector<uint8_t>				m_data;	// payload
+		std::vector<Slot>					m_slots;
+
+		std::vector<ClassTable>				m_classes;
+		std::map<int, uint32_t>				m_classIndices;		// classID -> index in m_classes
+		ClassTable*							m_class = nullptr;	// class of the object being written
+
+		std::vector<std::string>			m_guids;
+		std::map<std::string, uint32_t>		m_guidIndices;
+
+		std::vector<Object*>				m_objects;
+		std::map<Object*, uint32_t>			m_objectIndices;
+
+		// objects of other assets -> (guid, fileID)
+		std::map<Object*, std::pair<std::string, int64_t>>	m_externalObjects;
+	};
+}
@@ -23,8 +23,15 @@ namespace FishEditor
 	public:
 		YAMLInputArchive() = default;
 
+		// The --- !u!classID &fileID documents are split at their headers and parsed in parallel on the
+		// JobSystem, then created serially and deserialized in parallel(see DeserializeAll).
 		std::vector<Object*> LoadAllFromString(const std::string& str);
 
+		// Same objects as LoadAllFromString, but the --- !u!classID &fileID documents are read from the
+		// stream, parsed, created and deserialized one at a time. Only the documents waiting for an object
+		// they reference(a forward fileID) are kept in memory until it shows up.
+		std::vector<Object*> LoadAllFromStream(std::istream& is);
+
 
 		Object* GetObjectByFileID(int64_t fileID)
 		{
@@ -43,7 +50,28 @@ namespace FishEditor
 			return m_FileIDToObject;
 		};
 
+		// wall time of the last load, in milliseconds
+		struct LoadTimes
+		{
+			double	parse = 0;			// YAML text to nodes
+			double	deserialize = 0;	// creating the objects, instantiating prefabs, deserializing
+		};
+
+		const LoadTimes& GetLoadTimes() const
+		{
+			return m_loadTimes;
+		}
+
 	protected:
+		// An archive deserializing documents on a worker thread: it has its own node stack and iterators,
+		// and resolves fileIDs through the maps of parent, which are read-only meanwhile.
+		explicit YAMLInputArchive(const YAMLInputArchive* parent) : m_parent(parent)
+		{
+		}
+
+		// Deserialize objects[i] from m_nodes[i], GameObjects before their components. Each GameObject and its
+		// components are deserialized by one thread, different GameObjects in parallel.
+		void DeserializeAll(const std::vector<Object*>& objects, const std::vector<std::pair<int, int64_t>>& classID_fileID);
 
 //		bool Skip() override
 //		{
@@ -92,16 +120,22 @@ namespace FishEditor
 		// Map
 		virtual bool MapKey(const char* name) override
 		{
-			auto current = CurrentNode();
-			assert(current.IsMap());
-			auto node = current[name];
-			if (!node)
+			auto node = FindKey(name);
+			if (node == nullptr)
 			{
 				LogWarning(Format("Key [{}] not found!", name));
+				PushNode(YAML::Node());
+				return false;
 			}
-			PushNode(node);
+			PushNode(*node);
+			return true;
+		}
 
-			return !(!node);
+		virtual bool OptionalMapKey(const char* name) override
+		{
+			auto node = FindKey(name);
+			PushNode(node != nullptr ? *node : YAML::Node());
+			return node != nullptr;
 		}
 
 		virtual void AfterValue() override
@@ -145,30 +179,72 @@ namespace FishEditor
 //			PopNode();
 		}
 
-		void PushNode(YAML::Node node)
+		void PushNode(const YAML::Node& node)
 		{
 //			puts("push");
-			m_workingNodes.push(node);
+			m_workingNodes.emplace_back(node);
 		}
 
 
 		void PopNode()
 		{
 //			puts("pop");
-			m_workingNodes.pop();
+			assert(!m_workingNodes.empty());
+			auto& current = m_workingNodes.back();
+			if (current.indexed)
+			{
+				m_keyIndex.resize(current.indexBegin);
+				m_keyValues.resize(current.valuesBegin);
+			}
+			m_workingNodes.pop_back();
 		}
 
-		YAML::Node CurrentNode()
+		const YAML::Node& CurrentNode() const
 		{
 			assert(!m_workingNodes.empty());
-			return m_workingNodes.top();
+			return m_workingNodes.back().node;
 		}
 
+		// value of key name in the current map, nullptr if not found.
+		// The keys are hashed the first time the map is looked up, later lookups do not allocate.
+		const YAML::Node* FindKey(const char* name);
+
 
 	protected:
+		class StreamLoader;
+
+		// a node being read, and where its keys are in m_keyIndex once it is indexed.
+		// YAML::Node is copy constructed only: its operator= writes through to the document
+		struct WorkingNode
+		{
+			explicit WorkingNode(const YAML::Node& node) : node(node)
+			{
+			}
+
+			YAML::Node	node;
+			uint32_t	indexBegin = 0;
+			uint32_t	indexMask = 0;		// slot count - 1, a power of 2
+			uint32_t	valuesBegin = 0;
+			bool		indexed = false;
+		};
+
+		struct KeyIndexEntry
+		{
+			uint32_t			hash = 0;
+			uint32_t			value = 0;		// index in m_keyValues
+			const std::string*	key = nullptr;	// nullptr if the slot is empty
+		};
+
+		void BuildKeyIndex(WorkingNode& current);
+
 		std::vector<YAML::Node>		m_nodes;
 		YAML::Node					m_currentNode;
-		std::stack<YAML::Node>		m_workingNodes;
+		std::vector<WorkingNode>	m_workingNodes;
+
+		// open addressing hash tables of the indexed working nodes, in stack order. Popping a node drops
+		// its table, the capacity is reused by the next map
+		std::vector<KeyIndexEntry>	m_keyIndex;
+		std::vector<YAML::Node>		m_keyValues;
 		
 		// todo: sequence inside sequence, or, map inside map
 		YAML::const_iterator		m_sequenceIterator;
@@ -176,6 +252,13 @@ namespace FishEditor
 
 		// local
 		std::map<int64_t, Object*>	m_FileIDToObject;
+
+		// (guid, fileID) -> object of another asset, resolved by DeserializeAll before going parallel
+		std::map<std::pair<std::string, int64_t>, Object*>	m_ExternalObjects;
+
+		const YAMLInputArchive*		m_parent = nullptr;
+
+		LoadTimes					m_loadTimes;
 	};
 
 
@@ -2,13 +2,20 @@
 
 #include "../Component/Behaviour.hpp"
 #include "WrapMode.hpp"
+#include "AnimationCurve.hpp"
+#include "AnimationLOD.hpp"
+#include "AnimationPose.hpp"
+
+#include <map>
+#include <vector>
+#include <cstdint>
 
 namespace FishEngine
 {
 	
 	class AnimationClip;
 	
-	class FE_EXPORT Animation : public Behaviour
+	class FE_EXPORT Animation final : public Behaviour
 	{
 	public:
 		DeclareObject(Animation, 111);
@@ -19,8 +26,62 @@ namespace FishEngine
 		}
 
 		void Start();
+
+		// Prepare + SamplePose + ApplyPose
 		void Update(float deltaTime);
 
+		// Update in phases, so that AnimationSystem can sample many characters on worker threads.
+		// Prepare and ApplyPose touch the hierarchy and must run on the main thread; SamplePose only
+		// reads the clip and writes this component's pose buffer.
+		void Prepare();
+		void SamplePose(float deltaTime);
+		void ApplyPose();
+
+		// local pose of every bone after blending all layers, valid after SamplePose
+		const AnimationPose& GetPose() const { return m_pose; }
+
+		// Layered playback over preallocated pose buffers.
+		// Layers are evaluated in order over the rest pose(local TRS of the bones at Bind), each one overrides
+		// the result below it by its weight and bone mask, and crossfades between two clips on its own.
+		// Layer 0 plays m_clip. ApplyPose writes each animated bone once, however many clips were blended.
+		int AddLayer(float weight = 1.0f);
+		int GetLayerCount() const { return static_cast<int>(m_layers.size()); }
+		void SetLayerWeight(int layer, float weight) { m_layers[layer].weight = weight; }
+		float GetLayerWeight(int layer) const { return m_layers[layer].weight; }
+
+		// Limit the layer to the bones under the given curve paths(e.g. "Hips/Spine"), empty: every bone.
+		void SetLayerMask(int layer, const std::vector<std::string>& bonePaths);
+
+		// Play clip on the layer from its start.
+		void Play(AnimationClip* clip, int layer = 0);
+
+		// Fade from the clip playing on the layer to clip, in fadeLength seconds.
+		void CrossFade(AnimationClip* clip, float fadeLength, int layer = 0);
+
+		// Set by AnimationSystem every frame, Full by default.
+		// updateInterval: SamplePose samples every Nth call, the time of the skipped calls is added to the next one.
+		// phase: characters with the same interval are spread over different frames(used when leaving interval 1,
+		// later interval changes keep the running countdown, clamped to the new interval).
+		void SetLOD(AnimationLOD lod, const AnimationLODSettings& settings, int phase = 0);
+		AnimationLOD GetLOD() const { return m_lod; }
+
+		// did the last SamplePose sample a new pose
+		bool IsPoseSampled() const { return m_poseSampled; }
+
+		// channels(position, rotation or scale of a bone) written to transforms by the last ApplyPose
+		int GetAppliedCurveCount() const { return m_appliedCurveCount; }
+
+		void SetClip(AnimationClip* clip)
+		{
+			m_clip = clip;
+			Bind();
+		}
+
+		// Resolve the skeleton and every curve path of the played clips to its bone once, so Update does
+		// no string lookups, and size the pose buffers. Called by Start/SetClip, and by Update when m_clip
+		// was assigned directly.
+		void Bind();
+
 		// the default animation
 		AnimationClip* m_clip;
 
@@ -30,8 +91,84 @@ namespace FishEngine
 
 		WrapMode m_wrapMode;
 
+		// radius of the character around its transform, for the screen size of the LOD
+		float m_boundsRadius = 1.0f;
+
 		// temp
 		float m_localTimer = 0.0f;
 		std::map<std::string, Transform*> m_skeleton;
+
+	private:
+		// one clip played by any layer, bound to the skeleton
+		struct ClipBinding
+		{
+			AnimationClip*			clip;
+			// bone index of every curve of clip->m_xxxCurves, -1 if not found
+			// rotations: GetEulersRotationSources() then m_rotationCurves, like the rotations of the clip's runtime formats
+			std::vector<int>		positionBones;
+			std::vector<int>		rotationBones;
+			std::vector<int>		scaleBones;
+			// sampled in the compressed or sampled layout of the clip, empty if the clip has no data
+			std::vector<float>		pose;
+			// one byte per curve(positions, rotations, then scales), 0 if the LOD skips it; empty at Full and Reduced
+			std::vector<uint8_t>	trackMask;
+		};
+
+		struct Layer
+		{
+			float						weight = 1.0f;
+			std::vector<std::string>	maskPaths;
+			std::vector<float>			boneMask;	// per bone, empty: every bone
+			int							clip = -1;	// index into m_clips
+			float						time = 0;
+			int							nextClip = -1;	// crossfading to, -1 if not fading
+			float						nextTime = 0;
+			float						fade = 0;
+			float						fadeSpeed = 0;
+			// A fade interrupted by CrossFade continues from the pose it had reached, frozen here,
+			// instead of jumping to the clip that was fading in.
+			bool						fadeFromSnapshot = false;
+			AnimationPose				snapshot;
+		};
+
+		enum BoneChannel : uint8_t
+		{
+			PositionChannel = 1,
+			RotationChannel = 2,
+			ScaleChannel = 4,
+			AllChannels = 7,
+		};
+
+		int FindOrAddClip(AnimationClip* clip);
+		void BindClip(ClipBinding& binding);
+		void UpdateLayerMask(Layer& layer);
+
+		// rebuild binding.trackMask from m_lod and the bone depths
+		void UpdateTrackMask(ClipBinding& binding);
+
+		// write the curves of the clip at time to their bones in pose
+		void SampleClip(ClipBinding& binding, float time, AnimationPose& pose);
+
+		AnimationClip*				m_boundClip = nullptr;
+		std::vector<ClipBinding>	m_clips;
+		std::vector<Layer>			m_layers;
+
+		// skeleton, m_bones[i] is bone i of every pose
+		std::vector<Transform*>		m_bones;
+		std::vector<int>			m_boneDepths;	// bones above it in its path, 0 for root bones
+		std::map<std::string, int>	m_boneIndices;	// path -> bone index
+
+		AnimationPose				m_restPose;
+		AnimationPose				m_pose;
+		AnimationPose				m_layerPose;
+		AnimationPose				m_fadePose;
+		std::vector<uint8_t>		m_boneChannels;		// BoneChannel bits written by the last SamplePose
+
+		AnimationLOD				m_lod = AnimationLOD::Full;
+		int							m_updateInterval = 1;
+		int							m_framesUntilUpdate = 0;
+		int							m_maxBoneDepth = 0;		// Minimal evaluates bones with depth <= m_maxBoneDepth
+		bool						m_poseSampled = false;
+		int							m_appliedCurveCount = 0;
 	};
 }
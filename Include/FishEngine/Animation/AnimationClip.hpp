@@ -8,6 +8,10 @@
 #include "AnimationEvent.hpp"
 
 #include "AnimationCurve.hpp"
+#include "SampledAnimationClip.hpp"
+#include "CompressedAnimationClip.hpp"
+
+#include <map>
 
 namespace FishEngine
 {
@@ -71,6 +75,45 @@ namespace FishEngine
 		std::vector<Vector3Curve> m_eulersCurves;
 		std::vector<Vector3Curve> m_scaleCurves;
 		Avatar* m_avatar = nullptr;
+
+		// The euler curves that drive a rotation, in order. FBX import fills both m_eulersCurves and
+		// m_rotationCurves: a path that has a quaternion curve only uses that one.
+		// The sampled/compressed layout and Animation's binding both follow this list.
+		std::vector<const Vector3Curve*> GetEulersRotationSources() const;
+
+		// Resample the curves above into m_sampledClip. Call again after editing the curves.
+		// Does nothing once the keys were released(see Compress).
+		SampledAnimationClip::Report BuildSampledClip(float sampleRate = 0)
+		{
+			if (!HasSourceKeys())
+				return SampledAnimationClip::Report();
+			m_compressedClip.Clear();
+			return m_sampledClip.Build(*this, sampleRate);
+		}
+
+		// Compress m_sampledClip(built first if needed) into m_compressedClip, then release it and the
+		// keyframes of the curves above: only m_compressedClip is kept. The curves keep their paths for binding.
+		CompressedAnimationClip::Report Compress(const CompressedAnimationClip::Settings& settings);
+
+		// false after Compress, or for a clip loaded from a cooked file: the curves can not be resampled
+		bool HasSourceKeys() const;
+
+		// Write the runtime format(m_compressedClip if valid, else m_sampledClip, built first if needed),
+		// the name, the curve paths and the fileID of m_avatar to a cooked file.
+		// false if m_avatar has no fileID.
+		bool SaveCooked(const std::string& path);
+
+		// A clip using the runtime format of a cooked file in place. Its curves have paths(for binding) but
+		// no keys. Its avatar is looked up in fileIDToObject(the objects of the model file).
+		// nullptr if the file can not be used or the avatar is missing.
+		static AnimationClip* FromCookedFile(const std::string& path,
+			const std::map<int64_t, Object*>& fileIDToObject = {});
+
+		// runtime format used by Animation, built from the curves at import(or lazily on first bind)
+		SampledAnimationClip m_sampledClip;
+
+		// used instead of m_sampledClip when valid
+		CompressedAnimationClip m_compressedClip;
 	};
 
 
@@ -6,6 +6,7 @@
 #include "../Math/Vector3.hpp"
 #include "../Math/Quaternion.hpp"
 #include <cassert>
+#include <cstdint>
 
 namespace FishEngine
 {
@@ -19,6 +20,21 @@ namespace FishEngine
 	};
 
 
+	/**
+	* Key segment found by the previous Evaluate call of one curve. Playback time usually moves forward by a
+	* small delta, so the next sample nearly always falls in the same segment or in the one right after it.
+	* Keep one cursor per(curve, player) pair; a default constructed cursor is always a cache miss.
+	* SampledAnimationClip::Build keeps one per curve while it samples the frames in order.
+	*/
+	struct AnimationCurveCursor
+	{
+		uint32_t leftKey = ~0u;
+		uint32_t rightKey = ~0u;	// out of range until the first search
+		float segmentStart = 0;		// cache hit when segmentStart <= time < segmentEnd
+		float segmentEnd = 0;
+	};
+
+
 	template <class T>
 	class FE_EXPORT TAnimationCurve
 	{
@@ -34,6 +50,9 @@ namespace FishEngine
 		const KeyframeType & keyframeAt(uint32_t index) const { return m_keyframes[index]; }
 
 		T Evaluate(float time, bool loop = true) const;
+
+		/** Same as Evaluate(time, loop), but looks up the keys through @p cursor before falling back to FindKeys. */
+		T Evaluate(float time, AnimationCurveCursor& cursor, bool loop = true) const;
 		
 		/**
 		* Returns a pair of keys that can be used for interpolating to field the value at the provided time.
@@ -48,6 +67,12 @@ namespace FishEngine
 		/** Returns a key frame index nearest to the provided time. */
 		uint32_t FindKey(float time);
 
+		/** Same as FindKeys, but checks the segment cached in @p cursor and the one after it first. */
+		void FindKeys(float time, AnimationCurveCursor& cursor, uint32_t& leftKey, uint32_t& rightKey) const;
+
+		/** Interpolates between two keys returned by FindKeys. */
+		T EvaluateSegment(float time, uint32_t leftKey, uint32_t rightKey) const;
+
 		std::vector<KeyframeType> m_keyframes;
 		float m_start;
 		float m_end;
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace FishEngine
+{
+	// How much of an Animation is evaluated, chosen every frame by AnimationSystem from the screen size.
+	enum class AnimationLOD
+	{
+		Full,           // every curve, every frame.
+		Reduced,        // every curve, every Nth frame.
+		Minimal,        // bones near the root only(e.g. hips and spine), every Nth frame.
+		Offscreen,      // position of the root bones only, so root motion keeps moving the character.
+		Count,
+	};
+
+	struct AnimationLODSettings
+	{
+		bool	enabled = true;
+
+		// screen size is the projected radius of the character divided by the half height of the screen
+		float	reducedScreenSize = 0.2f;	// below this: Reduced
+		float	minimalScreenSize = 0.05f;	// below this: Minimal
+
+		int		reducedUpdateInterval = 2;	// frames
+		int		minimalUpdateInterval = 4;	// frames
+
+		// Minimal evaluates bones with at most this many ancestor bones, 0 = root bones only
+		int		minimalBoneDepth = 2;
+	};
+
+	// per LOD counters of the last AnimationSystem::Update
+	struct AnimationLODStats
+	{
+		int		animationCount[(int)AnimationLOD::Count] = {};	// animations at the LOD
+		int		sampledCount[(int)AnimationLOD::Count] = {};	// of those, sampled this frame
+		int		curveCount[(int)AnimationLOD::Count] = {};		// bone channels(position, rotation, scale) written to transforms
+	};
+}
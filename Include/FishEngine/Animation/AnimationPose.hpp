@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+#include "../Math/Vector3.hpp"
+#include "../Math/Quaternion.hpp"
+
+#include <vector>
+
+namespace FishEngine
+{
+	// Local TRS of every bone of a skeleton.
+	// Sized once by Resize, then reused every frame: CopyFrom and Blend never allocate.
+	struct FE_EXPORT AnimationPose
+	{
+		std::vector<Vector3>	positions;
+		std::vector<Quaternion>	rotations;
+		std::vector<Vector3>	scales;
+
+		void Resize(int boneCount);
+		int GetBoneCount() const { return static_cast<int>(positions.size()); }
+
+		// other must have the same bone count
+		void CopyFrom(const AnimationPose& other);
+
+		// Move every bone towards other by weight * boneWeights[bone](boneWeights may be nullptr: 1 for all bones).
+		// Positions and scales are lerped, rotations nlerped on the shortest path.
+		void Blend(const AnimationPose& other, float weight, const float* boneWeights);
+	};
+}
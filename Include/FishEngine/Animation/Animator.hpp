@@ -99,7 +99,7 @@ namespace FishEngine
 	class Avatar;
 	class RuntimeAnimatorController;
 
-	class FE_EXPORT Animator : public Behaviour
+	class FE_EXPORT Animator final : public Behaviour
 	{
 	public:
 		DeclareObject(Animator, 95);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+#include "../Serialization/CookedFile.hpp"
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace FishEngine
+{
+	class SampledAnimationClip;
+
+	// Compressed runtime format of a SampledAnimationClip.
+	// Every bone channel(position, rotation, scale of one curve) is a track that keeps only the frames
+	// needed to stay within the error bound under linear interpolation, and each key is 48 bits:
+	//   - rotations: the quaternion samples of the source, stored smallest-three
+	//     (2 bit index of the dropped component + 3 x 15 bit), interpolated with nlerp
+	//   - positions, scales: 3 x 16 bit quantized in the [min, max] range of the track
+	// The error bound is checked against the quantized keys, so it covers both key removal and quantization
+	// (a vector track whose range is too large for 16 bit steps keeps all keys and reports the larger error).
+	//
+	// Pose layout written by Sample:
+	//   [position xyz...][rotation xyzw...][scale xyz...]
+	class FE_EXPORT CompressedAnimationClip
+	{
+	public:
+		struct Settings
+		{
+			float positionError = 0.001f;	// max per-component error, in scene units
+			float rotationError = 0.1f;		// max angle error, in degrees
+			float scaleError = 0.001f;		// max per-component error
+		};
+
+		// measured by decompressing every source frame
+		struct Report
+		{
+			int		trackCount = 0;
+			int		sourceKeyCount = 0;
+			int		keyCount = 0;
+			size_t	sourceBytes = 0;
+			size_t	compressedBytes = 0;
+			float	maxPositionError = 0;
+			float	maxRotationError = 0;	// degrees
+			float	maxScaleError = 0;
+		};
+
+		// Fails(IsValid() == false) if the source has more than 65536 frames.
+		Report Compress(const SampledAnimationClip& source, const Settings& settings);
+		void Clear();
+
+		bool IsValid() const { return !GetTracks().empty(); }
+
+		int GetPositionCount() const { return m_PositionCount; }
+		int GetRotationCount() const { return m_RotationCount; }
+		int GetScaleCount() const { return m_ScaleCount; }
+
+		// floats per pose buffer
+		int GetPoseSize() const { return GetScaleOffset() + 3 * m_ScaleCount; }
+
+		int GetPositionOffset() const { return 0; }
+		int GetRotationOffset() const { return 3 * m_PositionCount; }
+		int GetScaleOffset() const { return 3 * m_PositionCount + 4 * m_RotationCount; }
+
+		float GetLength() const { return m_Length; }
+		size_t GetMemorySize() const;
+
+		// Writes GetPoseSize() floats to pose. time is wrapped(or clamped) to [0, GetLength()].
+		// trackMask(optional) has one byte per track(positions, rotations, then scales),
+		// tracks whose byte is 0 are not decoded and their floats in pose are left untouched.
+		void Sample(float time, bool loop, float* pose, const uint8_t* trackMask = nullptr) const;
+
+		int GetTrackCount() const { return static_cast<int>(GetTracks().size); }
+
+		// Add the clip to a cooked file.
+		void Cook(CookedFileWriter& writer) const;
+
+		// Use the clip of a mapped cooked file, the keys are decoded from the mapped pages in place.
+		// false if a track's keys or range are outside the key sections.
+		bool LoadCooked(const std::shared_ptr<CookedFile>& file);
+
+	private:
+		struct Track
+		{
+			uint32_t	firstKey;
+			uint32_t	keyCount;
+			uint32_t	range;		// index into m_Ranges(min xyz, extent xyz), vector tracks only
+		};
+
+		// frame may be fractional
+		void EvaluateTrack(const Track& track, bool rotation, float frame, float* out) const;
+		void DecodeKey(const Track& track, bool rotation, uint32_t key, float* out) const;
+
+		// the arrays below, or their sections in m_CookedFile
+		ArrayView<Track> GetTracks() const { return m_CookedFile ? m_CookedTracks : ArrayView<Track>(m_Tracks); }
+		ArrayView<uint16_t> GetKeyFrames() const { return m_CookedFile ? m_CookedKeyFrames : ArrayView<uint16_t>(m_KeyFrames); }
+		ArrayView<uint16_t> GetKeyValues() const { return m_CookedFile ? m_CookedKeyValues : ArrayView<uint16_t>(m_KeyValues); }
+		ArrayView<float> GetRanges() const { return m_CookedFile ? m_CookedRanges : ArrayView<float>(m_Ranges); }
+
+		float					m_SampleRate = 0;
+		float					m_Length = 0;
+		int						m_PositionCount = 0;
+		int						m_RotationCount = 0;
+		int						m_ScaleCount = 0;
+		std::vector<Track>		m_Tracks;		// positions, then rotations, then scales
+		std::vector<uint16_t>	m_KeyFrames;	// source frame index of every key
+		std::vector<uint16_t>	m_KeyValues;	// 3 per key
+		std::vector<float>		m_Ranges;
+
+		// set by LoadCooked, the vectors above are empty then
+		std::shared_ptr<CookedFile>	m_CookedFile;
+		ArrayView<Track>			m_CookedTracks;
+		ArrayView<uint16_t>			m_CookedKeyFrames;
+		ArrayView<uint16_t>			m_CookedKeyValues;
+		ArrayView<float>			m_CookedRanges;
+	};
+}
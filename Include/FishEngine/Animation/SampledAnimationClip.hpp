@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+#include "../Serialization/CookedFile.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace FishEngine
+{
+	class AnimationClip;
+
+	// Runtime format of an AnimationClip: every curve channel resampled on one uniform time grid.
+	// Keys are stored frame-major, all channels of one frame contiguous(padded to a multiple of 8),
+	// so sampling is a single lerp between two rows that the SIMD kernels do 4/8 channels at a time.
+	//
+	// Rotations are baked to quaternions at build time(the euler curves of GetEulersRotationSources
+	// converted in XYZ order, then m_rotationCurves), every frame on the hemisphere of the previous one. The lerp of two frames is then
+	// an nlerp on the shortest path once normalized, and sampling needs no trigonometry.
+	//
+	// Channel layout of a frame(and of the pose buffer written by Sample):
+	//   [m_positionCurve xyz...][eulers sources, m_rotationCurves xyzw...][m_scaleCurves xyz...][padding]
+	// so position/scale curve i starts at GetXXXOffset() + 3*i, rotation i at GetRotationOffset() + 4*i.
+	// Sampled rotations are not normalized.
+	class FE_EXPORT SampledAnimationClip
+	{
+	public:
+		// max error of the lerped frames against the Hermite curves, measured between frames
+		struct Report
+		{
+			float	maxPositionError = 0;	// max per-component error, in scene units
+			float	maxRotationError = 0;	// degrees
+			float	maxScaleError = 0;
+		};
+
+		// sampleRate <= 0 uses clip.frameRate(or 30 if the clip has none).
+		// The rate is raised slightly if needed so the last frame falls exactly on the clip length,
+		// GetSampleRate() returns the rate actually used.
+		Report Build(const AnimationClip& clip, float sampleRate = 0);
+		void Clear();
+
+		bool IsValid() const { return m_FrameCount > 0; }
+
+		int GetChannelCount() const { return m_ChannelCount; }
+
+		// floats per frame and per pose buffer
+		int GetStride() const { return m_Stride; }
+
+		int GetFrameCount() const { return m_FrameCount; }
+		float GetSampleRate() const { return m_SampleRate; }
+		float GetLength() const { return m_Length; }
+
+		int GetPositionCount() const { return m_RotationOffset / 3; }
+		int GetRotationCount() const { return (m_ScaleOffset - m_RotationOffset) / 4; }
+		int GetScaleCount() const { return (m_ChannelCount - m_ScaleOffset) / 3; }
+
+		int GetPositionOffset() const { return 0; }
+		int GetRotationOffset() const { return m_RotationOffset; }
+		int GetScaleOffset() const { return m_ScaleOffset; }
+
+		const float* GetFrame(int frame) const { return GetKeys() + frame * m_Stride; }
+
+		// Writes GetStride() floats to pose. time is wrapped(or clamped) to [0, GetLength()].
+		void Sample(float time, bool loop, float* pose) const;
+
+		// out[i] = a[i] + (b[i] - a[i]) * alpha, count is a multiple of 8
+		static void Lerp(const float* a, const float* b, float alpha, float* out, int count);
+		static void Lerp_Scalar(const float* a, const float* b, float alpha, float* out, int count);
+		static void Lerp_SSE(const float* a, const float* b, float alpha, float* out, int count);
+		// only when CPU::HasAVX()
+		static void Lerp_AVX(const float* a, const float* b, float alpha, float* out, int count);
+
+		// Name of the kernel used by Lerp.
+		static const char* KernelName();
+
+		// Add the clip to a cooked file.
+		void Cook(CookedFileWriter& writer) const;
+
+		// Use the clip of a mapped cooked file, the keys are sampled from the mapped pages in place.
+		// false if the channel layout or the key count does not match what Build makes.
+		bool LoadCooked(const std::shared_ptr<CookedFile>& file);
+
+	private:
+		const float* GetKeys() const { return m_CookedFile ? m_CookedKeys : m_Keys.data(); }
+
+		float				m_SampleRate = 0;
+		float				m_Length = 0;
+		int					m_FrameCount = 0;
+		int					m_ChannelCount = 0;
+		int					m_Stride = 0;
+		int					m_RotationOffset = 0;
+		int					m_ScaleOffset = 0;
+		std::vector<float>	m_Keys;		// m_FrameCount * m_Stride
+
+		// set by LoadCooked, m_Keys is empty then
+		std::shared_ptr<CookedFile>	m_CookedFile;
+		const float*				m_CookedKeys = nullptr;
+	};
+}
@@ -5,7 +5,7 @@
 
 namespace FishEngine
 {
-	class BoxCollider : public Collider
+	class BoxCollider final : public Collider
 	{
 	public:
 		DeclareObject(BoxCollider, 65);
@@ -16,7 +16,7 @@ namespace FishEngine
 		Preview,
 	};
 
-	class FE_EXPORT Camera : public Behaviour
+	class FE_EXPORT Camera final : public Behaviour
 	{
 	public:
 		DeclareObject(Camera, 20);
@@ -28,7 +28,7 @@ namespace FishEngine
 //	class LayeredDepthBuffer;
 //	class RenderTarget;
 
-	class FE_EXPORT Light : public Behaviour
+	class FE_EXPORT Light final : public Behaviour
 	{
 	public:
 		DeclareObject(Light, 108);
@@ -1,12 +1,13 @@
 #pragma once
 
 #include "../Component.hpp"
+#include "../Render/RendererRegistry.hpp"
 
 namespace FishEngine
 {
 	class Mesh;
 	
-	class MeshFilter : public Component
+	class MeshFilter final : public Component
 	{
 	public:
 		DeclareObject(MeshFilter, 33);
@@ -17,10 +18,15 @@ namespace FishEngine
 		
 		~MeshFilter()
 		{
+			RendererRegistry::GetInstance().OnMeshFilterDestroyed(this);
 		}
 
 		Mesh* GetMesh() const { return m_Mesh; }
-		void SetMesh(Mesh* mesh) { m_Mesh = mesh; }
+		void SetMesh(Mesh* mesh)
+		{
+			m_Mesh = mesh;
+			RendererRegistry::GetInstance().OnMeshFilterChanged(this);
+		}
 		
 	private:
 		Mesh* m_Mesh = nullptr;
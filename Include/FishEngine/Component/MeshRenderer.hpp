@@ -5,7 +5,7 @@
 
 namespace FishEngine
 {
-	class MeshRenderer : public Renderer
+	class MeshRenderer final : public Renderer
 	{
 	public:
 		DeclareObject(MeshRenderer, 23);
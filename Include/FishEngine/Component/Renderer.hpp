@@ -3,6 +3,7 @@
 #include "../Component.hpp"
 #include "../Render/Material.hpp"
 #include "../Math/Bounds.hpp"
+#include "../Render/RendererRegistry.hpp"
 #include <vector>
 
 namespace FishEngine
@@ -22,9 +23,13 @@ namespace FishEngine
 
 		Renderer(int classID, const char* className) : Component(classID, className)
 		{
+			RendererRegistry::GetInstance().Register(this);
 		}
 
-		virtual ~Renderer() {}
+		virtual ~Renderer()
+		{
+			RendererRegistry::GetInstance().Unregister(this);
+		}
 
 
 		Material* GetMaterial() const
@@ -40,11 +45,13 @@ namespace FishEngine
 				m_Materials.push_back(material);
 			else
 				m_Materials[0] = material;
+			RendererRegistry::GetInstance().SetDirty(this);
 		}
 
 		void AddMaterial(Material* material)
 		{
 			m_Materials.push_back(material);
+			RendererRegistry::GetInstance().SetDirty(this);
 		}
 
 //		virtual Bounds localBounds() const = 0;
@@ -59,7 +66,11 @@ namespace FishEngine
 		bool GetEnabled() const { return m_Enabled; }
 
 		// Makes the rendered 3D object visible if enabled.
-		void SetEnabled(bool value) { m_Enabled = value; }
+		void SetEnabled(bool value)
+		{
+			m_Enabled = value;
+			RendererRegistry::GetInstance().SetDirty(this);
+		}
 
 		const ShadowCastingMode& GetCastShadows() const { return m_CastShadows; }
 		void SetCastShadows(const ShadowCastingMode& value) { m_CastShadows = value; }
@@ -72,6 +83,10 @@ namespace FishEngine
 		ShadowCastingMode		m_CastShadows = ShadowCastingMode::On;
 		bool					m_ReceiveShadows = true;
 		std::vector<Material*> 	m_Materials;
+
+	private:
+		friend class RendererRegistry;
+		int						m_RegistryIndex = -1;
 //		ShadowCastingMode		m_ShadowCastingMode = ShadowCastingMode::On;
 	};
 }
\ No newline at end of file
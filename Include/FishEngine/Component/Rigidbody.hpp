@@ -11,7 +11,7 @@ namespace physx
 
 namespace FishEngine
 {
-	class Rigidbody : public Component
+	class Rigidbody final : public Component
 	{
 	public:
 		DeclareObject(Rigidbody, 54);
@@ -3,6 +3,8 @@
 #include <vector>
 #include "Renderer.hpp"
 #include "../Math/Matrix4x4.hpp"
+#include "../Math/Bounds.hpp"
+#include "../Render/Skinning.hpp"
 
 namespace FishEditor
 {
@@ -15,7 +17,7 @@ namespace FishEngine
 	class Avatar;
 	class RenderSystem;
 
-	class SkinnedMeshRenderer : public Renderer
+	class SkinnedMeshRenderer final : public Renderer
 	{
 	public:
 		DeclareObject(SkinnedMeshRenderer, 137);
@@ -32,9 +34,20 @@ namespace FishEngine
 		void SetRootBone(Transform* rootBone) { m_RootBone = rootBone; }
 		Transform* GetRootBone() const { return  m_RootBone; }
 
-		void SetSharedMesh(Mesh* sharedMesh) { m_Mesh = sharedMesh; }
+		void SetSharedMesh(Mesh* sharedMesh)
+		{
+			m_Mesh = sharedMesh;
+			RendererRegistry::GetInstance().SetDirty(this);
+		}
 		Mesh* GetSharedMesh() const { return m_Mesh; }
 
+		void SetSkinningMethod(SkinningMethod method) { m_SkinningMethod = method; }
+		SkinningMethod GetSkinningMethod() const { return m_SkinningMethod; }
+
+		// bounds of the mesh in the current pose, in the local space of the renderer.
+		// Updated with the bone matrices every frame, invalid until then.
+		const Bounds& GetAnimatedBounds() const { return m_AnimatedBounds; }
+
 	private:
 
 		friend class RenderSystem;
@@ -45,12 +58,16 @@ namespace FishEngine
 		Mesh*		m_Mesh = nullptr;
 		Avatar*		m_Avatar = nullptr;
 		Transform*	m_RootBone = nullptr;
+		SkinningMethod	m_SkinningMethod = SkinningMethod::LinearBlend;
 
 		// The bones used to skin the mesh.
 		// same size with sharedMesh.bindposes
 		std::vector<Transform*> m_Bones;
 
+		mutable Bounds m_AnimatedBounds;
 		mutable std::vector<Matrix4x4> m_MatrixPalette;
+		mutable std::vector<Matrix3x4> m_MatrixPalette3x4;	// CPU skinning
+		mutable std::vector<DualQuaternion> m_DualQuaternionPalette;	// CPU dual quaternion skinning
 		mutable std::vector<Vector3> m_SkinnedVertexPosition;
 		mutable std::vector<Vector3> m_SkinnedVertexNormal;
 	};
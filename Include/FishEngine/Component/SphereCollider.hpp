@@ -5,7 +5,7 @@
 
 namespace FishEngine
 {
-	class SphereCollider : public Collider
+	class SphereCollider final : public Collider
 	{
 	public:
 		DeclareObject(SphereCollider, 135);
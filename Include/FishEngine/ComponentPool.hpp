@@ -0,0 +1,32 @@
+#pragma once
+
+#include "FishEngine.hpp"
+#include "Object.hpp"
+
+#include <vector>
+#include <type_traits>
+
+namespace FishEngine
+{
+	// Typed view of the per-ClassID dense object lists for components, so that systems can visit all
+	// components of one type contiguously instead of walking the hierarchy and calling GetComponent.
+	// Removal is swap-and-pop, so the order inside a pool is not stable.
+	// Pools are keyed by the exact ClassID: a pool for a base class(Renderer, Collider) is always empty.
+	class FE_EXPORT ComponentPool
+	{
+	public:
+		static const std::vector<Object*>& Get(int classID)
+		{
+			return Object::FindObjectsOfType(classID);
+		}
+
+		// f(T*) for every live T, including components not attached to any GameObject yet
+		template<class T, class Function>
+		static void ForEach(Function f)
+		{
+			static_assert(std::is_final<T>::value, "ComponentPool only stores exact types, T must be a leaf component class");
+			for (auto c : Get(T::ClassID))
+				f(static_cast<T*>(c));
+		}
+	};
+}
@@ -45,22 +45,39 @@ namespace FishEngine
 
 		void AddComponent(Component* comp);
 		
+		// Returns the first component that is a T, in the order the components were added.
+		// O(1) for leaf(final) component classes: one scan of the inline ClassID table, no RTTI.
+		// Base classes(Renderer, Collider, ...) walk the component list with dynamic_cast, so a derived
+		// component added before an exact T is still the one returned.
 		template<class T>
 		T* GetComponent()
 		{
 			static_assert(std::is_base_of<Component, T>::value, "T must be a Component");
+			// a final class has no subclasses, the exact match is the first match
+			if (std::is_final<T>::value)
+				return static_cast<T*>(GetComponent(T::ClassID));
 			for (Component* t : m_Component)
 			{
-				if (t->Is<T>())
-				{
-					return dynamic_cast<T*>(t);
-				}
+				auto ret = dynamic_cast<T*>(t);
+				if (ret != nullptr)
+					return ret;
 			}
 			return nullptr;
 		}
 		
 		Component* GetComponent(int classID)
 		{
+			int count = m_ComponentTableCount;
+			if (count > ComponentTableSize)
+				count = ComponentTableSize;
+			for (int i = 0; i < count; ++i)
+			{
+				if (m_ComponentTable[i].classID == classID)
+					return m_ComponentTable[i].component;
+			}
+			if (m_ComponentTableCount <= ComponentTableSize)
+				return nullptr;
+			// more components than the table holds
 			for (Component* t : m_Component)
 			{
 				if (t->GetClassID() == classID)
@@ -117,7 +134,7 @@ namespace FishEngine
 		
 		// The local active state of this GameObject.
 		bool IsActive() const { return m_IsActive; }
-		void SetActive(bool active) { m_IsActive = active; }
+		void SetActive(bool active);
 		
 		// Is the GameObject active in the scene?
 		bool IsActiveInHierarchy() const;
@@ -129,6 +146,8 @@ namespace FishEngine
 		void SetPrefabInternal(Prefab* value) { m_PrefabInternal = value; }
 
 	protected:
+		void AddToComponentTable(Component* comp);
+
 		GameObject * 			m_PrefabParentObject = nullptr;
 		Prefab * 				m_PrefabInternal = nullptr;
 		Scene*					m_Scene = nullptr;
@@ -137,5 +156,15 @@ namespace FishEngine
 		int 					m_Layer;
 		std::string 			m_TagString;
 		bool					m_IsActive = true;	// activeSelf
+
+		// first component of each ClassID, in m_Component order; most GameObjects have fewer than 8 types
+		static constexpr int ComponentTableSize = 8;
+		struct ComponentSlot
+		{
+			int			classID;
+			Component*	component;
+		};
+		ComponentSlot			m_ComponentTable[ComponentTableSize];
+		int						m_ComponentTableCount = 0;	// > ComponentTableSize when some types only live in m_Component
 	};
 }
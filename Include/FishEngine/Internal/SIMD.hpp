@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+
+// SSE2 is the baseline of the x64 builds.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define FE_SIMD_SSE 1
+#endif
+
+// AVX kernels are compiled per function with FE_TARGET_AVX, not with -mavx or /arch:AVX for the whole file:
+// inline functions shared with the SSE kernels would be compiled with AVX too, and the linker may keep that
+// copy. They must only be called when CPU::HasAVX().
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#	define FE_SIMD_AVX 1
+#	define FE_TARGET_AVX __attribute__((target("avx")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#	define FE_SIMD_AVX 1
+#	define FE_TARGET_AVX		// MSVC emits the AVX intrinsics without /arch:AVX
+#else
+#	define FE_TARGET_AVX
+#endif
+
+namespace FishEngine
+{
+	class FE_EXPORT CPU
+	{
+	public:
+		CPU() = delete;
+
+		// The AVX kernels are built and can run here: the CPU supports AVX and the OS saves the ymm registers.
+		static bool HasAVX();
+	};
+}
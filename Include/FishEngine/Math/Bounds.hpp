@@ -7,6 +7,7 @@
 namespace FishEngine
 {
 	class Ray;
+	class Matrix4x4;
 	
 	class FE_EXPORT Bounds
 	{
@@ -152,6 +153,9 @@ namespace FishEngine
 		// param point Arbitrary point.
 		// return The point on the bounding box or inside the bounding box.
 		Vector3 ClosestPoint(const Vector3& point);
+
+		// The aabb of this box transformed by matrix(e.g. local to world).
+		Bounds Transform(const Matrix4x4& matrix) const;
 		
 		bool IsValid() const
 		{
@@ -3,6 +3,8 @@
 
 #include "Mathf.hpp"
 #include "Vector3.hpp"
+#include "Vector4.hpp"
+#include "Bounds.hpp"
 
 namespace FishEngine
 {
@@ -35,6 +37,32 @@ namespace FishEngine
 			v[7].Set(-w2, -h2, maxRange);   // far bottom left
 		}
 	};
+
+	class Matrix4x4;
+
+	// The 6 planes of a view volume in world space.
+	// Each plane is stored as (normal, d), the normal points to the inside of the volume.
+	struct FE_EXPORT FrustumPlanes
+	{
+		enum PlaneIndex
+		{
+			Left = 0,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+		};
+
+		Vector4 planes[6];
+
+		// Extract planes from a world to clip space matrix(proj * view).
+		static FrustumPlanes FromMatrix(const Matrix4x4& worldToClip);
+
+		// Is the world space aabb inside or intersecting the volume?
+		// Conservative: a box outside the volume but near a corner may return true.
+		bool Intersects(const Bounds& worldBounds) const;
+	};
 }
 
 #endif // Frustum_hpp
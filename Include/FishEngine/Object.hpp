@@ -1,8 +1,9 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
+#include <cstdint>
+#include <atomic>
 #include "FishEngine.hpp"
 #include "HideFlags.hpp"
 
@@ -14,6 +15,17 @@ namespace FishEngine
 	class InputArchive;
 	class OutputArchive;
 
+	// Weak reference to an Object. Object::Resolve returns nullptr once the object is destroyed,
+	// even if its slot has been reused by a newer object.
+	struct ObjectHandle
+	{
+		uint32_t index = 0;		// 0 is invalid
+		uint32_t generation = 0;
+
+		bool operator==(const ObjectHandle& rhs) const { return index == rhs.index && generation == rhs.generation; }
+		bool operator!=(const ObjectHandle& rhs) const { return !(*this == rhs); }
+	};
+
 #define InjectClassName(className, classID) 				\
 	enum {ClassID = classID}; 								\
 	static constexpr const char* ClassName = #className;
@@ -26,7 +38,7 @@ namespace FishEngine
 	InjectClassName(className, classID) 	\
 	OverrideSerializeFunc
 
-	class Object
+	class FE_EXPORT Object
 	{
 	public:
 
@@ -45,6 +57,10 @@ namespace FishEngine
 		int GetInstanceID() const { return m_InstanceID; }
 		int GetClassID() const { return m_ClassID; }
 
+		// dense index among the live objects of the same ClassID, reused after destruction.
+		// Only changes when another object of the class is destroyed.
+		int GetClassIndex() const { return m_ClassListIndex; }
+
 		const char* GetClassName() const { return m_ClassName; }
 		
 		//void SetPyObject(const pybind11::object& obj)
@@ -77,36 +93,40 @@ namespace FishEngine
 		}
 		
 	public:
-		static int GetInstanceCounter() { return s_InstanceCounter; }
+		static int GetInstanceCounter() { return s_InstanceCounter.load(); }
 		
-		static int GetDeleteCounter() { return s_DeleteCounter; }
+		static int GetDeleteCounter() { return s_DeleteCounter.load(); }
 		
 		template<class T>
 		static T* FindObjectOfType()
 		{
-			auto& objs = s_Objects[T::ClassID];
+			auto& objs = FindObjectsOfType(T::ClassID);
 			if (objs.empty())
 				return nullptr;
-			auto first = *objs.begin();
-			return dynamic_cast<T*>(first);
+			return dynamic_cast<T*>(objs.front());
 		}
 
-		
+		// all live objects whose ClassID is exactly T::ClassID, in no particular order
 		template<class T>
-		static const std::unordered_set<Object*>& FindObjectsOfType()
+		static const std::vector<Object*>& FindObjectsOfType()
 		{
-			return s_Objects[T::ClassID];
+			return FindObjectsOfType(T::ClassID);
 		}
 		
-		static const std::unordered_set<Object*>& FindObjectsOfType(int classID)
-		{
-			return s_Objects[classID];
-		}
+		// The returned lists change when objects are created or destroyed,
+		// do not iterate them while another thread may do so(e.g. a scene is being loaded).
+		static const std::vector<Object*>& FindObjectsOfType(int classID);
 
-		static const std::unordered_map<int, std::unordered_set<Object*>>& GetAllObjects()
-		{
-			return s_Objects;
-		}
+		// indexed by ClassID, MaxClassID lists. Main thread only, and not while another thread may create or
+		// destroy objects: no lock is taken.
+		static const std::vector<std::vector<Object*>>& GetAllObjects();
+
+		// every ClassID is below this
+		static constexpr int MaxClassID = 2048;
+
+		ObjectHandle GetHandle() const;
+
+		static Object* Resolve(ObjectHandle handle);
 
 		virtual void Deserialize(InputArchive& archive);
 		virtual void Serialize(OutputArchive& archive) const;
@@ -121,11 +141,16 @@ namespace FishEngine
 		int					m_ClassID = 0;
 		int					m_InstanceID = 0;
 		uint64_t			m_LocalIdentifierInFile = 0;
+		uint32_t			m_HandleIndex = 0;		// slot in the handle table
+		int					m_ClassListIndex = -1;	// position in the object list of m_ClassID
 		
 	private:
-		static int s_InstanceCounter;
-		static int s_DeleteCounter;
-		static std::unordered_map<int, std::unordered_set<Object*>> s_Objects;
+		// thread safe, objects are created on worker threads while a scene is deserialized
+		void Register();
+		void Unregister();
+
+		static std::atomic<int> s_InstanceCounter;
+		static std::atomic<int> s_DeleteCounter;
 	};
 
 
@@ -133,10 +158,9 @@ namespace FishEngine
 	inline Object::Object(int classID, const char* className)
 			: m_ClassName(className), m_ClassID(classID)
 	{
-		++s_InstanceCounter;
-		m_InstanceID = s_InstanceCounter;
+		m_InstanceID = ++s_InstanceCounter;
 //		printf("Object::Object() ID=%d\n", instanceID);
-		s_Objects[classID].insert(this);
+		Register();
 	}
 	
 	inline Object::~Object()
@@ -144,7 +168,7 @@ namespace FishEngine
 //		LOGF;
 //		printf("Object::~Object() ID=%d\n", m_instanceID);
 		++s_DeleteCounter;
-		Object::s_Objects[m_ClassID].erase(this);
+		Unregister();
 	}
 
 }
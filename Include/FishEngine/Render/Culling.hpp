@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+#include "../Math/Bounds.hpp"
+#include "../Math/Frustum.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace FishEngine
+{
+	// World space bounds of render objects in structure-of-arrays layout.
+	// The arrays are padded to a multiple of 8 so the culling kernels never read past the end.
+	class FE_EXPORT BoundsCache
+	{
+	public:
+		void Clear();
+		void Reserve(int count);
+
+		// invalid bounds are always visible
+		void Add(const Bounds& bounds);
+
+		int size() const { return m_Count; }
+
+		const float* centerX() const { return m_CenterX.data(); }
+		const float* centerY() const { return m_CenterY.data(); }
+		const float* centerZ() const { return m_CenterZ.data(); }
+		const float* extentX() const { return m_ExtentX.data(); }
+		const float* extentY() const { return m_ExtentY.data(); }
+		const float* extentZ() const { return m_ExtentZ.data(); }
+
+	private:
+		int m_Count = 0;
+		std::vector<float> m_CenterX;
+		std::vector<float> m_CenterY;
+		std::vector<float> m_CenterZ;
+		std::vector<float> m_ExtentX;
+		std::vector<float> m_ExtentY;
+		std::vector<float> m_ExtentZ;
+	};
+
+
+	class FE_EXPORT Culling
+	{
+	public:
+		Culling() = delete;
+
+		// Test all boxes against the frustum.
+		// Bit (i % 32) of outMask[i / 32] is set when box i is inside or intersecting the frustum.
+		// Uses the widest kernel the CPU runs(AVX, SSE, scalar).
+		static void CullBounds(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask);
+
+		static void CullBounds_Scalar(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask);
+		static void CullBounds_SSE(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask);
+		// only when CPU::HasAVX()
+		static void CullBounds_AVX(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask);
+
+		// Name of the kernel used by CullBounds.
+		static const char* KernelName();
+
+		static bool IsVisible(const std::vector<uint32_t>& mask, int index)
+		{
+			return (mask[index >> 5] >> (index & 31)) & 1u;
+		}
+	};
+}
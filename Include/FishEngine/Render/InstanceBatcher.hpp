@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+#include "../Math/Matrix4x4.hpp"
+
+#include <vector>
+#include <unordered_map>
+
+namespace FishEngine
+{
+	class Mesh;
+	class Material;
+
+	// A run of draws sharing mesh and material.
+	// [first, first+count) indexes GetMatrices() and GetObjectIndices().
+	struct InstanceBatch
+	{
+		Mesh*		mesh;
+		Material*	material;
+		int			first;
+		int			count;
+	};
+
+	// Groups draws with identical mesh + material and packs their model matrices
+	// contiguously, so each group can be drawn with one instanced call.
+	// Pure CPU work, mesh and material are only used as keys.
+	class FE_EXPORT InstanceBatcher
+	{
+	public:
+		void Clear();
+
+		// objectIndex is a caller defined id(e.g. index of the render object).
+		// Draws that can not be instanced(skinned, transparent...) always get a batch of their own.
+		void Add(Mesh* mesh, Material* material, const Matrix4x4& modelMatrix, int objectIndex, bool instanceable = true);
+
+		// Build the batches. Batches are ordered by the first draw added to each of them,
+		// draws keep their relative order inside a batch.
+		void Build();
+
+		const std::vector<InstanceBatch>& GetBatches() const { return m_Batches; }
+		const std::vector<Matrix4x4>& GetMatrices() const { return m_Matrices; }
+		const std::vector<int>& GetObjectIndices() const { return m_ObjectIndices; }
+
+	private:
+		struct Item
+		{
+			Matrix4x4	modelMatrix;
+			int			objectIndex;
+			int			batch;
+		};
+
+		struct BatchKey
+		{
+			Mesh*		mesh;
+			Material*	material;
+			bool operator==(const BatchKey& rhs) const { return mesh == rhs.mesh && material == rhs.material; }
+		};
+
+		struct BatchKeyHash
+		{
+			size_t operator()(const BatchKey& key) const
+			{
+				return std::hash<void*>()(key.mesh) ^ (std::hash<void*>()(key.material) << 1);
+			}
+		};
+
+		std::vector<Item> m_Items;
+		std::unordered_map<BatchKey, int, BatchKeyHash> m_KeyToBatch;
+		std::vector<InstanceBatch> m_Batches;
+		std::vector<Matrix4x4> m_Matrices;
+		std::vector<int> m_ObjectIndices;
+	};
+}
@@ -28,6 +28,17 @@ namespace FishEngine
 		std::vector<Color> m_COlors;
 	};
 	
+	// Unity's built-in render queues
+	enum class RenderQueue
+	{
+		Background = 1000,
+		Geometry = 2000,
+		AlphaTest = 2450,
+		GeometryLast = 2500,	// last render queue that is considered "opaque"
+		Transparent = 3000,
+		Overlay = 4000,
+	};
+
 	class Material : public Object
 	{
 	public:
@@ -57,6 +68,17 @@ namespace FishEngine
 			m_Shader = shader;
 		}
 		
+		// Render queue of this material, -1 means Geometry.
+		int GetRenderQueue() const
+		{
+			return m_CustomRenderQueue >= 0 ? m_CustomRenderQueue : static_cast<int>(RenderQueue::Geometry);
+		}
+
+		void SetRenderQueue(int value)
+		{
+			m_CustomRenderQueue = value;
+		}
+
 		static void StaticInit();
 		static void StaticClean();
 		
@@ -73,6 +95,7 @@ namespace FishEngine
 	protected:
 		Shader* m_Shader = nullptr;
 		std::string m_ShaderKeywords;
+		int m_CustomRenderQueue = -1;
 		MaterialProperties m_SavedProperties;
 		
 		static Material* s_ErrorMaterial;
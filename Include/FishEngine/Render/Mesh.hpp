@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include "../Object.hpp"
 #include "../Math/Vector2.hpp"
 #include "../Math/Vector3.hpp"
@@ -8,6 +9,7 @@
 #include "../Math/Bounds.hpp"
 #include "BoneWeight.hpp"
 #include "../Asset.hpp"
+#include "../Serialization/CookedFile.hpp"
 
 #define Enable_GPU_Skinning 0
 
@@ -55,6 +57,14 @@ namespace FishEngine
 		
 		// -1: render all sub meshes
 		void Render(int subMeshIndex = -1);
+
+		// Render() = BindVertexArray() + DrawElements() + unbind.
+		// Split so consecutive draws of the same mesh can skip the VAO bind.
+		void BindVertexArray();
+		void DrawElements(int subMeshIndex = -1);
+
+		// Draw instanceCount copies, the vertex array and the instance data must be bound.
+		void DrawElementsInstanced(int instanceCount, int subMeshIndex = -1);
 		
 //		void RenderSkinned();
 		void UploadMeshData(bool markNoLogerReadable = true);
@@ -64,6 +74,13 @@ namespace FishEngine
 		
 		static Mesh* FromTextFile(const std::string &str);
 
+		// A mesh whose streams are the sections of a mapped cooked file: they are uploaded(and skinned on
+		// the CPU) straight from the mapped pages. nullptr if the file can not be used, or if a stream does
+		// not match the vertex/triangle/submesh/bone counts of the file.
+		static Mesh* FromCookedFile(const std::string &path);
+
+		bool SaveCooked(const std::string &path) const;
+
 		static void StaticInit();
 		
 	private:
@@ -89,6 +106,22 @@ namespace FishEngine
 		// Each vertex can be affected by up to 4 different bones.All 4 bone weights should sum up to 1.
 		std::vector<BoneWeight> m_boneWeights;
 
+		// set by FromCookedFile, the vectors above(except m_boneNames) are empty then
+		std::shared_ptr<CookedFile> m_CookedFile;
+
+		// the streams above, or their sections in m_CookedFile
+		ArrayView<Vector3>		GetVertices() const;
+		ArrayView<Vector3>		GetNormals() const;
+		ArrayView<Vector2>		GetUV() const;
+		ArrayView<Vector3>		GetTangents() const;
+		ArrayView<uint32_t>		GetTriangles() const;
+		ArrayView<uint32_t>		GetSubMeshIndexOffset() const;
+		ArrayView<Matrix4x4>	GetBindposes() const;
+		ArrayView<BoneWeight>	GetBoneWeights() const;
+
+		// bind pose space bounds of the vertices weighted to each bone(invalid if none is), computed on first use
+		const std::vector<Bounds>& GetBoneBounds() const;
+		mutable std::vector<Bounds>	m_boneBounds;
 		
 	public:
 		bool m_skinned = false; // temp
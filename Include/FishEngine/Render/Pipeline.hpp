@@ -25,6 +25,12 @@ namespace FishEngine
 
 		static void UpdateBonesUniforms(const std::vector<Matrix4x4>& bones);
 
+		// upload the model matrices of an instanced draw
+		static void UpdateInstanceMatrices(const Matrix4x4* modelMatrices, int count);
+
+		// point the instance attributes of the bound vertex array to the instance buffer
+		static void BindInstanceAttributes();
+
 		static RenderTarget* CurrentRenderTarget()
 		{
 			return s_renderTargetStack.top();
@@ -58,11 +64,15 @@ namespace FishEngine
 		static constexpr unsigned int LightingUBOBindingPoint = 2;
 		static constexpr unsigned int BonesUBOBindingPoint = 3;
 
+		// mat4 InstanceObjectToWorld, location 6 ~ 9
+		static constexpr unsigned int InstanceMatrixAttribIndex = 6;
+
 		private:
 		static unsigned int         s_perCameraUBO;
 		static unsigned int         s_perDrawUBO;
 		static unsigned int         s_lightingUBO;
 		static unsigned int         s_bonesUBO;
+		static unsigned int         s_instanceVBO;
 		static PerCameraUniforms    s_perCameraUniforms;
 		static PerDrawUniforms      s_perDrawUniforms;
 		static LightingUniforms     s_lightingUniforms;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace FishEngine
+{
+	// Number of GL state changes issued / skipped by the last submitted frame.
+	struct RenderStats
+	{
+		int drawCalls = 0;
+		int instancedDrawCalls = 0;
+		int instances = 0;			// objects drawn by instanced draw calls
+		int shaderChanges = 0;
+		int meshChanges = 0;
+		int shaderChangesSaved = 0;
+		int meshChangesSaved = 0;
+
+		void Reset() { *this = RenderStats(); }
+	};
+
+
+	class FE_EXPORT RenderSorter
+	{
+	public:
+		RenderSorter() = delete;
+
+		// 64 bit sort key, from high bits to low bits:
+		//   opaque:      queue(12) | program(12) | material(12) | mesh(12) | depth(16)
+		//   transparent: queue(12) | far-to-near depth(16) | program(12) | material(12) | mesh(12)
+		// program, material and mesh are small ids(Object::GetClassIndex), depth01 is the normalized view depth in [0, 1].
+		// Opaque objects are grouped by state and drawn front-to-back inside a group,
+		// transparent objects are drawn back-to-front.
+		static uint64_t MakeSortKey(int renderQueue, uint32_t program, uint32_t material, uint32_t mesh, float depth01);
+
+		static bool IsTransparent(int renderQueue);
+
+		// LSD radix sort(8 bits per pass), stable. values are reordered along with keys.
+		// Passes where every key has the same digit are skipped.
+		static void RadixSort(std::vector<uint64_t>& keys, std::vector<int>& values);
+
+		// same, tempKeys and tempValues are scratch buffers kept by the caller to avoid allocating per sort.
+		// keys/values may be swapped with them, capacities are preserved.
+		static void RadixSort(std::vector<uint64_t>& keys, std::vector<int>& values,
+							  std::vector<uint64_t>& tempKeys, std::vector<int>& tempValues);
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+
+#include <vector>
+#include <unordered_map>
+
+namespace FishEngine
+{
+	class GameObject;
+	class Renderer;
+	class MeshFilter;
+	class Mesh;
+	class Material;
+
+	// A renderer that is enabled, active in hierarchy and has a mesh.
+	struct RegisteredRenderer
+	{
+		GameObject* gameObject;
+		Renderer*	renderer;
+		Mesh*		mesh;
+		Material*	material;
+	};
+
+	// Persistent list of all renderers.
+	// Components report their changes(add, destroy, enable, active, parent, mesh, material),
+	// Sync() re-evaluates only the changed renderers and keeps the drawable ones in a dense array.
+	class FE_EXPORT RendererRegistry
+	{
+	public:
+		RendererRegistry(RendererRegistry&) = delete;
+		RendererRegistry& operator=(RendererRegistry&) = delete;
+
+		static RendererRegistry& GetInstance()
+		{
+			static RendererRegistry instance;
+			return instance;
+		}
+
+		void Register(Renderer* renderer);
+		void Unregister(Renderer* renderer);
+
+		// enabled state or materials of the renderer changed
+		void SetDirty(Renderer* renderer);
+
+		// the mesh of the MeshFilter changed, or it was added to a GameObject
+		void OnMeshFilterChanged(MeshFilter* meshFilter);
+		void OnMeshFilterDestroyed(MeshFilter* meshFilter);
+
+		// active state or parent of the GameObject changed, dirty all renderers in its hierarchy
+		void OnHierarchyChanged(GameObject* gameObject);
+
+		// re-evaluate dirty renderers
+		void Sync();
+
+		// drawable renderers, valid after Sync()
+		const std::vector<RegisteredRenderer>& GetRenderers() const { return m_Drawables; }
+
+	private:
+		RendererRegistry() = default;
+
+		struct Entry
+		{
+			Renderer*	renderer;
+			MeshFilter*	meshFilter = nullptr;
+			int			drawableIndex = -1;		// index in m_Drawables, -1 if not drawable
+			bool		dirty = true;
+		};
+
+		void MarkDirty(int entryIndex);
+		void RemoveDrawable(int entryIndex);
+
+		std::vector<Entry>						m_Entries;
+		std::vector<int>						m_DirtyEntries;
+		std::vector<RegisteredRenderer>			m_Drawables;
+		std::vector<int>						m_DrawableToEntry;
+		std::unordered_map<MeshFilter*, int>	m_MeshFilterToEntry;
+	};
+}
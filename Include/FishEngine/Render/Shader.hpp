@@ -66,10 +66,16 @@ namespace FishEngine
 		void BindTexture(const char* name, Texture* texture);
 		
 		void Use() const;
+
+		// Does this shader have an INSTANCING_ON variant?
+		// The variant reads the model matrix from the InstanceObjectToWorld attribute instead of PerDrawUniforms.
+		bool SupportsInstancing() const { return m_InstancedGLProgram != 0; }
+		void UseInstanced() const;
 		
 	private:
 		friend class Graphics;
 		unsigned int m_GLProgram = 0;
+		unsigned int m_InstancedGLProgram = 0;
 		ShaderImpl* m_impl;
 	};
 }
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+#include "../Math/Matrix4x4.hpp"
+#include "BoneWeight.hpp"
+
+namespace FishEngine
+{
+	// The top 3 rows of an affine Matrix4x4(row major), the bottom row is always (0, 0, 0, 1).
+	// Blending 4 of them per vertex is 25% cheaper than blending full 4x4 matrices.
+	struct Matrix3x4
+	{
+		float m[3][4];
+
+		Matrix3x4() = default;
+
+		explicit Matrix3x4(const Matrix4x4& mat)
+		{
+			for (int r = 0; r < 3; ++r)
+				for (int c = 0; c < 4; ++c)
+					m[r][c] = mat.m[r][c];
+		}
+	};
+
+
+	// Rigid bone transform as a unit dual quaternion(x, y, z, w order), 8 floats instead of 16.
+	// Scale of the source matrix is dropped.
+	struct DualQuaternion
+	{
+		float real[4];	// rotation
+		float dual[4];	// 0.5 * translation * rotation
+
+		DualQuaternion() = default;
+		explicit DualQuaternion(const Matrix4x4& mat);
+	};
+
+
+	// DualQuaternion is CPU skinning only, GPU skinning always blends matrices
+	enum class SkinningMethod
+	{
+		LinearBlend,		// blend bone matrices, cheapest, collapses volume at twisting joints
+		DualQuaternion,		// blend dual quaternions, keeps volume, ignores bone scale
+	};
+
+
+	// One skinning job: every array has (at least) the vertex count of the mesh.
+	// palette is used by the linear blend kernels, dualQuaternions by the dual quaternion ones.
+	struct SkinningData
+	{
+		const Matrix3x4*		palette;
+		const BoneWeight*		boneWeights;
+		const Vector3*			positions;
+		const Vector3*			normals;
+		Vector3*				skinnedPositions;
+		Vector3*				skinnedNormals;
+		const DualQuaternion*	dualQuaternions;
+	};
+
+
+	class FE_EXPORT Skinning
+	{
+	public:
+		Skinning() = delete;
+
+		// vertices per job of SkinVerticesParallel
+		static constexpr int s_VertexGrainSize = 4096;
+
+		// Skin vertices [first, last): blend the 4 weighted bone matrices of each vertex,
+		// then transform the position and the normal.
+		// Uses the widest kernel the CPU runs(AVX, SSE, scalar).
+		static void SkinVertices(const SkinningData& data, int first, int last);
+
+		static void SkinVertices_Scalar(const SkinningData& data, int first, int last);
+		static void SkinVertices_SSE(const SkinningData& data, int first, int last);
+		// only when CPU::HasAVX()
+		static void SkinVertices_AVX(const SkinningData& data, int first, int last);
+
+		// Dual quaternion skinning of vertices [first, last): blend the 4 weighted dual quaternions
+		// on the hemisphere of the first one, normalize, then transform the position and the normal.
+		static void SkinVerticesDQ(const SkinningData& data, int first, int last);
+
+		static void SkinVerticesDQ_Scalar(const SkinningData& data, int first, int last);
+		static void SkinVerticesDQ_SSE(const SkinningData& data, int first, int last);
+		// only when CPU::HasAVX()
+		static void SkinVerticesDQ_AVX(const SkinningData& data, int first, int last);
+
+		// SkinVertices(or SkinVerticesDQ) over [0, vertexCount) split into ranges on the job system
+		static void SkinVerticesParallel(const SkinningData& data, int vertexCount, SkinningMethod method = SkinningMethod::LinearBlend);
+
+		// Name of the kernel used by SkinVertices and SkinVerticesDQ.
+		static const char* KernelName();
+	};
+}
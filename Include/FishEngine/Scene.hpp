@@ -5,9 +5,11 @@
 #include <map>
 #include "GameObject.hpp"
 #include "Transform.hpp"
+#include "TransformHierarchy.hpp"
 #include <FishEngine/Render/RenderSettings.hpp>
 
 #include <cassert>
+#include <type_traits>
 
 namespace FishEditor
 {
@@ -66,14 +68,12 @@ namespace FishEngine
 			return nullptr;
 		}
 		
+		// leaf component classes are read from their ComponentPool(unordered), base classes walk the hierarchy
 		template<class T>
 		std::vector<T*> FindComponents()
 		{
 			std::vector<T*> components;
-			for (auto t : m_RootTransforms)
-			{
-				t->GetGameObject()->template GetComponentsInChildren<T>(components);
-			}
+			FindComponentsImpl<T>(components, std::integral_constant<bool, std::is_final<T>::value>());
 			return components;
 		}
 		
@@ -92,9 +92,41 @@ namespace FishEngine
 			return m_RenderSettings;
 		}
 
+		// Recompute world matrices of all transforms whose local TRS(or an ancestor's) changed.
+		void UpdateWorldMatrices()
+		{
+			m_TransformHierarchy.UpdateWorldMatrices(m_RootTransforms);
+		}
+
+		const TransformHierarchy& GetTransformHierarchy() const
+		{
+			return m_TransformHierarchy;
+		}
+
 	
 	private:
 		Scene();
+
+		template<class T>
+		void FindComponentsImpl(std::vector<T*>& components, std::true_type)
+		{
+			for (auto o : ComponentPool::Get(T::ClassID))
+			{
+				auto c = static_cast<T*>(o);
+				auto go = c->GetGameObject();
+				if (go != nullptr && go->GetScene() == this)
+					components.push_back(c);
+			}
+		}
+
+		template<class T>
+		void FindComponentsImpl(std::vector<T*>& components, std::false_type)
+		{
+			for (auto t : m_RootTransforms)
+			{
+				t->GetGameObject()->template GetComponentsInChildren<T>(components);
+			}
+		}
 		
 		void AddRootTransform(Transform* t);
 		void RemoveRootTransform(Transform* t);
@@ -106,6 +138,7 @@ namespace FishEngine
 		friend class FishEditor::DefaultImporter;
 
 		std::vector<Transform*> m_RootTransforms;
+		TransformHierarchy		m_TransformHierarchy;
 		RenderSettings* 		m_RenderSettings = nullptr;
 		
 		int 					m_Handle = 0;	// 0 is invalid
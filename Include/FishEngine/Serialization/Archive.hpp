@@ -42,6 +42,16 @@ namespace FishEngine
 //				LogWarning(std::string("skip ") + name);
 			this->AfterValue();
 		}
+
+		// AddNVP for a field that Unity's files do not have(added by FishEngine): no warning when it is
+		// missing, t keeps its value
+		template<class T>
+		void AddOptionalNVP(const char* name, T& t)
+		{
+			if (this->OptionalMapKey(name))
+				(*this) >> t;
+			this->AfterValue();
+		}
 		
 		InputArchive & operator >> (short & t)				{ this->Deserialize(t); return *this; }
 		InputArchive & operator >> (unsigned short & t)		{ this->Deserialize(t); return *this; }
@@ -152,6 +162,8 @@ namespace FishEngine
 		// if should skip next node, return false
 		// eg. return false when the 'name' is not found
 		virtual bool MapKey(const char* name) = 0;
+		// MapKey of AddOptionalNVP, without the warning of a missing key
+		virtual bool OptionalMapKey(const char* name) { return MapKey(name); }
 		virtual void AfterValue() {}
 
 		// Sequence
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../FishEngine.hpp"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace FishEngine
+{
+	// Read-only memory map of a whole file.
+	class FE_EXPORT MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile() { Close(); }
+
+		bool Open(const std::string& path);
+		void Close();
+
+		bool IsOpen() const { return m_data != nullptr; }
+		const uint8_t* GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		const uint8_t*	m_data = nullptr;
+		size_t			m_size = 0;
+#if FISHENGINE_PLATFORM_WINDOWS
+		void*			m_file = nullptr;
+		void*			m_mapping = nullptr;
+#endif
+	};
+
+
+	// count elements at data, in a std::vector or in the pages of a CookedFile
+	template<class T>
+	struct ArrayView
+	{
+		const T*	data = nullptr;
+		size_t		size = 0;
+
+		ArrayView() = default;
+		ArrayView(const T* data, size_t size) : data(data), size(size) {}
+		ArrayView(const std::vector<T>& v) : data(v.data()), size(v.size()) {}
+
+		bool empty() const { return size == 0; }
+		const T* begin() const { return data; }
+		const T* end() const { return data + size; }
+		const T& operator[](size_t i) const { return data[i]; }
+	};
+
+
+	enum class CookedFileType : uint32_t
+	{
+		Mesh = 1,
+		AnimationClip = 2,
+	};
+
+	constexpr uint32_t CookedFourCC(char a, char b, char c, char d)
+	{
+		return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+	}
+
+	constexpr uint32_t CookedFileMagic = CookedFourCC('F', 'E', 'C', 'K');
+	constexpr uint16_t CookedFileVersion = 1;
+
+	// every section starts at a multiple of this, so mapped streams are aligned for SIMD loads and
+	// do not share a cache line with their neighbours
+	constexpr uint32_t CookedSectionAlignment = 64;
+
+	// Cooked mesh/clip layout, in the byte order of the machine that cooked it(the magic does not match
+	// on the other one):
+	//	CookedFileHeader
+	//	CookedSection[sectionCount]
+	//	sections, each aligned to CookedSectionAlignment
+	struct CookedFileHeader
+	{
+		uint32_t		magic;
+		uint16_t		version;
+		uint16_t		headerSize;		// sizeof(CookedFileHeader)
+		CookedFileType	type;
+		uint32_t		sectionCount;
+		uint64_t		fileSize;
+		uint32_t		reserved[10];
+	};
+	static_assert(sizeof(CookedFileHeader) == 64, "CookedFileHeader must be 64 bytes");
+
+	struct CookedSection
+	{
+		uint32_t		id;				// CookedFourCC
+		uint32_t		elementSize;	// checked against sizeof(T) by GetSection<T>
+		uint64_t		count;
+		uint64_t		offset;			// from the start of the file
+		uint64_t		size;			// elementSize * count
+	};
+	static_assert(sizeof(CookedSection) == 32, "CookedSection must be 32 bytes");
+
+
+	// A mapped cooked file. The sections are used in place: nothing is parsed or copied at load,
+	// the pages are read in when a stream is first touched(uploaded to GL, skinned, sampled).
+	// Owners of views into the file keep the shared_ptr alive.
+	class FE_EXPORT CookedFile
+	{
+	public:
+		// nullptr if the file is missing, is not a cooked file of this type or version, or is truncated
+		static std::shared_ptr<CookedFile> Open(const std::string& path, CookedFileType type);
+
+		CookedFileType GetType() const { return m_header->type; }
+
+		// nullptr if there is no such section
+		const CookedSection* FindSection(uint32_t id) const;
+
+		// empty if there is no such section, or if its elements are not sizeof(T)
+		template<class T>
+		ArrayView<T> GetSection(uint32_t id) const
+		{
+			auto section = FindSection(id);
+			if (section == nullptr || section->elementSize != sizeof(T))
+				return ArrayView<T>();
+			return ArrayView<T>(reinterpret_cast<const T*>(m_file.GetData() + section->offset), static_cast<size_t>(section->count));
+		}
+
+		// the struct written by CookedFileWriter::AddValue, nullptr if missing
+		template<class T>
+		const T* GetValue(uint32_t id) const
+		{
+			auto view = GetSection<T>(id);
+			return view.size == 1 ? view.data : nullptr;
+		}
+
+	private:
+		MappedFile				m_file;
+		const CookedFileHeader*	m_header = nullptr;
+		const CookedSection*	m_sections = nullptr;
+	};
+
+
+	// Collects sections(copied, cooking is offline) and writes them as a CookedFile.
+	class FE_EXPORT CookedFileWriter
+	{
+	public:
+		explicit CookedFileWriter(CookedFileType type) : m_type(type) {}
+
+		void AddSection(uint32_t id, const void* data, uint32_t elementSize, size_t count);
+
+		template<class T>
+		void AddSection(uint32_t id, ArrayView<T> view)
+		{
+			AddSection(id, view.data, sizeof(T), view.size);
+		}
+
+		template<class T>
+		void AddSection(uint32_t id, const std::vector<T>& v)
+		{
+			AddSection(id, v.data(), sizeof(T), v.size());
+		}
+
+		// a section of one struct
+		template<class T>
+		void AddValue(uint32_t id, const T& value)
+		{
+			AddSection(id, &value, sizeof(T), 1);
+		}
+
+		bool Write(const std::string& path) const;
+
+	private:
+		struct Section
+		{
+			uint32_t				id;
+			uint32_t				elementSize;
+			size_t					count;
+			std::vector<uint8_t>	bytes;
+		};
+
+		CookedFileType			m_type;
+		std::vector<Section>	m_sections;
+	};
+}
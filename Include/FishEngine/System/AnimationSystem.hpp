@@ -1,7 +1,13 @@
 #pragma once
 
+#include "../Animation/AnimationLOD.hpp"
+
 namespace FishEngine
 {
+	class Animation;
+	class Camera;
+	struct FrustumPlanes;
+
 	class AnimationSystem
 	{
 	public:
@@ -14,10 +20,25 @@ namespace FishEngine
 
 		//void Init();
 		void Start();
+		// Prepare all Animations and choose their LOD, sample their poses in parallel,
+		// then apply them to the transforms.
 		void Update();
 		//void Clean();
 
+		// characters per sampling job
+		static constexpr int s_SampleGrainSize = 4;
+
+		AnimationLODSettings& GetLODSettings() { return m_LODSettings; }
+		const AnimationLODStats& GetLODStats() const { return m_LODStats; }
+
+		// LOD of animation seen by camera(nullptr: Full), from the screen size of its bounding sphere.
+		// frustum: the planes of camera, built once per frame by the caller.
+		AnimationLOD ComputeLOD(const Animation* animation, const Camera* camera, const FrustumPlanes& frustum) const;
+
 	private:
 		AnimationSystem() = default;
+
+		AnimationLODSettings	m_LODSettings;
+		AnimationLODStats		m_LODStats;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <FishEngine/FishEngine.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FishEngine
+{
+	struct Job;
+
+	// Jobs are owned by the JobSystem and recycled from a per-thread ring buffer.
+	// A handle stays valid until Wait() on it returns(or the job is known to be finished).
+	// A slot is only recycled once its previous job has finished; if MaxJobsPerThread jobs of
+	// the submitting thread are still in flight, CreateJob runs other jobs until the oldest one is done.
+	typedef Job* JobHandle;
+
+	struct Job
+	{
+		std::function<void()>	function;
+		Job*					parent = nullptr;
+
+		// 1 for the job itself + 1 per unfinished child
+		std::atomic<int>		unfinished {0};
+
+		// 1 for Run() + 1 per unfinished dependency; the job is queued when this reaches 0
+		std::atomic<int>		pending {0};
+
+		static constexpr int MaxContinuations = 8;
+		Job*					continuations[MaxContinuations];
+		std::atomic<int>		continuationCount {0};
+	};
+
+
+	// Work-stealing job system.
+	// Thread 0 is the main thread; worker threads 1..N-1 each own a deque. Owners push and pop at
+	// the back, idle threads steal from the front of other deques. Jobs submitted from the main
+	// thread go to the main thread's deque and are stolen by workers.
+	// Threads not created by the JobSystem(foreign threads) share one extra deque and job pool,
+	// the pool is locked, so they may submit and wait on jobs too.
+	// GL is only current on the main thread, so GL work must go through RunOnMainThread.
+	class FE_EXPORT JobSystem
+	{
+	public:
+
+		static JobSystem& GetInstance()
+		{
+			static JobSystem instance;
+			return instance;
+		}
+
+		static constexpr int MaxJobsPerThread = 4096;
+
+		// threadCount includes the main thread, 0 means std::thread::hardware_concurrency()
+		void Init(int threadCount = 0);
+		void Clean();
+
+		// 1 before Init(every job runs inline on the calling thread)
+		int GetThreadCount() const { return m_ThreadCount; }
+
+		// index of the calling thread, 0 for the main thread(the one that called Init), -1 for foreign threads
+		static int GetThreadIndex() { return s_ThreadIndex; }
+
+		// the job is not queued until Run() is called on it
+		JobHandle CreateJob(std::function<void()> function);
+
+		// parent is not finished until all its children are finished
+		JobHandle CreateChildJob(JobHandle parent, std::function<void()> function);
+
+		// continuation is queued only after ancestor has finished. Call before Run(ancestor).
+		void AddDependency(JobHandle ancestor, JobHandle continuation);
+
+		void Run(JobHandle job);
+
+		// executes other jobs while waiting
+		void Wait(JobHandle job);
+
+		bool IsFinished(JobHandle job) const
+		{
+			return job->unfinished.load(std::memory_order_acquire) == 0;
+		}
+
+		// body(first, last) over [begin, end) split into chunks of at least grainSize indices.
+		// Returns after every chunk has finished.
+		void ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+
+		// f is executed on the main thread by the next ExecuteMainThreadJobs()
+		void RunOnMainThread(std::function<void()> f);
+
+		// called once per frame by the main loop
+		void ExecuteMainThreadJobs();
+
+	private:
+		JobSystem() = default;
+
+		struct WorkQueue
+		{
+			std::mutex			mutex;
+			std::deque<Job*>	jobs;
+		};
+
+		// queue and job pool of the calling thread, foreign threads share the last one
+		int GetQueueIndex() const { return s_ThreadIndex >= 0 ? s_ThreadIndex : m_ThreadCount; }
+
+		Job* AllocateJob();
+		void Push(Job* job);
+		Job* GetJob();
+		void Execute(Job* job);
+		void Finish(Job* job);
+		void WorkerMain(int index);
+
+		int								m_ThreadCount = 1;
+		std::vector<std::thread>		m_Workers;
+		std::vector<WorkQueue*>			m_Queues;
+		std::vector<Job*>				m_JobPools;
+		std::vector<uint32_t>			m_JobPoolHeads;
+		std::mutex						m_ForeignPoolMutex;		// guards the head of the foreign threads' pool
+
+		std::atomic<int>				m_QueuedJobs {0};
+		std::atomic<int>				m_SleepingWorkers {0};
+		std::atomic<bool>				m_Quit {false};
+		std::mutex						m_SleepMutex;
+		std::condition_variable			m_WakeUp;
+
+		std::mutex						m_MainThreadMutex;
+		std::vector<std::function<void()>>	m_MainThreadJobs;
+		std::vector<std::function<void()>>	m_MainThreadJobsExecuting;
+
+		static thread_local int			s_ThreadIndex;
+	};
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <vector>
+#include <FishEngine/Math/Bounds.hpp>
+#include <FishEngine/Render/Culling.hpp>
+#include <FishEngine/Render/RenderSorter.hpp>
+#include <FishEngine/Render/InstanceBatcher.hpp>
 
 namespace FishEngine
 {
@@ -15,6 +19,8 @@ namespace FishEngine
 	class Mesh;
 	class Material;
 	class Renderer;
+	class Camera;
+	class Light;
 
 	struct RenderObject
 	{
@@ -22,6 +28,7 @@ namespace FishEngine
 		Renderer*	renderer;
 		Mesh*		mesh;
 		Material*	material;
+		Bounds		bounds;		// world space
 
 		RenderObject(GameObject* gameObject,
 				Renderer*	renderer,
@@ -45,14 +52,47 @@ namespace FishEngine
 		}
 		
 		void Update();
+
+		// state changes of the last frame
+		const RenderStats& GetStats() const { return m_Stats; }
 		
 	private:
 		RenderSystem();
 
 		void GetRenderObjects();
 
+		// fill the visible lists of each pass
+		void Cull(Camera* camera);
+		void CullShadowCasters(Light* light);
+
+		// sort m_VisibleObjects by render queue, state and depth
+		void SortVisibleObjects(Camera* camera);
+
+		// draw m_VisibleObjects, skip redundant shader and VAO binds,
+		// objects sharing mesh and material are drawn with one instanced call
+		void SubmitVisibleObjects();
+
 		std::vector<RenderObject> m_RenderObjects;
 
+		// world space bounds of m_RenderObjects, SoA layout for the culling kernels
+		BoundsCache m_BoundsCache;
+		std::vector<uint32_t> m_VisibilityMask;
+
+		// indices into m_RenderObjects
+		std::vector<int> m_VisibleObjects;		// depth pass & main pass
+		std::vector<int> m_CascadeCasters[4];	// shadow casters of each cascade
+		std::vector<int> m_ShadowCasters;		// casters of any cascade
+		std::vector<uint32_t> m_CasterMask;		// CullShadowCasters scratch, kept between frames
+		std::vector<uint32_t> m_AnyCascadeMask;
+
+		std::vector<uint64_t> m_SortKeys;
+		std::vector<uint64_t> m_SortTempKeys;	// radix sort scratch, kept between frames
+		std::vector<int> m_SortTempValues;
+		RenderStats m_Stats;
+
+		// reused by every pass
+		InstanceBatcher m_Batcher;
+
 		RenderTarget* m_MainRenderTarget;
 		ColorBuffer*  m_MainColorBuffer;
 		DepthBuffer* m_MainDepthBuffer;
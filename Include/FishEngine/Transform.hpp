@@ -6,10 +6,14 @@
 #include "Math/Matrix4x4.hpp"
 
 #include <vector>
+#include <cstdint>
+#include <atomic>
 
 namespace FishEngine
 {
-	class Transform : public Component
+	class TransformHierarchy;
+
+	class Transform final : public Component
 	{
 		friend class GameObject;
 	public:
@@ -156,6 +160,15 @@ namespace FishEngine
 			m_LocalScale.x = m_LocalScale.y = m_LocalScale.z = scale;
 			MakeDirty();
 		}
+
+		// local position, rotation and scale at once, marks the hierarchy dirty only once
+		void SetLocalTRS(const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+		{
+			m_LocalPosition = position;
+			m_LocalRotation = rotation;
+			m_LocalScale = scale;
+			MakeDirty();
+		}
 		
 		// The global scale of the object(Read Only).
 		Vector3 GetLossyScale()
@@ -254,6 +267,7 @@ namespace FishEngine
 	protected:
 		friend class GameObject;
 		friend class Scene;
+		friend class TransformHierarchy;
 		
 		Quaternion m_LocalRotation {0, 0, 0, 1};
 		Vector3 m_LocalPosition {0, 0, 0};
@@ -266,7 +280,27 @@ namespace FishEngine
 		mutable bool m_IsDirty = true;
 		mutable Matrix4x4 m_LocalToWorldMatrix;
 //		mutable Matrix4x4 m_worldToLocalMatrix;
+
+		// bumped every time m_LocalToWorldMatrix is recomputed;
+		// the matrix is stale when m_ParentVersion != m_Father->m_Version
+		mutable uint32_t m_Version = 0;
+		mutable uint32_t m_ParentVersion = 0;
+
+		// s_ChangeVersion when this matrix and all its ancestors were last known to be up to date.
+		// UpdateMatrix returns at once while it matches, instead of walking up the parent chain.
+		mutable uint32_t m_CheckedVersion = 0;
+
+		// bumped by every MakeDirty of any transform
+		static std::atomic<uint32_t> s_ChangeVersion;
+
+		// slot in the scene's TransformHierarchy, set when it is rebuilt
+		TransformHierarchy* m_Hierarchy = nullptr;
+		int m_HierarchyIndex = -1;
 		
+		// O(1), descendants are not touched
 		void MakeDirty() const;
+
+		// SetParent without notifying RendererRegistry(used when destroying)
+		void SetParentImpl(Transform* parent, bool worldPositionStays);
 	};
 }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FishEngine.hpp"
+#include "Math/Matrix4x4.hpp"
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace FishEngine
+{
+	class Transform;
+
+	// Transforms of one scene flattened in parent-before-child(depth-first) order.
+	// Parent indices, dirty flags and world matrices are kept in parallel arrays, so
+	// UpdateWorldMatrices is a single forward sweep without recursion or pointer chasing.
+	// Every root subtree occupies a contiguous range, so ranges of different roots can be swept in parallel.
+	class FE_EXPORT TransformHierarchy
+	{
+	public:
+		// Any change of parent/children/sibling order anywhere. The flattened order is rebuilt lazily.
+		// Thread safe, transforms are deserialized in parallel.
+		static void SetStructureDirty()
+		{
+			s_StructureVersion.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Local TRS of the transform at index changed. O(1), descendants are resolved by the sweep.
+		void SetDirty(int index)
+		{
+			if (m_StructureVersion != s_StructureVersion.load(std::memory_order_relaxed) || index < 0 || index >= size())
+				return;
+			m_Dirty[index] = 1;
+			m_RootDirty[m_RootOf[index]] = 1;
+		}
+
+		// Recompute the world matrices of dirty transforms and their descendants.
+		// Dirty root subtrees are partitioned across worker threads when there is enough work;
+		// all workers are joined before returning, so callers only ever see finished matrices.
+		void UpdateWorldMatrices(const std::vector<Transform*>& roots);
+
+		int size() const { return static_cast<int>(m_Transforms.size()); }
+
+		const std::vector<Transform*>& GetTransforms() const { return m_Transforms; }
+
+		// index of the parent in GetTransforms(), -1 for roots
+		const std::vector<int>& GetParentIndices() const { return m_Parent; }
+
+		const std::vector<Matrix4x4>& GetLocalToWorldMatrices() const { return m_LocalToWorld; }
+
+		// below this many transforms to update, the sweep stays on the calling thread
+		static int s_ParallelThreshold;
+
+	private:
+		void Rebuild(const std::vector<Transform*>& roots);
+
+		// sweep the transforms of the dirty roots m_DirtyRoots[first, last)
+		void UpdateRoots(int first, int last);
+
+		std::vector<Transform*>	m_Transforms;
+		std::vector<int>		m_Parent;
+		std::vector<int>		m_RootOf;		// index into m_RootBegin
+		std::vector<uint8_t>	m_Dirty;
+		std::vector<Matrix4x4>	m_LocalToWorld;
+
+		// root r owns [m_RootBegin[r], m_RootBegin[r+1])
+		std::vector<int>		m_RootBegin;
+		std::vector<uint8_t>	m_RootDirty;
+		std::vector<int>		m_DirtyRoots;	// scratch, rebuilt every update
+
+		uint32_t				m_StructureVersion = 0;
+
+		static std::atomic<uint32_t>	s_StructureVersion;
+	};
+}
@@ -9,6 +9,8 @@
 #include <FishEngine/Render/Shader.hpp>
 #include <FishEditor/ModelImporter.hpp>
 #include <FishEditor/Serialization/NativeFormatImporter.hpp>
+#include <FishEditor/Serialization/AssetCooker.hpp>
+#include <FishEditor/Path.hpp>
 
 #include <FishEngine/Prefab.hpp>
 #include <FishEngine/Debug.hpp>
@@ -93,8 +95,23 @@ namespace FishEditor
 				auto name = p.second;
 				int fileID = p.first;
 				auto path = FishEngine::Format(modelsRootDir, name);
-				auto str = ReadFileAsString(path);
-				FishEngine::Mesh *mesh = FishEngine::Mesh::FromTextFile(str);
+
+				// the cooked mesh is mapped and used in place, the text file is parsed(and cooked) only
+				// when it changed
+				auto cookedKey = FishEngine::Format("{}.{}", guid, fileID);
+				auto cookedPath = AssetCooker::GetCookedPath(cookedKey);
+				FishEngine::Mesh *mesh = nullptr;
+				if (AssetCooker::IsCookedFileUpToDate(cookedPath, {path}))
+					mesh = FishEngine::Mesh::FromCookedFile(cookedPath);
+				if (mesh == nullptr)
+				{
+					auto str = ReadFileAsString(path);
+					mesh = FishEngine::Mesh::FromTextFile(str);
+					boost::system::error_code ec;
+					fs::create_directories(fs::path(cookedPath).parent_path(), ec);
+					if (ec || !mesh->SaveCooked(cookedPath))
+						LogWarning(FishEngine::Format("can not cook {}", path));
+				}
 				mesh->SetLocalIdentifierInFile(fileID);
 				importer->m_FileIDToObject[fileID] = mesh;
 				//prefab->AddObject(fileID, mesh);
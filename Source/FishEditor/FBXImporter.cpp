@@ -1,4 +1,6 @@
 #include <FishEditor/FBXImporter.hpp>
+#include <FishEditor/Serialization/AssetCooker.hpp>
+#include <FishEditor/Path.hpp>
 
 #include <FishEngine/Debug.hpp>
 #include <FishEngine/GameObject.hpp>
@@ -999,6 +1001,26 @@ AnimationClip* FishEditor::FBXImporter::ConvertAnimationClip(const FBXAnimationC
 		if (animation.scale.keyframeCount() > 0)
 			result->m_scaleCurves.emplace_back(Vector3Curve{ path, animation.scale });
 	}
+	auto sampledReport = result->BuildSampledClip();
+	LogInfo(Format("AnimationClip [{}]: {} frames at {} fps, resample error: position {}, rotation {} deg, scale {}",
+		fbxClip.name, result->m_sampledClip.GetFrameCount(), result->m_sampledClip.GetSampleRate(),
+		sampledReport.maxPositionError, sampledReport.maxRotationError, sampledReport.maxScaleError));
+
+	if (m_animationCompression != ModelImporterAnimationCompression::Off)
+	{
+		CompressedAnimationClip::Settings settings;
+		settings.positionError = m_animationPositionError;
+		settings.rotationError = m_animationRotationError;
+		settings.scaleError = m_animationScaleError;
+		auto report = result->Compress(settings);
+		LogInfo(Format("AnimationClip [{}]: {} tracks, {} -> {} keys, {} -> {} bytes, max error: position {}, rotation {} deg, scale {}",
+			fbxClip.name, report.trackCount, report.sourceKeyCount, report.keyCount,
+			report.sourceBytes, report.compressedBytes,
+			report.maxPositionError, report.maxRotationError, report.maxScaleError));
+		// only 16 bit quantization of a very large range can exceed the bound
+		if (report.maxPositionError > settings.positionError || report.maxScaleError > settings.scaleError)
+			LogWarning(Format("AnimationClip [{}]: compression error exceeds the import settings", fbxClip.name));
+	}
 	return result;
 }
 
@@ -1006,14 +1028,45 @@ AnimationClip* FishEditor::FBXImporter::ConvertAnimationClip(const FBXAnimationC
 void FishEditor::FBXImporter::ImportAnimations(fbxsdk::FbxScene* scene)
 {
 	FbxNode * root = scene->GetRootNode();
+	const auto fullpath = this->GetFullPath();
+
+	auto GetClipFileID = [this](const std::string& name) -> uint32_t {
+		for (auto&& p : m_FileIDToRecycleName)
+		{
+			if (p.first / 100000 == AnimationClip::ClassID && p.second == name)
+				return p.first;
+		}
+		return 0;
+	};
+
 	int numAnimStacks = scene->GetSrcObjectCount<FbxAnimStack>();
 	for (int i = 0; i < numAnimStacks; ++i)
 	{
 		FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(i);
-		
+
+		// the built clip is cooked, and used while the model and its import settings(.meta) are not modified.
+		// Clips without a fileID yet(first import) are not cooked.
+		const std::string name = animStack->GetName();
+		const auto fileID = GetClipFileID(name);
+		std::string cookedPath;
+		if (fileID != 0)
+		{
+			cookedPath = AssetCooker::GetCookedPath(Format("{}.{}", GetGUID(), fileID));
+			if (AssetCooker::IsCookedFileUpToDate(cookedPath, {fullpath, fullpath + ".meta"}))
+			{
+				auto animationClip = AnimationClip::FromCookedFile(cookedPath, m_FileIDToObject);
+				if (animationClip != nullptr)
+				{
+					animationClip->SetLocalIdentifierInFile(fileID);
+					m_model.m_animationClips.push_back(animationClip);
+					continue;
+				}
+			}
+		}
+
 		m_model.m_clips.emplace_back();
 		auto & clip = m_model.m_clips.back();
-		clip.name = animStack->GetName();
+		clip.name = name;
 		FbxTimeSpan timeSpan = animStack->GetLocalTimeSpan();
 		clip.start = (float)timeSpan.GetStart().GetSecondDouble();
 		clip.end = (float)timeSpan.GetStop().GetSecondDouble();
@@ -1028,17 +1081,21 @@ void FishEditor::FBXImporter::ImportAnimations(fbxsdk::FbxScene* scene)
 		else
 		{
 			//abort();
-			LogError(Format("multiple animation clip in model: %{}", this->GetFullPath()));
+			LogError(Format("multiple animation clip in model: %{}", fullpath));
 		}
-	}
-	
-	for (auto clip : m_model.m_clips)
-	{
+
 		auto animationClip = ConvertAnimationClip(clip);
-		if (animationClip != nullptr)
+		if (animationClip == nullptr)
+			continue;
+		m_model.m_animationClips.push_back(animationClip);
+		animationClip->m_avatar = m_model.m_avatar;
+		if (fileID != 0)
 		{
-			m_model.m_animationClips.push_back(animationClip);
-			animationClip->m_avatar = m_model.m_avatar;
+			animationClip->SetLocalIdentifierInFile(fileID);
+			boost::system::error_code ec;
+			fs::create_directories(fs::path(cookedPath).parent_path(), ec);
+			if (ec || !animationClip->SaveCooked(cookedPath))
+				LogWarning(Format("can not cook AnimationClip [{}] of {}", name, fullpath));
 		}
 	}
 }
@@ -1277,6 +1334,9 @@ void FishEditor::FBXImporter::Import()
 	}
 
 	m_model.m_avatar = new Avatar;
+	// registered before the animations are imported: cooked clips look their avatar up by fileID
+	m_model.m_avatar->SetLocalIdentifierInFile(Avatar::ClassID * 100000);
+	m_FileIDToObject[Avatar::ClassID * 100000] = m_model.m_avatar;
 	
 	FbxGeometryConverter converter(lSdkManager);
 	converter.Triangulate(lScene, true);
@@ -1421,7 +1481,7 @@ void FishEditor::FBXImporter::Import()
 	{
 		auto animation = new Animation;
 		root->AddComponent(animation);
-		animation->m_clip = m_model.m_animationClips.front();
+		animation->SetClip(m_model.m_animationClips.front());
 	}
 	
 	std::map<int, std::map<std::string, uint32_t>> recycleNameToFileID;
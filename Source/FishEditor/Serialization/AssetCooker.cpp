@@ -0,0 +1,196 @@
+#include <FishEditor/Serialization/AssetCooker.hpp>
+#include <FishEditor/Serialization/BinaryArchive.hpp>
+#include <FishEditor/AssetDatabase.hpp>
+#include <FishEditor/Path.hpp>
+
+#include <FishEngine/Application.hpp>
+#include <FishEngine/Debug.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace FishEngine;
+
+namespace
+{
+	constexpr uint32_t DependencyMagic = 0x50444546;	// "FEDP"
+
+	struct Dependency
+	{
+		std::string		guid;
+		int64_t			writeTime;
+	};
+
+	// little endian, like the archive
+	void WriteInt(std::ostream& os, uint64_t v, int bytes)
+	{
+		for (int i = 0; i < bytes; ++i)
+			os.put(static_cast<char>(v >> (i * 8)));
+	}
+
+	bool ReadInt(std::istream& is, uint64_t& v, int bytes)
+	{
+		v = 0;
+		for (int i = 0; i < bytes; ++i)
+		{
+			int c = is.get();
+			if (c == std::char_traits<char>::eof())
+				return false;
+			v |= static_cast<uint64_t>(c) << (i * 8);
+		}
+		return true;
+	}
+
+	// the file of an asset, empty if the guid is not an asset of the project(built-in meshes and materials)
+	std::string GetAssetFullPath(const std::string& guid)
+	{
+		auto assetPath = FishEditor::AssetDatabase::GUIDToAssetPath(guid);
+		if (assetPath.empty())
+			return "";
+		fs::path p(Application::GetInstance().GetDataPath());
+		p = p.parent_path();
+		p.append(assetPath);
+		return p.string();
+	}
+
+	// dependency table at the start of a cooked file, is is left at the archive
+	bool ReadDependencies(std::istream& is, std::vector<Dependency>& dependencies)
+	{
+		uint64_t magic, count;
+		if (!ReadInt(is, magic, 4) || magic != DependencyMagic || !ReadInt(is, count, 4))
+			return false;
+		dependencies.clear();
+		for (uint64_t i = 0; i < count; ++i)
+		{
+			uint64_t length, writeTime;
+			if (!ReadInt(is, length, 4) || length > 256)
+				return false;
+			Dependency d;
+			d.guid.resize(static_cast<size_t>(length));
+			if (!is.read(&d.guid[0], length) || !ReadInt(is, writeTime, 8))
+				return false;
+			d.writeTime = static_cast<int64_t>(writeTime);
+			dependencies.push_back(std::move(d));
+		}
+		return true;
+	}
+}
+
+namespace FishEditor
+{
+	std::string AssetCooker::GetCookedPath(const std::string& guid)
+	{
+		fs::path p(Application::GetInstance().GetDataPath());
+		p = p.parent_path();
+		p.append("Library");
+		p.append("Cooked");
+		p.append(guid + ".bin");
+		return p.string();
+	}
+
+	bool AssetCooker::IsCookedFileUpToDate(const std::string& cookedPath, const std::vector<std::string>& sourcePaths)
+	{
+		boost::system::error_code ec;
+		if (!fs::exists(cookedPath, ec))
+			return false;
+		auto cookedTime = fs::last_write_time(cookedPath, ec);
+		if (ec)
+			return false;
+		for (auto&& path : sourcePaths)
+		{
+			auto sourceTime = fs::last_write_time(path, ec);
+			if (ec || cookedTime < sourceTime)
+				return false;
+		}
+		return true;
+	}
+
+	bool AssetCooker::IsUpToDate(const std::string& fullPath, const std::string& guid)
+	{
+		auto cookedPath = GetCookedPath(guid);
+		if (!IsCookedFileUpToDate(cookedPath, {fullPath}))
+			return false;
+
+		boost::system::error_code ec;
+		std::ifstream is(cookedPath, std::ios::binary);
+		std::vector<Dependency> dependencies;
+		if (!ReadDependencies(is, dependencies))
+			return false;
+		for (auto&& d : dependencies)
+		{
+			// the exact time: an asset reverted to an older file changed too
+			auto path = GetAssetFullPath(d.guid);
+			if (path.empty())
+				return false;
+			auto writeTime = fs::last_write_time(path, ec);
+			if (ec || static_cast<int64_t>(writeTime) != d.writeTime)
+				return false;
+		}
+		return true;
+	}
+
+	std::string AssetCooker::ReadCookedFile(const std::string& guid)
+	{
+		std::ifstream is(GetCookedPath(guid), std::ios::binary);
+		std::vector<Dependency> dependencies;
+		if (!is || !ReadDependencies(is, dependencies))
+			return "";
+		std::stringstream buffer;
+		buffer << is.rdbuf();
+		return buffer.str();
+	}
+
+	bool AssetCooker::Cook(const std::vector<Object*>& objects, const std::map<int64_t, Object*>& fileIDToObject, const std::string& guid)
+	{
+		auto cookedPath = GetCookedPath(guid);
+		boost::system::error_code ec;
+		fs::create_directories(fs::path(cookedPath).parent_path(), ec);
+		if (ec)
+		{
+			LogWarning(Format("Cook: can not create the directory of {}", cookedPath));
+			return false;
+		}
+
+		std::ostringstream buffer;
+		BinaryOutputArchive archive(buffer);
+		archive.Dump(objects, fileIDToObject, guid);
+
+		std::vector<Dependency> dependencies;
+		for (auto&& dependency : archive.GetExternalGUIDs())
+		{
+			auto path = GetAssetFullPath(dependency);
+			if (path.empty())
+				continue;
+			auto writeTime = fs::last_write_time(path, ec);
+			if (ec)
+			{
+				LogWarning(Format("Cook: can not get the write time of {}", path));
+				return false;
+			}
+			dependencies.push_back({dependency, static_cast<int64_t>(writeTime)});
+		}
+
+		// write to a temp file first, a half written file would be newer than the asset
+		auto tempPath = cookedPath + ".tmp";
+		{
+			std::ofstream fout(tempPath, std::ios::binary);
+			if (!fout)
+			{
+				LogWarning(Format("Cook: can not write {}", tempPath));
+				return false;
+			}
+			WriteInt(fout, DependencyMagic, 4);
+			WriteInt(fout, dependencies.size(), 4);
+			for (auto&& d : dependencies)
+			{
+				WriteInt(fout, d.guid.size(), 4);
+				fout.write(d.guid.data(), d.guid.size());
+				WriteInt(fout, static_cast<uint64_t>(d.writeTime), 8);
+			}
+			auto data = buffer.str();
+			fout.write(data.data(), data.size());
+		}
+		fs::rename(tempPath, cookedPath, ec);
+		return !ec;
+	}
+}
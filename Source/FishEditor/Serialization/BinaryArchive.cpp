@@ -0,0 +1,869 @@
+#include <FishEditor/Serialization/BinaryArchive.hpp>
+
+#include <FishEditor/AssetDatabase.hpp>
+#include <FishEditor/AssetImporter.hpp>
+#if _WIN32
+#	undef GetClassName
+#endif
+
+#include <FishEngine/CreateObject.hpp>
+
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+	inline uint64_t ZigZagEncode(int64_t v)
+	{
+		return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+	}
+
+	inline int64_t ZigZagDecode(uint64_t v)
+	{
+		return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+	}
+
+	void PutVarint(std::vector<uint8_t>& out, uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(v | 0x80));
+			v >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(v));
+	}
+
+	void PutUInt32(std::vector<uint8_t>& out, uint32_t v)
+	{
+		for (int i = 0; i < 4; ++i)
+			out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+	}
+
+	void PatchUInt32(std::vector<uint8_t>& out, uint32_t pos, uint32_t v)
+	{
+		for (int i = 0; i < 4; ++i)
+			out[pos + i] = static_cast<uint8_t>(v >> (i * 8));
+	}
+
+	void PutString(std::vector<uint8_t>& out, const std::string& s)
+	{
+		PutVarint(out, s.size());
+		out.insert(out.end(), s.begin(), s.end());
+	}
+
+	void PutBytes(std::vector<uint8_t>& out, const void* data, size_t size)
+	{
+		auto p = static_cast<const uint8_t*>(data);
+		out.insert(out.end(), p, p + size);
+	}
+
+	constexpr uint32_t InvalidPos = ~0u;
+
+	// FNV-1a
+	uint32_t Checksum(const uint8_t* data, size_t size, uint32_t hash = 2166136261u)
+	{
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ data[i]) * 16777619u;
+		return hash;
+	}
+
+	// nested Maps/Sequences deeper than this are treated as a corrupt file
+	constexpr int MaxValueDepth = 256;
+
+	// Bounds checked reads for the header and CheckValue: false if the value does not fit before end.
+
+	bool GetByte(const uint8_t* data, uint32_t& pos, uint32_t end, uint8_t& v)
+	{
+		if (pos >= end)
+			return false;
+		v = data[pos++];
+		return true;
+	}
+
+	bool Advance(uint32_t& pos, uint32_t end, uint64_t size)
+	{
+		if (pos > end || size > end - pos)
+			return false;
+		pos += static_cast<uint32_t>(size);
+		return true;
+	}
+
+	bool GetUInt32(const uint8_t* data, uint32_t& pos, uint32_t end, uint32_t& v)
+	{
+		uint32_t p = pos;
+		if (!Advance(p, end, 4))
+			return false;
+		v = 0;
+		for (int i = 0; i < 4; ++i)
+			v |= static_cast<uint32_t>(data[pos + i]) << (i * 8);
+		pos = p;
+		return true;
+	}
+
+	bool GetVarint(const uint8_t* data, uint32_t& pos, uint32_t end, uint64_t& v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			uint8_t b;
+			if (!GetByte(data, pos, end, b))
+				return false;
+			v |= static_cast<uint64_t>(b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	bool GetString(const uint8_t* data, uint32_t& pos, uint32_t end, std::string& s)
+	{
+		uint64_t length;
+		uint32_t begin;
+		if (!GetVarint(data, pos, end, length))
+			return false;
+		begin = pos;
+		if (!Advance(pos, end, length))
+			return false;
+		s.assign(reinterpret_cast<const char*>(data + begin), static_cast<size_t>(length));
+		return true;
+	}
+}
+
+
+namespace FishEditor
+{
+	// BinaryInputArchive
+
+	// The readers below do not check bounds: LoadAllFromBuffer runs CheckValue on every object first,
+	// so the values read while deserializing are known to fit in the payload.
+
+	uint8_t BinaryInputArchive::ReadByte(uint32_t& pos) const
+	{
+		assert(pos < m_size);
+		return m_data[pos++];
+	}
+
+	uint32_t BinaryInputArchive::ReadUInt32(uint32_t& pos) const
+	{
+		assert(pos + 4 <= m_size);
+		uint32_t v = 0;
+		for (int i = 0; i < 4; ++i)
+			v |= static_cast<uint32_t>(m_data[pos + i]) << (i * 8);
+		pos += 4;
+		return v;
+	}
+
+	uint64_t BinaryInputArchive::ReadVarint(uint32_t& pos) const
+	{
+		uint64_t v = 0;
+		for (int shift = 0; ; shift += 7)
+		{
+			uint8_t b = ReadByte(pos);
+			v |= static_cast<uint64_t>(b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+				break;
+		}
+		return v;
+	}
+
+	uint32_t BinaryInputArchive::SkipValue(uint32_t pos) const
+	{
+		auto tag = static_cast<BinaryTag>(ReadByte(pos));
+		switch (tag)
+		{
+		case BinaryTag::Int:
+		case BinaryTag::UInt:
+		case BinaryTag::Object:
+			ReadVarint(pos);
+			return pos;
+		case BinaryTag::Float:
+			return pos + 4;
+		case BinaryTag::Double:
+			return pos + 8;
+		case BinaryTag::Bool:
+			return pos + 1;
+		case BinaryTag::String:
+		{
+			auto length = ReadVarint(pos);
+			return pos + static_cast<uint32_t>(length);
+		}
+		case BinaryTag::ExternalObject:
+			ReadVarint(pos);
+			ReadVarint(pos);
+			return pos;
+		case BinaryTag::Sequence:
+		case BinaryTag::Map:
+		{
+			auto size = ReadUInt32(pos);
+			return pos + size;
+		}
+		default:
+			return pos;
+		}
+	}
+
+	bool BinaryInputArchive::CheckValue(uint32_t& pos, uint32_t end, const ClassTable& table, int depth) const
+	{
+		uint8_t tag;
+		uint64_t v;
+		if (depth > MaxValueDepth || !GetByte(m_data, pos, end, tag))
+			return false;
+		switch (static_cast<BinaryTag>(tag))
+		{
+		case BinaryTag::Null:
+			return true;
+		case BinaryTag::Int:
+		case BinaryTag::UInt:
+			return GetVarint(m_data, pos, end, v);
+		case BinaryTag::Float:
+			return Advance(pos, end, 4);
+		case BinaryTag::Double:
+			return Advance(pos, end, 8);
+		case BinaryTag::Bool:
+			return Advance(pos, end, 1);
+		case BinaryTag::String:
+			return GetVarint(m_data, pos, end, v) && Advance(pos, end, v);
+		case BinaryTag::Object:
+			return GetVarint(m_data, pos, end, v) && v < m_objects.size();
+		case BinaryTag::ExternalObject:
+			return GetVarint(m_data, pos, end, v) && GetVarint(m_data, pos, end, v) && v < m_guids.size();
+		case BinaryTag::Sequence:
+		case BinaryTag::Map:
+		{
+			uint32_t size, count;
+			if (!GetUInt32(m_data, pos, end, size))
+				return false;
+			uint32_t containerEnd = pos;
+			if (!Advance(containerEnd, end, size) || !GetUInt32(m_data, pos, containerEnd, count))
+				return false;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (static_cast<BinaryTag>(tag) == BinaryTag::Map &&
+					(!GetVarint(m_data, pos, containerEnd, v) || v >= table.fields.size()))
+					return false;
+				if (!CheckValue(pos, containerEnd, table, depth + 1))
+					return false;
+			}
+			return pos == containerEnd;
+		}
+		default:
+			return false;
+		}
+	}
+
+	BinaryInputArchive::Cursor& BinaryInputArchive::OpenContainer(BinaryTag tag)
+	{
+		assert(!m_cursors.empty());
+		auto& c = m_cursors.back();
+		if (c.begin == 0)	// not opened yet, the tag is at c.pos so begin is never 0 once it is
+		{
+			uint32_t p = c.pos;
+			if (static_cast<BinaryTag>(ReadByte(p)) == tag)
+			{
+				auto size = ReadUInt32(p);
+				c.end = p + size;
+				c.count = ReadUInt32(p);
+			}
+			else
+			{
+				// the field changed its type since the file was cooked, read it as empty
+				c.end = p;
+				c.count = 0;
+			}
+			c.begin = p;
+			c.next = p;
+			c.nextIndex = 0;
+		}
+		return c;
+	}
+
+	template<class T>
+	T BinaryInputArchive::ReadNumber()
+	{
+		assert(!m_cursors.empty());
+		auto& c = m_cursors.back();
+		if (c.key != nullptr)
+		{
+			try
+			{
+				if (std::is_floating_point<T>::value)
+					return static_cast<T>(std::stod(*c.key));
+				return static_cast<T>(std::stoll(*c.key));
+			}
+			catch (const std::exception&)
+			{
+				LogWarning(Format("BinaryInputArchive: map key {} is not a number", *c.key));
+				return T();
+			}
+		}
+
+		uint32_t p = c.pos;
+		switch (static_cast<BinaryTag>(ReadByte(p)))
+		{
+		case BinaryTag::Int:
+			return static_cast<T>(ZigZagDecode(ReadVarint(p)));
+		case BinaryTag::UInt:
+			return static_cast<T>(ReadVarint(p));
+		case BinaryTag::Float:
+		{
+			float f;
+			memcpy(&f, m_data + p, sizeof(f));
+			return static_cast<T>(f);
+		}
+		case BinaryTag::Double:
+		{
+			double d;
+			memcpy(&d, m_data + p, sizeof(d));
+			return static_cast<T>(d);
+		}
+		case BinaryTag::Bool:
+			return static_cast<T>(m_data[p]);
+		default:
+			LogWarning("BinaryInputArchive: value is not a number");
+			return T();
+		}
+	}
+
+	void BinaryInputArchive::Deserialize(short & t)					{ t = ReadNumber<short>(); }
+	void BinaryInputArchive::Deserialize(unsigned short & t)		{ t = ReadNumber<unsigned short>(); }
+	void BinaryInputArchive::Deserialize(int & t)					{ t = ReadNumber<int>(); }
+	void BinaryInputArchive::Deserialize(unsigned int & t)			{ t = ReadNumber<unsigned int>(); }
+	void BinaryInputArchive::Deserialize(long & t)					{ t = ReadNumber<long>(); }
+	void BinaryInputArchive::Deserialize(unsigned long & t)			{ t = ReadNumber<unsigned long>(); }
+	void BinaryInputArchive::Deserialize(long long & t)				{ t = ReadNumber<long long>(); }
+	void BinaryInputArchive::Deserialize(unsigned long long & t)	{ t = ReadNumber<unsigned long long>(); }
+	void BinaryInputArchive::Deserialize(float & t)					{ t = ReadNumber<float>(); }
+	void BinaryInputArchive::Deserialize(double & t)				{ t = ReadNumber<double>(); }
+	void BinaryInputArchive::Deserialize(bool & t)					{ t = ReadNumber<int>() != 0; }
+
+	void BinaryInputArchive::Deserialize(std::string & t)
+	{
+		assert(!m_cursors.empty());
+		auto& c = m_cursors.back();
+		if (c.key != nullptr)
+		{
+			t = *c.key;
+			return;
+		}
+
+		uint32_t p = c.pos;
+		if (static_cast<BinaryTag>(ReadByte(p)) == BinaryTag::String)
+		{
+			auto length = static_cast<uint32_t>(ReadVarint(p));
+			t.assign(reinterpret_cast<const char*>(m_data + p), length);
+		}
+		else
+		{
+			t = "";
+		}
+	}
+
+	bool BinaryInputArchive::MapKey(const char* name)
+	{
+		auto& c = OpenContainer(BinaryTag::Map);
+
+		// fields are usually read in the order they were written, so the entry after the last one
+		// found is almost always the one asked for. Wrap around once for the others.
+		for (uint32_t i = 0; i < c.count; ++i)
+		{
+			if (c.nextIndex == c.count)
+			{
+				c.next = c.begin;
+				c.nextIndex = 0;
+			}
+			uint32_t p = c.next;
+			auto field = ReadVarint(p);
+			uint32_t valuePos = p;
+			c.next = SkipValue(p);
+			c.nextIndex++;
+			if (m_class->fields[field] == name)
+			{
+				PushCursor(valuePos);
+				return true;
+			}
+		}
+
+		PushCursor(InvalidPos);
+		return false;
+	}
+
+	int BinaryInputArchive::BeginSequence()
+	{
+		return static_cast<int>(OpenContainer(BinaryTag::Sequence).count);
+	}
+
+	void BinaryInputArchive::BeginSequenceItem()
+	{
+		PushCursor(m_cursors.back().next);
+	}
+
+	void BinaryInputArchive::AfterSequenceItem()
+	{
+		PopCursor();
+		auto& c = m_cursors.back();
+		c.next = SkipValue(c.next);
+		c.nextIndex++;
+	}
+
+	int BinaryInputArchive::BeginMap()
+	{
+		return static_cast<int>(OpenContainer(BinaryTag::Map).count);
+	}
+
+	void BinaryInputArchive::BeginMapKey()
+	{
+		uint32_t p = m_cursors.back().next;
+		auto field = ReadVarint(p);
+		PushCursor(p);
+		m_cursors.back().key = &m_class->fields[field];
+	}
+
+	void BinaryInputArchive::AfterMapKey()
+	{
+		uint32_t valuePos = m_cursors.back().pos;
+		PopCursor();
+		PushCursor(valuePos);
+	}
+
+	void BinaryInputArchive::AfterMapValue()
+	{
+		uint32_t valuePos = m_cursors.back().pos;
+		PopCursor();
+		auto& c = m_cursors.back();
+		c.next = SkipValue(valuePos);
+		c.nextIndex++;
+	}
+
+	Object* BinaryInputArchive::DeserializeObject()
+	{
+		assert(!m_cursors.empty());
+		uint32_t p = m_cursors.back().pos;
+		switch (static_cast<BinaryTag>(ReadByte(p)))
+		{
+		case BinaryTag::Object:
+		{
+			auto index = ReadVarint(p);
+			assert(index < m_objects.size());
+			return m_objects[index];
+		}
+		case BinaryTag::ExternalObject:
+		{
+			int64_t fileID = ZigZagDecode(ReadVarint(p));
+			auto guid = ReadVarint(p);
+			assert(guid < m_guids.size());
+			return AssetDatabase::GetAssetByGUIDAndFileID(m_guids[guid], fileID);
+		}
+		default:
+			return nullptr;
+		}
+	}
+
+	std::vector<Object*> BinaryInputArchive::LoadAllFromBuffer(const char* data, size_t size)
+	{
+		m_data = reinterpret_cast<const uint8_t*>(data);
+		m_size = static_cast<uint32_t>(size);
+
+		uint32_t pos = 0;
+		uint32_t magic = 0;
+		if (size > UINT32_MAX || !GetUInt32(m_data, pos, m_size, magic) || magic != BinaryArchiveMagic)
+		{
+			LogError("BinaryInputArchive: not a cooked file");
+			return {};
+		}
+		uint32_t version = 0;
+		GetUInt32(m_data, pos, m_size, version);
+		if (version != BinaryArchiveVersion)
+		{
+			LogWarning(Format("BinaryInputArchive: version {} is not supported, expected {}", version, BinaryArchiveVersion));
+			return {};
+		}
+
+		auto corrupt = []() {
+			LogError("BinaryInputArchive: corrupt cooked file");
+			return std::vector<Object*>();
+		};
+		uint32_t checksum;
+		if (!GetUInt32(m_data, pos, m_size, checksum) || checksum != Checksum(m_data + pos, m_size - pos))
+			return corrupt();
+
+		// every table entry takes at least one byte, so no count can be larger than the file
+		uint32_t classCount, guidCount, objectCount, fileIDCount;
+		if (!GetUInt32(m_data, pos, m_size, classCount) || !GetUInt32(m_data, pos, m_size, guidCount) ||
+			!GetUInt32(m_data, pos, m_size, objectCount) || !GetUInt32(m_data, pos, m_size, fileIDCount) ||
+			classCount > m_size || guidCount > m_size || objectCount > m_size || fileIDCount > m_size)
+			return corrupt();
+
+		m_classes.resize(classCount);
+		for (auto&& c : m_classes)
+		{
+			uint64_t classID, fieldCount;
+			if (!GetVarint(m_data, pos, m_size, classID) || !GetVarint(m_data, pos, m_size, fieldCount) || fieldCount > m_size)
+				return corrupt();
+			c.classID = static_cast<int>(ZigZagDecode(classID));
+			c.fields.resize(static_cast<size_t>(fieldCount));
+			for (auto&& field : c.fields)
+			{
+				if (!GetString(m_data, pos, m_size, field))
+					return corrupt();
+			}
+		}
+
+		m_guids.resize(guidCount);
+		for (auto&& guid : m_guids)
+		{
+			if (!GetString(m_data, pos, m_size, guid))
+				return corrupt();
+		}
+
+		struct ObjectEntry
+		{
+			uint32_t	classIndex;
+			int64_t		fileID;
+			uint32_t	offset;
+		};
+		std::vector<ObjectEntry> entries(objectCount);
+		for (auto&& e : entries)
+		{
+			uint64_t classIndex, fileID;
+			if (!GetVarint(m_data, pos, m_size, classIndex) || !GetVarint(m_data, pos, m_size, fileID) ||
+				!GetUInt32(m_data, pos, m_size, e.offset) || classIndex >= classCount)
+				return corrupt();
+			e.classIndex = static_cast<uint32_t>(classIndex);
+			e.fileID = ZigZagDecode(fileID);
+		}
+
+		std::vector<std::pair<int64_t, uint32_t>> fileIDs(fileIDCount);
+		for (auto&& f : fileIDs)
+		{
+			uint64_t fileID, index;
+			if (!GetVarint(m_data, pos, m_size, fileID) || !GetVarint(m_data, pos, m_size, index) || index >= objectCount)
+				return corrupt();
+			f.first = ZigZagDecode(fileID);
+			f.second = static_cast<uint32_t>(index);
+		}
+
+		// offsets are relative to the payload
+		m_data += pos;
+		m_size -= pos;
+
+		// check every value before creating anything, a corrupt file then leaves no half loaded objects
+		m_objects.assign(objectCount, nullptr);
+		for (auto&& e : entries)
+		{
+			uint32_t p = e.offset;
+			if (!CheckValue(p, m_size, m_classes[e.classIndex], 0))
+				return corrupt();
+		}
+
+		// create all objects
+		for (uint32_t i = 0; i < objectCount; ++i)
+		{
+			auto&& e = entries[i];
+			int classID = m_classes[e.classIndex].classID;
+			Object* obj = nullptr;
+			if (classID == Prefab::ClassID)
+				obj = CreateEmptyObject<Prefab>();
+			else
+				obj = CreateEmptyObjectByClassID(classID);
+
+			if (obj != nullptr)
+				obj->SetLocalIdentifierInFile(e.fileID);
+			m_objects[i] = obj;
+		}
+		for (auto&& f : fileIDs)
+		{
+			if (m_objects[f.second] != nullptr)
+				m_FileIDToObject[f.first] = m_objects[f.second];
+		}
+
+		// prefab instances are cooked as plain objects, no InstantiateWithModification here.
+		// GameObjects first, like YAMLInputArchive, so that components find their GameObject filled
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				Object* obj = m_objects[i];
+				if (obj == nullptr || (obj->GetClassID() == GameObject::ClassID) != (pass == 0))
+					continue;
+				m_class = &m_classes[entries[i].classIndex];
+				m_cursors.clear();
+				PushCursor(entries[i].offset);
+				obj->Deserialize(*this);
+				PopCursor();
+			}
+		}
+
+		m_class = nullptr;
+		return m_objects;
+	}
+
+
+
+	// BinaryOutputArchive
+
+	void BinaryOutputArchive::WriteTag(BinaryTag tag)
+	{
+		assert(!m_slots.empty());
+		auto& slot = m_slots.back();
+		assert(!slot.written);
+		slot.written = true;
+		m_data.push_back(static_cast<uint8_t>(tag));
+	}
+
+	void BinaryOutputArchive::WriteInt(int64_t t)
+	{
+		WriteTag(BinaryTag::Int);
+		PutVarint(m_data, ZigZagEncode(t));
+	}
+
+	void BinaryOutputArchive::WriteUInt(uint64_t t)
+	{
+		WriteTag(BinaryTag::UInt);
+		PutVarint(m_data, t);
+	}
+
+	void BinaryOutputArchive::Serialize(float t)
+	{
+		WriteTag(BinaryTag::Float);
+		PutBytes(m_data, &t, sizeof(t));
+	}
+
+	void BinaryOutputArchive::Serialize(double t)
+	{
+		WriteTag(BinaryTag::Double);
+		PutBytes(m_data, &t, sizeof(t));
+	}
+
+	void BinaryOutputArchive::Serialize(bool t)
+	{
+		WriteTag(BinaryTag::Bool);
+		m_data.push_back(t ? 1 : 0);
+	}
+
+	void BinaryOutputArchive::Serialize(std::string const & t)
+	{
+		WriteTag(BinaryTag::String);
+		PutString(m_data, t);
+	}
+
+	void BinaryOutputArchive::SerializeNullPtr()
+	{
+		WriteTag(BinaryTag::Null);
+	}
+
+	void BinaryOutputArchive::SerializeObject(Object* t)
+	{
+		auto it = m_externalObjects.find(t);
+		if (it != m_externalObjects.end())
+		{
+			WriteTag(BinaryTag::ExternalObject);
+			PutVarint(m_data, ZigZagEncode(it->second.second));
+			PutVarint(m_data, GetGUIDIndex(it->second.first));
+		}
+		else if (t->Is<Mesh>() || t->Is<Material>())
+		{
+			int64_t fileID = t->GetLocalIdentifierInFile();
+			if (fileID == 0)
+			{
+				LogWarning("Object fileID is 0");
+				fileID = t->GetInstanceID();
+			}
+			WriteTag(BinaryTag::ExternalObject);
+			PutVarint(m_data, ZigZagEncode(fileID));
+			PutVarint(m_data, GetGUIDIndex(AssetDatabase::GetGUIDFromInstanceID(t->GetInstanceID())));
+		}
+		else
+		{
+			WriteTag(BinaryTag::Object);
+			PutVarint(m_data, GetObjectIndex(t));
+		}
+	}
+
+	void BinaryOutputArchive::MapKey(const char* name)
+	{
+		assert(!m_slots.empty());
+		auto& slot = m_slots.back();
+		if (!slot.written)
+		{
+			// first key of a struct/object
+			WriteTag(BinaryTag::Map);
+			slot.container = BinaryTag::Map;
+			slot.sizePos = static_cast<uint32_t>(m_data.size());
+			PutUInt32(m_data, 0);
+			PutUInt32(m_data, 0);
+		}
+		assert(slot.container == BinaryTag::Map);
+		slot.count++;
+
+		auto it = m_class->fieldIndices.find(name);
+		uint32_t field;
+		if (it != m_class->fieldIndices.end())
+		{
+			field = it->second;
+		}
+		else
+		{
+			field = static_cast<uint32_t>(m_class->fields.size());
+			m_class->fields.emplace_back(name);
+			m_class->fieldIndices.emplace(name, field);
+		}
+		PutVarint(m_data, field);
+
+		BeginValue();
+	}
+
+	void BinaryOutputArchive::BeginSequence(int size)
+	{
+		WriteTag(BinaryTag::Sequence);
+		auto& slot = m_slots.back();
+		slot.container = BinaryTag::Sequence;
+		slot.sizePos = static_cast<uint32_t>(m_data.size());
+		PutUInt32(m_data, 0);
+		PutUInt32(m_data, static_cast<uint32_t>(size));
+	}
+
+	void BinaryOutputArchive::EndValue()
+	{
+		assert(!m_slots.empty());
+		auto slot = m_slots.back();
+		m_slots.pop_back();
+
+		if (!slot.written)
+		{
+			// nothing written: a struct without fields or an empty std::map
+			m_data.push_back(static_cast<uint8_t>(BinaryTag::Map));
+			PutUInt32(m_data, 4);
+			PutUInt32(m_data, 0);
+		}
+		else if (slot.container != BinaryTag::Null)
+		{
+			auto size = static_cast<uint32_t>(m_data.size()) - slot.sizePos - 4;
+			PatchUInt32(m_data, slot.sizePos, size);
+			if (slot.container == BinaryTag::Map)
+				PatchUInt32(m_data, slot.sizePos + 4, slot.count);
+		}
+	}
+
+	uint32_t BinaryOutputArchive::GetObjectIndex(Object* obj)
+	{
+		auto it = m_objectIndices.find(obj);
+		if (it != m_objectIndices.end())
+			return it->second;
+		auto index = static_cast<uint32_t>(m_objects.size());
+		m_objects.push_back(obj);
+		m_objectIndices.emplace(obj, index);
+		return index;
+	}
+
+	uint32_t BinaryOutputArchive::GetGUIDIndex(const std::string& guid)
+	{
+		auto it = m_guidIndices.find(guid);
+		if (it != m_guidIndices.end())
+			return it->second;
+		auto index = static_cast<uint32_t>(m_guids.size());
+		m_guids.push_back(guid);
+		m_guidIndices.emplace(guid, index);
+		return index;
+	}
+
+	void BinaryOutputArchive::Dump(const std::vector<Object*>& objects, const std::map<int64_t, Object*>& fileIDToObject,
+		const std::string& excludedGUID)
+	{
+		for (auto&& p : AssetImporter::GetGUIDToImporter())
+		{
+			if (p.first == excludedGUID)
+				continue;
+			for (auto&& q : p.second->GetFileIDToObject())
+				m_externalObjects.emplace(q.second, std::make_pair(p.first, q.first));
+		}
+
+		for (auto o : objects)
+		{
+			if (o != nullptr)
+				GetObjectIndex(o);
+		}
+		std::vector<std::pair<int64_t, uint32_t>> fileIDs;
+		for (auto&& p : fileIDToObject)
+		{
+			if (p.second != nullptr)
+				fileIDs.emplace_back(p.first, GetObjectIndex(p.second));
+		}
+
+		struct ObjectEntry
+		{
+			uint32_t	classIndex;
+			int64_t		fileID;
+			uint32_t	offset;
+		};
+		std::vector<ObjectEntry> entries;
+
+		// m_objects grows while serializing, every referenced local object is appended
+		for (size_t i = 0; i < m_objects.size(); ++i)
+		{
+			auto o = m_objects[i];
+			int64_t fileID = o->GetLocalIdentifierInFile();
+			if (fileID == 0)
+			{
+				LogWarning("Object fileID is 0");
+				fileID = o->GetInstanceID();
+			}
+
+			int classID = o->GetClassID();
+			auto it = m_classIndices.find(classID);
+			if (it == m_classIndices.end())
+			{
+				it = m_classIndices.emplace(classID, static_cast<uint32_t>(m_classes.size())).first;
+				m_classes.emplace_back();
+				m_classes.back().classID = classID;
+			}
+			m_class = &m_classes[it->second];
+
+			ObjectEntry e;
+			e.classIndex = it->second;
+			e.fileID = fileID;
+			e.offset = static_cast<uint32_t>(m_data.size());
+			entries.push_back(e);
+
+			BeginValue();
+			o->Serialize(*this);
+			EndValue();
+			assert(m_slots.empty());
+		}
+		m_class = nullptr;
+
+		std::vector<uint8_t> header;
+		PutUInt32(header, static_cast<uint32_t>(m_classes.size()));
+		PutUInt32(header, static_cast<uint32_t>(m_guids.size()));
+		PutUInt32(header, static_cast<uint32_t>(entries.size()));
+		PutUInt32(header, static_cast<uint32_t>(fileIDs.size()));
+		for (auto&& c : m_classes)
+		{
+			PutVarint(header, ZigZagEncode(c.classID));
+			PutVarint(header, c.fields.size());
+			for (auto&& field : c.fields)
+				PutString(header, field);
+		}
+		for (auto&& guid : m_guids)
+			PutString(header, guid);
+		for (auto&& e : entries)
+		{
+			PutVarint(header, e.classIndex);
+			PutVarint(header, ZigZagEncode(e.fileID));
+			PutUInt32(header, e.offset);
+		}
+		for (auto&& f : fileIDs)
+		{
+			PutVarint(header, ZigZagEncode(f.first));
+			PutVarint(header, f.second);
+		}
+
+		std::vector<uint8_t> prefix;
+		PutUInt32(prefix, BinaryArchiveMagic);
+		PutUInt32(prefix, BinaryArchiveVersion);
+		PutUInt32(prefix, Checksum(m_data.data(), m_data.size(), Checksum(header.data(), header.size())));
+
+		fout.write(reinterpret_cast<const char*>(prefix.data()), prefix.size());
+		fout.write(reinterpret_cast<const char*>(header.data()), header.size());
+		fout.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+	}
+}
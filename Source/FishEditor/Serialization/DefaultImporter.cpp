@@ -1,6 +1,9 @@
 #include <FishEditor/Serialization/DefaultImporter.hpp>
 #include <FishEditor/Serialization/YAMLArchive.hpp>
+#include <FishEditor/Serialization/BinaryArchive.hpp>
+#include <FishEditor/Serialization/AssetCooker.hpp>
 #include <FishEngine/Scene.hpp>
+#include <FishEngine/Debug.hpp>
 
 #include <FishEditor/Path.hpp>
 #include <algorithm>
@@ -19,9 +22,30 @@ namespace FishEditor
 		Scene* old = SceneManager::GetActiveScene();
 		Scene* scene = SceneManager::CreateScene(sceneName);
 		SceneManager::SetActiveScene(scene);
-		YAMLInputArchive archive;
-		std::string str = ReadFileAsString(fullpath);
-		auto objects = archive.LoadAllFromString(str);
+		std::vector<Object*> objects;
+		if (AssetCooker::IsUpToDate(fullpath, GetGUID()))
+		{
+			BinaryInputArchive archive;
+			objects = archive.LoadAllFromString(AssetCooker::ReadCookedFile(GetGUID()));
+		}
+		if (objects.empty())
+		{
+			std::ifstream is(fullpath);
+			if (!is)
+			{
+				SceneManager::SetActiveScene(old);
+				LogError(Format("DefaultImporter: can not open {}", fullpath));
+				return;
+			}
+			// the whole file: its documents are parsed in parallel
+			std::stringstream buffer;
+			buffer << is.rdbuf();
+			YAMLInputArchive archive;
+			objects = archive.LoadAllFromString(buffer.str());
+			// an empty scene is not cooked, it would be loaded from YAML again anyway
+			if (!objects.empty())
+				AssetCooker::Cook(objects, archive.GetFileIDToObject(), GetGUID());
+		}
 		SceneManager::SetActiveScene(old);
 
 //		auto&& transforms = m_Scene->FindComponents<Transform>();
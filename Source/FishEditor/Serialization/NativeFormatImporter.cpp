@@ -1,5 +1,7 @@
 #include <FishEditor/Serialization/NativeFormatImporter.hpp>
 #include <FishEditor/Serialization/YAMLArchive.hpp>
+#include <FishEditor/Serialization/BinaryArchive.hpp>
+#include <FishEditor/Serialization/AssetCooker.hpp>
 #include <FishEditor/Path.hpp>
 #include <FishEngine/Render/Material.hpp>
 
@@ -50,23 +52,52 @@ namespace FishEditor
 //			}
 		}
 
-		YAMLInputArchive archive;
-
-		auto fullpath = this->GetFullPath();
-		auto str = ReadFileAsString(fullpath);
-		auto objects = archive.LoadAllFromString(str);
 		int64_t mainObjectFileID = Prefab::ClassID * 100000;
 		try {
 			mainObjectFileID = meta.importerInfo["NativeFormatImporter"]["mainObjectFileID"].as<int64_t>();
 		} catch(const std::exception& e) {
 			abort();
 		}
+		auto findMainObject = [mainObjectFileID](const std::vector<Object*>& objects, const std::map<int64_t, Object*>& fileIDToObject) -> Object* {
+			if (mainObjectFileID == 0)		// fileFormatVersion == 2
+				return objects.empty() ? nullptr : objects[0];
+			auto it = fileIDToObject.find(mainObjectFileID);
+			return it == fileIDToObject.end() ? nullptr : it->second;
+		};
+
+		auto fullpath = this->GetFullPath();
+		std::vector<Object*> objects;
+		std::map<int64_t, Object*> fileIDToObject;
 		Object* mainObject = nullptr;
-		if (mainObjectFileID == 0)		// fileFormatVersion == 2
-			mainObject = objects[0];
-		else
-			mainObject = archive.GetObjectByFileID(mainObjectFileID);
-		assert(mainObject != nullptr);
+		if (AssetCooker::IsUpToDate(fullpath, GetGUID()))
+		{
+			BinaryInputArchive archive;
+			objects = archive.LoadAllFromString(AssetCooker::ReadCookedFile(GetGUID()));
+			fileIDToObject = archive.GetFileIDToObject();
+			mainObject = findMainObject(objects, fileIDToObject);
+		}
+		if (mainObject == nullptr)
+		{
+			std::ifstream is(fullpath);
+			if (!is)
+			{
+				LogError(Format("NativeFormatImporter: can not open {}", fullpath));
+				return;
+			}
+			// the whole file: its documents are parsed in parallel
+			std::stringstream buffer;
+			buffer << is.rdbuf();
+			YAMLInputArchive archive;
+			objects = archive.LoadAllFromString(buffer.str());
+			fileIDToObject = archive.GetFileIDToObject();
+			mainObject = findMainObject(objects, fileIDToObject);
+			if (mainObject == nullptr)
+			{
+				LogError(Format("NativeFormatImporter: no main object(fileID {}) in {}", mainObjectFileID, fullpath));
+				return;
+			}
+			AssetCooker::Cook(objects, fileIDToObject, GetGUID());
+		}
 		m_MainAsset = mainObject;
 
 		if (mainObject->GetClassID() == Prefab::ClassID)
@@ -76,8 +107,8 @@ namespace FishEditor
 			//{
 			//	prefab->AddObject(p.first, p.second);
 			//}
-			prefab->m_FileIDToObject = archive.GetFileIDToObject();
+			prefab->m_FileIDToObject = fileIDToObject;
 		}
-		this->m_FileIDToObject = archive.GetFileIDToObject();
+		this->m_FileIDToObject = fileIDToObject;
 	}
 }
@@ -9,9 +9,17 @@
 #include <FishEngine/CreateObject.hpp>
 
 #include <FishEngine/Serialization/Serialize.hpp>
+#include <FishEngine/System/JobSystem.hpp>
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
 
 
 bool YAMLNodeHasKey(const YAML::Node& node, const char* key)
@@ -19,7 +27,7 @@ bool YAMLNodeHasKey(const YAML::Node& node, const char* key)
 	assert(node.IsMap());
 	for (auto it = node.begin(); it != node.end(); ++it)
 	{
-		if (it->first.as<std::string>() == key)
+		if (it->first.Scalar() == key)
 		{
 			return true;
 		}
@@ -30,34 +38,54 @@ bool YAMLNodeHasKey(const YAML::Node& node, const char* key)
 
 namespace FishEditor
 {
-	std::vector<std::pair<int, int64_t>> GetClassIDAndFileID(const std::string& s)
+	// --- !u!classID &fileID [stripped]
+	static bool ParseDocumentHeader(const std::string& line, int& classID, int64_t& fileID)
 	{
-		std::vector<std::pair<int, int64_t>> pairs;
-
-		std::regex pattern(R"(--- !u!(\d+) &(\d+))");
-		auto words_begin =
-			std::sregex_iterator(s.begin(), s.end(), pattern);
-		auto words_end = std::sregex_iterator();
-		auto count = std::distance(words_begin, words_end);
-		pairs.reserve(count);
-		for (std::sregex_iterator i = words_begin; i != words_end; ++i)
-		{
-			std::smatch match = *i;
-			int classID = std::stoi(match[1]);
-			long long fileID = std::stoll(match[2]);
-			pairs.emplace_back(classID, fileID);
-		}
-		return pairs;
+		if (line.compare(0, 7, "--- !u!") != 0)
+			return false;
+		char* end = nullptr;
+		classID = static_cast<int>(std::strtol(line.c_str() + 7, &end, 10));
+		if (end[0] != ' ' || end[1] != '&')
+			return false;
+		fileID = std::strtoll(end + 2, nullptr, 10);
+		return true;
 	}
 
-	std::string RemoveStripped(const std::string& s)
+	// a document of a file: its header, and its text from the line after the header to the next header
+	struct DocumentText
+	{
+		int		classID;
+		int64_t	fileID;
+		size_t	begin;
+		size_t	end;
+	};
+
+	static std::vector<DocumentText> SplitDocuments(const std::string& str)
 	{
-		std::regex pattern(R"((--- !u!\d+ &\d+) stripped)");
-		std::string out = s;
-		std::regex_replace(out.begin(), s.begin(), s.end(), pattern, "$1");
-		return out;
+		std::vector<DocumentText> documents;
+		size_t lineBegin = 0;
+		while (lineBegin < str.size())
+		{
+			auto lineEnd = str.find('\n', lineBegin);
+			if (lineEnd == std::string::npos)
+				lineEnd = str.size();
+			DocumentText doc;
+			if (str.compare(lineBegin, 7, "--- !u!") == 0
+				&& ParseDocumentHeader(str.substr(lineBegin, lineEnd - lineBegin), doc.classID, doc.fileID))
+			{
+				if (!documents.empty())
+					documents.back().end = lineBegin;
+				doc.begin = std::min(lineEnd + 1, str.size());
+				doc.end = str.size();
+				documents.push_back(doc);
+			}
+			lineBegin = lineEnd + 1;
+		}
+		return documents;
 	}
 
+	// documents parsed per job
+	static int s_ParseGrainSize = 64;
 
 	void PatchNode(YAML::Node& node)
 	{
@@ -97,13 +125,28 @@ namespace FishEditor
 
 	std::vector<Object*> YAMLInputArchive::LoadAllFromString(const std::string& str)
 	{
-		auto classID_fileID = GetClassIDAndFileID(str);
-		auto str2 = RemoveStripped(str);
-		m_nodes = YAML::LoadAll(str2);
-		assert(m_nodes.size() == classID_fileID.size());
+		using Clock = std::chrono::high_resolution_clock;
+		auto start = Clock::now();
+
+		// each document is parsed on its own, its header is not part of it(so "stripped" needs no removal)
+		auto documents = SplitDocuments(str);
+		std::vector<std::pair<int, int64_t>> classID_fileID;
+		classID_fileID.reserve(documents.size());
+		for (auto&& doc : documents)
+			classID_fileID.emplace_back(doc.classID, doc.fileID);
+		m_nodes.assign(documents.size(), YAML::Node());
+		JobSystem::GetInstance().ParallelFor(0, static_cast<int>(documents.size()), s_ParseGrainSize,
+			[this, &str, &documents](int first, int last) {
+			for (int i = first; i < last; ++i)
+			{
+				auto&& doc = documents[i];
+				m_nodes[i] = YAML::Load(str.substr(doc.begin, doc.end - doc.begin));
+				PatchNode(m_nodes[i]);
+			}
+		});
 
-		for (auto&& node : m_nodes)
-			PatchNode(node);
+		auto parsed = Clock::now();
+		m_loadTimes.parse = std::chrono::duration<double, std::milli>(parsed - start).count();
 
 		std::vector<Object*> objects(m_nodes.size());
 
@@ -114,7 +157,7 @@ namespace FishEditor
 		// step 0: create all objects (except prefabs and ref to prefab)
 		for (int i = 0; i < m_nodes.size(); ++i)
 		{
-			auto&& node = m_nodes[i].begin()->second;
+			YAML::Node node = m_nodes[i].begin()->second;
 			int classID = classID_fileID[i].first;
 			int64_t fileID = classID_fileID[i].second;
 
@@ -198,7 +241,7 @@ namespace FishEditor
 		// step 2: ref to prefab
 		for (int i = 0; i < m_nodes.size(); ++i)
 		{
-			auto&& node = m_nodes[i].begin()->second;
+			YAML::Node node = m_nodes[i].begin()->second;
 			int classID = classID_fileID[i].first;
 			int64_t fileID = classID_fileID[i].second;
 			
@@ -251,88 +294,644 @@ namespace FishEditor
 //			}
 //		}
 
-		// deserialize GameObjects from archive
+		// deserialize from archive, GameObjects first
+		DeserializeAll(objects, classID_fileID);
+
 		for (int i = 0; i < m_nodes.size(); ++i)
 		{
-			auto&& node = m_nodes[i];
-			assert(node.IsMap());
-			auto className = node.begin()->first.as<std::string>();
-			Object* obj = objects[i];
 			int classID = classID_fileID[i].first;
-
-			if (obj != nullptr && classID == GameObject::ClassID)
+			int64_t fileID = classID_fileID[i].second;
+			if (classID == Prefab::ClassID)
 			{
-				assert(className == obj->GetClassName());
-				if (obj->As<GameObject>()->GetPrefabInternal() == nullptr)	// not a prefab instance
+				Object* obj = nullptr;
+				auto&& node = m_nodes[i];
+				auto&& parentPrefab = node.begin()->second["m_ParentPrefab"];
+				auto parentFileID = parentPrefab["fileID"].as<int64_t>();
+
+				if (parentFileID == 0)	// this prefab is a definition
 				{
-					PushNode(node.begin()->second);
-					obj->Deserialize(*this);
-					PopNode();
+					auto prefab = fileIDToPrefab[fileID];
+					auto&& rootGameObject = node.begin()->second["m_RootGameObject"];
+					auto rootGameObjectFileID = rootGameObject["fileID"].as<int64_t>();
+					prefab->m_RootGameObject = m_FileIDToObject[rootGameObjectFileID]->As<GameObject>();
 				}
 			}
 		}
 
+		m_loadTimes.deserialize = std::chrono::duration<double, std::milli>(Clock::now() - parsed).count();
+		return objects;
+	}
+
+
+	// {fileID: x, guid: y} in node
+	static void CollectExternalReferences(const YAML::Node& node, std::vector<std::pair<std::string, int64_t>>& refs)
+	{
+		if (node.IsMap())
+		{
+			int64_t fileID = 0;
+			const std::string* guid = nullptr;
+			for (auto it = node.begin(); it != node.end(); ++it)
+			{
+				auto&& key = it->first.Scalar();
+				if (key == "fileID")
+					fileID = it->second.as<int64_t>();
+				else if (key == "guid")
+					guid = &it->second.Scalar();
+				else
+					CollectExternalReferences(it->second, refs);
+			}
+			if (guid != nullptr)
+				refs.emplace_back(*guid, fileID);
+		}
+		else if (node.IsSequence())
+		{
+			for (auto it = node.begin(); it != node.end(); ++it)
+				CollectExternalReferences(*it, refs);
+		}
+	}
+
+	// groups of DeserializeAll per job
+	static int s_DeserializeGrainSize = 16;
+
+	void YAMLInputArchive::DeserializeAll(const std::vector<Object*>& objects, const std::vector<std::pair<int, int64_t>>& classID_fileID)
+	{
+		// Groups of documents deserialized in order by one thread: a GameObject, then its components.
+		// GameObject::Deserialize and Component::Deserialize only write the objects of their group(and
+		// RendererRegistry entries of renderers created by this load, which are already dirty).
+		std::vector<std::vector<int>> groups;
+		std::unordered_map<Object*, int> groupOfGameObject;
+		auto GroupOf = [&](Object* gameObject) -> std::vector<int>& {
+			if (gameObject == nullptr)
+			{
+				groups.emplace_back();
+				return groups.back();
+			}
+			auto it = groupOfGameObject.find(gameObject);
+			if (it != groupOfGameObject.end())
+				return groups[it->second];
+			groupOfGameObject[gameObject] = static_cast<int>(groups.size());
+			groups.emplace_back();
+			return groups.back();
+		};
 
-		// deserialize from archive
 		for (int i = 0; i < m_nodes.size(); ++i)
 		{
-			auto&& node = m_nodes[i];
-			assert(node.IsMap());
-			auto className = node.begin()->first.as<std::string>();
 			Object* obj = objects[i];
 			int classID = classID_fileID[i].first;
-
-			if (obj != nullptr && classID != GameObject::ClassID && classID != Prefab::ClassID)
+			if (obj != nullptr && classID == GameObject::ClassID)
 			{
-				assert(className == obj->GetClassName());
-				PushNode(node.begin()->second);
-				obj->Deserialize(*this);
-				PopNode();
+				auto& group = GroupOf(obj);
+				if (obj->As<GameObject>()->GetPrefabInternal() == nullptr)	// not a prefab instance
+					group.push_back(i);
 			}
 		}
-
 		for (int i = 0; i < m_nodes.size(); ++i)
 		{
+			Object* obj = objects[i];
 			int classID = classID_fileID[i].first;
-			int64_t fileID = classID_fileID[i].second;
-			if (classID == Prefab::ClassID)
+			if (obj == nullptr || classID == GameObject::ClassID || classID == Prefab::ClassID)
+				continue;
+			Object* gameObject = nullptr;
+			if (obj->Is<Component>())
 			{
-				Object* obj = nullptr;
-				auto&& node = m_nodes[i];
-				auto&& parentPrefab = node.begin()->second["m_ParentPrefab"];
-				auto parentFileID = parentPrefab["fileID"].as<int64_t>();
+				gameObject = obj->As<Component>()->GetGameObject();	// set in prefab instances
+				YAML::Node body = m_nodes[i].begin()->second;
+				if (gameObject == nullptr && YAMLNodeHasKey(body, "m_GameObject"))
+				{
+					auto it = m_FileIDToObject.find(body["m_GameObject"]["fileID"].as<int64_t>());
+					if (it != m_FileIDToObject.end())
+						gameObject = it->second;
+				}
+			}
+			GroupOf(gameObject).push_back(i);
+		}
 
-				if (parentFileID == 0)	// this prefab is a definition
+		auto& jobs = JobSystem::GetInstance();
+		const int groupCount = static_cast<int>(groups.size());
+
+		// objects of other assets may be imported when first referenced, which is not thread safe: resolve
+		// them all here
+		std::vector<std::vector<std::pair<std::string, int64_t>>> externalRefs(groupCount);
+		jobs.ParallelFor(0, groupCount, s_DeserializeGrainSize, [this, &groups, &externalRefs](int first, int last) {
+			for (int g = first; g < last; ++g)
+			{
+				for (int i : groups[g])
+					CollectExternalReferences(m_nodes[i].begin()->second, externalRefs[g]);
+			}
+		});
+		for (auto&& refs : externalRefs)
+		{
+			for (auto&& ref : refs)
+			{
+				if (m_ExternalObjects.find(ref) == m_ExternalObjects.end())
+					m_ExternalObjects[ref] = AssetDatabase::GetAssetByGUIDAndFileID(ref.first, ref.second);
+			}
+		}
+
+		jobs.ParallelFor(0, groupCount, s_DeserializeGrainSize, [this, &groups, &objects](int first, int last) {
+			YAMLInputArchive worker(this);
+			for (int g = first; g < last; ++g)
+			{
+				for (int i : groups[g])
 				{
-					auto prefab = fileIDToPrefab[fileID];
-					auto&& rootGameObject = node.begin()->second["m_RootGameObject"];
-					auto rootGameObjectFileID = rootGameObject["fileID"].as<int64_t>();
-					prefab->m_RootGameObject = m_FileIDToObject[rootGameObjectFileID]->As<GameObject>();
+					auto&& node = m_nodes[i];
+					assert(node.IsMap());
+					Object* obj = objects[i];
+					assert(node.begin()->first.Scalar() == obj->GetClassName());
+					worker.PushNode(node.begin()->second);
+					obj->Deserialize(worker);
+					worker.PopNode();
+				}
+			}
+		});
+	}
+
+
+	// local objects referenced by node: {fileID: x} without a guid
+	static void CollectLocalReferences(const YAML::Node& node, std::vector<int64_t>& fileIDs)
+	{
+		if (node.IsMap())
+		{
+			int64_t fileID = 0;
+			bool external = false;
+			for (auto it = node.begin(); it != node.end(); ++it)
+			{
+				auto&& key = it->first.Scalar();
+				if (key == "fileID")
+					fileID = it->second.as<int64_t>();
+				else if (key == "guid")
+					external = true;
+				else
+					CollectLocalReferences(it->second, fileIDs);
+			}
+			if (fileID != 0 && !external)
+				fileIDs.push_back(fileID);
+		}
+		else if (node.IsSequence())
+		{
+			for (auto it = node.begin(); it != node.end(); ++it)
+				CollectLocalReferences(*it, fileIDs);
+		}
+	}
+
+
+	// Runs the steps of LoadAllFromString on each document as soon as the objects it needs are there:
+	//	create		when read. Except prefab instances, once the objects their modification references
+	//				exist, and the objects of a prefab instance(m_PrefabInternal set), once the instance exists.
+	//	deserialize	GameObjects once their components exist. Other objects once the objects they reference
+	//				exist and the GameObjects they reference are deserialized(GameObjects first, as in
+	//				LoadAllFromString).
+	// A document that has to wait is kept as a fixup record: its node and the number of fileIDs it waits for.
+	class YAMLInputArchive::StreamLoader
+	{
+	public:
+		explicit StreamLoader(YAMLInputArchive& archive) : m_archive(archive)
+		{
+		}
+
+		std::vector<Object*> Load(std::istream& is)
+		{
+			std::string line;
+			std::string text;
+			int classID = 0;
+			int64_t fileID = 0;
+			bool inDocument = false;
+			while (std::getline(is, line))
+			{
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				int nextClassID;
+				int64_t nextFileID;
+				if (ParseDocumentHeader(line, nextClassID, nextFileID))
+				{
+					if (inDocument)
+						AddDocument(classID, fileID, text);
+					inDocument = true;
+					classID = nextClassID;
+					fileID = nextFileID;
+					text.clear();
+				}
+				else if (inDocument)
+				{
+					text += line;
+					text += '\n';
+				}
+			}
+			if (inDocument)
+				AddDocument(classID, fileID, text);
+
+			// The documents still waiting reference objects that are not in the file. Load them in the order
+			// of LoadAllFromString, with nullptr for the missing objects.
+			while (!m_pending.empty())
+			{
+				int phase = 2;
+				for (auto&& p : m_pending)
+					phase = std::min(phase, Phase(p.second));
+				std::vector<int> indices;
+				for (auto&& p : m_pending)
+				{
+					if (Phase(p.second) == phase)
+						indices.push_back(p.first);
+				}
+				std::sort(indices.begin(), indices.end());
+				for (int index : indices)
+				{
+					auto it = m_pending.find(index);
+					if (it != m_pending.end() && Phase(it->second) == phase)
+					{
+						Run(it->second, true);
+						RunReady();
+					}
+				}
+			}
+			return std::move(m_objects);
+		}
+
+		// prefab definitions and the fileIDs of their root GameObject
+		const std::vector<std::pair<Prefab*, int64_t>>& GetPrefabRoots() const
+		{
+			return m_prefabRoots;
+		}
+
+	private:
+		enum Stage
+		{
+			CreateStage,
+			DeserializeStage,
+			DoneStage,
+		};
+
+		// Created: the object exists.
+		// Ready: the deserialization of other objects can use it(a GameObject is deserialized).
+		enum Event
+		{
+			Created,
+			Ready,
+		};
+
+		struct Document
+		{
+			int			index;		// in m_objects
+			int			classID;
+			int64_t		fileID;
+			YAML::Node	node;		// { ClassName: {...} }
+			int			stage = CreateStage;
+			int			missing = 0;	// events the stage waits for
+		};
+
+		struct Waiter
+		{
+			int			index;
+			int			stage;
+		};
+
+		static int Phase(const Document& doc)
+		{
+			if (doc.stage == CreateStage)
+				return 0;
+			return doc.classID == GameObject::ClassID ? 1 : 2;
+		}
+
+		void AddDocument(int classID, int64_t fileID, const std::string& text)
+		{
+			const int index = static_cast<int>(m_objects.size());
+			m_objects.push_back(nullptr);
+			auto start = std::chrono::high_resolution_clock::now();
+			auto node = YAML::Load(text);
+			m_archive.m_loadTimes.parse += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			if (!node.IsMap())
+			{
+				LogWarning(Format("empty document &{}", fileID));
+				Fire(fileID, Created);
+				Fire(fileID, Ready);
+				RunReady();
+				return;
+			}
+			PatchNode(node);
+
+			auto& doc = m_pending[index];
+			doc.index = index;
+			doc.classID = classID;
+			doc.fileID = fileID;
+			doc.node = node;
+			Run(doc, false);
+			RunReady();
+		}
+
+		static YAML::Node Body(const Document& doc)
+		{
+			return doc.node.begin()->second;
+		}
+
+		// id1 = m_PrefabParentObject, id2 = m_PrefabInternal
+		static bool IsPrefabInstanceObject(const Document& doc, int64_t& id1, int64_t& id2)
+		{
+			if (doc.classID == Prefab::ClassID)
+				return false;
+			auto body = Body(doc);
+			if (!YAMLNodeHasKey(body, "m_PrefabParentObject"))
+				return false;
+			id1 = body["m_PrefabParentObject"]["fileID"].as<int64_t>();
+			id2 = body["m_PrefabInternal"]["fileID"].as<int64_t>();
+			return id1 != 0 && id2 != 0;
+		}
+
+		static bool IsPrefabInstance(const Document& doc)
+		{
+			return doc.classID == Prefab::ClassID && Body(doc)["m_ParentPrefab"]["fileID"].as<int64_t>() != 0;
+		}
+
+		// Run the stages of doc until one has to wait. force runs the current stage without waiting.
+		void Run(Document& doc, bool force)
+		{
+			while (doc.stage != DoneStage)
+			{
+				if (!force && Wait(doc))
+					return;
+				force = false;
+				doc.missing = 0;
+				RunStage(doc);
+				doc.stage++;
+			}
+			m_pending.erase(doc.index);
+		}
+
+		// Add doc to the waiters of the events its stage needs, true if there is any.
+		bool Wait(Document& doc)
+		{
+			std::vector<int64_t> fileIDs;
+			Event event = Created;
+			int64_t id1, id2;
+			if (doc.stage == CreateStage)
+			{
+				if (IsPrefabInstance(doc))
+					CollectLocalReferences(Body(doc)["m_Modification"], fileIDs);
+				else if (IsPrefabInstanceObject(doc, id1, id2))
+					fileIDs.push_back(id2);
+			}
+			else if (doc.classID != Prefab::ClassID)
+			{
+				CollectLocalReferences(Body(doc), fileIDs);
+				if (doc.classID != GameObject::ClassID)
+					event = Ready;
+			}
+
+			std::sort(fileIDs.begin(), fileIDs.end());
+			fileIDs.erase(std::unique(fileIDs.begin(), fileIDs.end()), fileIDs.end());
+			doc.missing = 0;
+			for (auto fileID : fileIDs)
+			{
+				if (m_fired[event].count(fileID) == 0)
+				{
+					m_waiters[event][fileID].push_back(Waiter{doc.index, doc.stage});
+					doc.missing++;
+				}
+			}
+			return doc.missing > 0;
+		}
+
+		void RunStage(Document& doc)
+		{
+			if (doc.stage == CreateStage)
+				CreateObject(doc);
+			else
+				DeserializeObject(doc);
+		}
+
+		void CreateObject(Document& doc)
+		{
+			Object* obj = nullptr;
+			int64_t id1, id2;
+			if (doc.classID == Prefab::ClassID)
+			{
+				auto body = Body(doc);
+				auto&& parentPrefab = body["m_ParentPrefab"];
+				if (parentPrefab["fileID"].as<int64_t>() == 0)	// this prefab is a definition
+				{
+					auto prefab = CreateEmptyObject<Prefab>();
+					obj = prefab;
+					m_fileIDToPrefab[doc.fileID] = prefab;
+					m_prefabRoots.emplace_back(prefab, body["m_RootGameObject"]["fileID"].as<int64_t>());
+				}
+				else	// this prefab is a ref/instance
+				{
+					std::string guid = parentPrefab["guid"].as<std::string>();
+					std::string assetPath = AssetDatabase::GUIDToAssetPath(guid);
+					Prefab* prefab = dynamic_cast<Prefab*>(AssetDatabase::LoadMainAssetAtPath(assetPath));
+
+					PrefabModification modification;
+					m_archive.PushNode(body["m_Modification"]);
+					m_archive >> modification;
+					m_archive.PopNode();
+
+					Prefab* instance = prefab->InstantiateWithModification(modification);
+					m_fileIDToPrefab[doc.fileID] = instance;
+					obj = instance->GetRootGameObject();
 				}
 			}
+			else if (IsPrefabInstanceObject(doc, id1, id2))
+			{
+				auto prefab = m_fileIDToPrefab[id2];
+				if (prefab != nullptr)
+					obj = prefab->GetObjectByFileID(id1);
+				else
+					LogWarning(Format("prefab instance &{} not found", id2));
+			}
+			else
+			{
+				obj = CreateEmptyObjectByClassID(doc.classID);
+			}
+
+			m_objects[doc.index] = obj;
+			if (obj != nullptr)
+			{
+				m_archive.m_FileIDToObject[doc.fileID] = obj;
+				obj->SetLocalIdentifierInFile(doc.fileID);
+			}
+			Fire(doc.fileID, Created);
+			// a GameObject is ready once deserialized, unless it is in a prefab instance
+			if (obj == nullptr || obj->GetClassID() != GameObject::ClassID || doc.classID == Prefab::ClassID
+				|| obj->As<GameObject>()->GetPrefabInternal() != nullptr)
+				Fire(doc.fileID, Ready);
 		}
 
+		void DeserializeObject(Document& doc)
+		{
+			Object* obj = m_objects[doc.index];
+			if (obj != nullptr && doc.classID != Prefab::ClassID)
+			{
+				bool instance = doc.classID == GameObject::ClassID && obj->As<GameObject>()->GetPrefabInternal() != nullptr;
+				if (!instance)
+				{
+					assert(doc.node.begin()->first.Scalar() == obj->GetClassName());
+					m_archive.PushNode(Body(doc));
+					obj->Deserialize(m_archive);
+					m_archive.PopNode();
+				}
+			}
+			if (doc.classID == GameObject::ClassID)
+				Fire(doc.fileID, Ready);
+		}
+
+		void Fire(int64_t fileID, Event event)
+		{
+			m_fired[event].insert(fileID);
+			auto it = m_waiters[event].find(fileID);
+			if (it == m_waiters[event].end())
+				return;
+			for (auto&& w : it->second)
+			{
+				// the document may have been forced past that stage
+				auto doc = m_pending.find(w.index);
+				if (doc != m_pending.end() && doc->second.stage == w.stage && --doc->second.missing == 0)
+					m_ready.push_back(w.index);
+			}
+			m_waiters[event].erase(it);
+		}
+
+		void RunReady()
+		{
+			while (!m_ready.empty())
+			{
+				int index = m_ready.back();
+				m_ready.pop_back();
+				auto it = m_pending.find(index);
+				if (it != m_pending.end() && it->second.missing == 0)
+					Run(it->second, true);
+			}
+		}
+
+	private:
+		YAMLInputArchive&										m_archive;
+		std::vector<Object*>									m_objects;
+		std::unordered_map<int, Document>						m_pending;
+		std::vector<int>										m_ready;	// pending documents that can run
+		std::unordered_set<int64_t>								m_fired[2];
+		std::unordered_map<int64_t, std::vector<Waiter>>		m_waiters[2];
+		std::map<int64_t, Prefab*>								m_fileIDToPrefab;
+		std::vector<std::pair<Prefab*, int64_t>>				m_prefabRoots;
+	};
+
+
+	std::vector<Object*> YAMLInputArchive::LoadAllFromStream(std::istream& is)
+	{
+		// parse: the sum of the documents, the rest(reading lines included) is counted as deserialize
+		auto start = std::chrono::high_resolution_clock::now();
+		m_loadTimes = LoadTimes();
+		StreamLoader loader(*this);
+		auto objects = loader.Load(is);
+
+		for (auto&& p : loader.GetPrefabRoots())
+		{
+			auto it = m_FileIDToObject.find(p.second);
+			if (it != m_FileIDToObject.end() && it->second != nullptr)
+				p.first->m_RootGameObject = it->second->As<GameObject>();
+		}
+		auto total = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		m_loadTimes.deserialize = total - m_loadTimes.parse;
 		return objects;
 	}
 
 
 
-	Object* YAMLInputArchive::DeserializeObject()
+	// FNV-1a
+	static uint32_t HashKey(const char* key, size_t length)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; ++i)
+		{
+			hash ^= static_cast<uint8_t>(key[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	void YAMLInputArchive::BuildKeyIndex(WorkingNode& current)
+	{
+		const YAML::Node& node = current.node;
+		assert(node.IsMap());
+		const size_t count = node.IsMap() ? node.size() : 0;
+
+		// at most half full, so probing always ends on an empty slot
+		uint32_t slotCount = 8;
+		while (slotCount < count * 2)
+			slotCount *= 2;
+		current.indexBegin = static_cast<uint32_t>(m_keyIndex.size());
+		current.indexMask = slotCount - 1;
+		current.valuesBegin = static_cast<uint32_t>(m_keyValues.size());
+		current.indexed = true;
+		m_keyIndex.resize(m_keyIndex.size() + slotCount);
+		if (count == 0)
+			return;
+
+		// yaml-cpp iterators copy the document's shared_ptr on every dereference and end(), do both once
+		const auto end = node.end();
+		for (auto it = node.begin(); it != end; ++it)
+		{
+			const auto& pair = *it;
+			const std::string& key = pair.first.Scalar();	// owned by the document
+			const uint32_t hash = HashKey(key.data(), key.size());
+			for (uint32_t i = hash & current.indexMask; ; i = (i + 1) & current.indexMask)
+			{
+				auto& entry = m_keyIndex[current.indexBegin + i];
+				if (entry.key == nullptr)
+				{
+					entry.hash = hash;
+					entry.value = static_cast<uint32_t>(m_keyValues.size());
+					entry.key = &key;
+					m_keyValues.push_back(pair.second);
+					break;
+				}
+				if (entry.hash == hash && *entry.key == key)	// duplicated key, the first one wins like node[key]
+					break;
+			}
+		}
+	}
+
+	const YAML::Node* YAMLInputArchive::FindKey(const char* name)
 	{
-		auto current = CurrentNode();
-		int64_t fileID = current["fileID"].as<int64_t>();
+		assert(!m_workingNodes.empty());
+		auto& current = m_workingNodes.back();
+		if (!current.indexed)
+			BuildKeyIndex(current);
+
+		const size_t length = strlen(name);
+		const uint32_t hash = HashKey(name, length);
+		for (uint32_t i = hash & current.indexMask; ; i = (i + 1) & current.indexMask)
+		{
+			auto& entry = m_keyIndex[current.indexBegin + i];
+			if (entry.key == nullptr)
+				return nullptr;
+			if (entry.hash == hash && entry.key->size() == length && memcmp(entry.key->data(), name, length) == 0)
+				return &m_keyValues[entry.value];
+		}
+	}
 
-		if (YAMLNodeHasKey(current, "guid"))	// extern fileID
+
+	Object* YAMLInputArchive::DeserializeObject()
+	{
+		auto fileIDNode = FindKey("fileID");
+		if (fileIDNode == nullptr)	// not {fileID: x}
+			return nullptr;
+		int64_t fileID = fileIDNode->as<int64_t>();
+		auto root = m_parent != nullptr ? m_parent : this;
+
+		auto guidNode = FindKey("guid");
+		if (guidNode != nullptr)	// extern fileID
 		{
-			auto guid = current["guid"].as<std::string>();
+			auto& guid = guidNode->Scalar();
 //			LogWarning(guid);
+			auto it = root->m_ExternalObjects.find(std::make_pair(guid, fileID));
+			if (it != root->m_ExternalObjects.end())
+				return it->second;
+			assert(m_parent == nullptr);
 			return AssetDatabase::GetAssetByGUIDAndFileID(guid, fileID);
 		}
 		else {	// local fileID
 			if (fileID != 0)
 			{
-				auto it = this->m_FileIDToObject.find(fileID);
-				if (it != this->m_FileIDToObject.end())
+				auto it = root->m_FileIDToObject.find(fileID);
+				if (it != root->m_FileIDToObject.end())
 					return it->second;
 				else {
 					//abort();
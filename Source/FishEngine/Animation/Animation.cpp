@@ -1,5 +1,6 @@
 #include <FishEngine/Animation/Animation.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <boost/algorithm/string.hpp>
 
@@ -36,65 +37,439 @@ void GetSkeleton(
 
 void Animation::Start()
 {
-	if (m_clip == nullptr)
-		return;
-	auto t = this->GetTransform();
-	GetSkeleton(t, "", m_skeleton, m_clip->m_avatar->m_boneToIndex);
+	Bind();
 }
 
-Transform* GetBone(std::string const & path, std::map<std::string, Transform*> const & skeleton)
+int GetBoneIndex(std::string const & path, std::map<std::string, int> const & boneIndices)
 {
-	auto it = skeleton.find(path);
-	if (it == skeleton.end())
+	auto it = boneIndices.find(path);
+	if (it == boneIndices.end())
 	{
 		//abort();
 		//LogWarning(Format("Bone [{}] not found\n", path));
-		return nullptr;
+		return -1;
 	}
 	return it->second;
 }
 
-void Animation::Update(float deltaTime)
+// appends the bone index of every curve to bones
+template<class Curve>
+void BindCurves(
+	std::vector<Curve> const &					curves,
+	std::map<std::string, int> const &			boneIndices,
+	std::vector<int>&							bones)
+{
+	for (auto& curve : curves)
+	{
+		bones.push_back(GetBoneIndex(curve.path, boneIndices));
+	}
+}
+
+void Animation::Bind()
+{
+	m_boundClip = m_clip;
+	m_skeleton.clear();
+	m_bones.clear();
+	m_boneDepths.clear();
+	m_boneIndices.clear();
+	m_poseSampled = false;
+
+	// every clip of a character shares its avatar
+	Avatar* avatar = m_clip != nullptr ? m_clip->m_avatar : nullptr;
+	for (auto& binding : m_clips)
+	{
+		if (avatar == nullptr)
+			avatar = binding.clip->m_avatar;
+	}
+	if (avatar != nullptr)
+		GetSkeleton(this->GetTransform(), "", m_skeleton, avatar->m_boneToIndex);
+	for (auto& p : m_skeleton)
+	{
+		m_boneIndices[p.first] = static_cast<int>(m_bones.size());
+		m_bones.push_back(p.second);
+		m_boneDepths.push_back(static_cast<int>(std::count(p.first.begin(), p.first.end(), '/')));
+	}
+
+	const int boneCount = static_cast<int>(m_bones.size());
+	m_restPose.Resize(boneCount);
+	m_pose.Resize(boneCount);
+	m_layerPose.Resize(boneCount);
+	m_fadePose.Resize(boneCount);
+	m_boneChannels.assign(boneCount, 0);
+	for (int i = 0; i < boneCount; ++i)
+	{
+		m_restPose.positions[i] = m_bones[i]->GetLocalPosition();
+		m_restPose.rotations[i] = m_bones[i]->GetLocalRotation();
+		m_restPose.scales[i] = m_bones[i]->GetLocalScale();
+	}
+
+	for (auto& binding : m_clips)
+		BindClip(binding);
+	if (m_layers.empty())
+		m_layers.emplace_back();
+	for (auto& layer : m_layers)
+	{
+		UpdateLayerMask(layer);
+		layer.snapshot.Resize(boneCount);
+		layer.fadeFromSnapshot = false;
+	}
+	if (m_clip != nullptr && (m_layers[0].clip < 0 || m_clips[m_layers[0].clip].clip != m_clip))
+		Play(m_clip, 0);
+}
+
+void Animation::BindClip(ClipBinding& binding)
 {
-	if (m_clip == nullptr)
+	auto clip = binding.clip;
+	binding.positionBones.clear();
+	binding.rotationBones.clear();
+	binding.scaleBones.clear();
+	BindCurves(clip->m_positionCurve, m_boneIndices, binding.positionBones);
+	// same order as the sampled/compressed rotations
+	for (auto c : clip->GetEulersRotationSources())
+		binding.rotationBones.push_back(GetBoneIndex(c->path, m_boneIndices));
+	BindCurves(clip->m_rotationCurves, m_boneIndices, binding.rotationBones);
+	BindCurves(clip->m_scaleCurves, m_boneIndices, binding.scaleBones);
+	UpdateTrackMask(binding);
+
+	auto& compressed = clip->m_compressedClip;
+	auto& sampled = clip->m_sampledClip;
+	binding.pose.clear();
+	if (compressed.IsValid())
+	{
+		binding.pose.resize(compressed.GetPoseSize());
 		return;
-	m_localTimer += deltaTime;
-	for (auto & curve : m_clip->m_positionCurve)
+	}
+	if (!sampled.IsValid() && clip->HasSourceKeys())
+		clip->BuildSampledClip();
+	if (sampled.IsValid())
+		binding.pose.resize(sampled.GetStride());
+}
+
+int Animation::FindOrAddClip(AnimationClip* clip)
+{
+	for (size_t i = 0; i < m_clips.size(); ++i)
+	{
+		if (m_clips[i].clip == clip)
+			return static_cast<int>(i);
+	}
+	m_clips.emplace_back();
+	m_clips.back().clip = clip;
+	BindClip(m_clips.back());
+	return static_cast<int>(m_clips.size()) - 1;
+}
+
+void Animation::UpdateLayerMask(Layer& layer)
+{
+	layer.boneMask.clear();
+	if (layer.maskPaths.empty())
+		return;
+	layer.boneMask.assign(m_bones.size(), 0.0f);
+	for (auto& p : m_boneIndices)
+	{
+		for (auto& maskPath : layer.maskPaths)
+		{
+			// the bone itself and everything under it
+			if (boost::starts_with(p.first, maskPath) && (p.first.size() == maskPath.size() || p.first[maskPath.size()] == '/'))
+				layer.boneMask[p.second] = 1.0f;
+		}
+	}
+}
+
+int Animation::AddLayer(float weight)
+{
+	if (m_layers.empty())
+		m_layers.emplace_back();
+	m_layers.emplace_back();
+	m_layers.back().weight = weight;
+	for (auto& layer : m_layers)
+		layer.snapshot.Resize(static_cast<int>(m_bones.size()));
+	return static_cast<int>(m_layers.size()) - 1;
+}
+
+void Animation::SetLayerMask(int layer, const std::vector<std::string>& bonePaths)
+{
+	m_layers[layer].maskPaths = bonePaths;
+	UpdateLayerMask(m_layers[layer]);
+}
+
+void Animation::Play(AnimationClip* clip, int layer)
+{
+	if (m_layers.empty())
+		m_layers.emplace_back();
+	auto& l = m_layers[layer];
+	l.clip = clip == nullptr ? -1 : FindOrAddClip(clip);
+	l.time = 0;
+	l.nextClip = -1;
+	l.fade = 0;
+	l.fadeFromSnapshot = false;
+}
+
+void Animation::CrossFade(AnimationClip* clip, float fadeLength, int layer)
+{
+	if (m_layers.empty())
+		m_layers.emplace_back();
+	auto& l = m_layers[layer];
+	if (l.clip < 0 || fadeLength <= 0)
+	{
+		Play(clip, layer);
+		return;
+	}
+	const int index = FindOrAddClip(clip);
+	if (l.nextClip == index)
+		return;		// already fading to it
+	float nextTime = 0;
+	if (l.nextClip >= 0)
+	{
+		// interrupted: fade from the pose reached so far, not from either of its clips
+		if (!m_bones.empty())
+		{
+			if (l.snapshot.GetBoneCount() != static_cast<int>(m_bones.size()))
+				l.snapshot.Resize(static_cast<int>(m_bones.size()));
+			// bones neither clip animates keep the last sampled pose
+			if (!l.fadeFromSnapshot)
+			{
+				l.snapshot.CopyFrom(m_pose);
+				SampleClip(m_clips[l.clip], l.time, l.snapshot);
+			}
+			m_fadePose.CopyFrom(m_pose);
+			SampleClip(m_clips[l.nextClip], l.nextTime, m_fadePose);
+			l.snapshot.Blend(m_fadePose, l.fade, nullptr);
+			l.fadeFromSnapshot = true;
+		}
+		else
+		{
+			// nothing sampled yet: continue from the clip that was fading in
+			l.clip = l.nextClip;
+			l.time = l.nextTime;
+			if (l.clip == index)
+			{
+				l.nextClip = -1;
+				return;
+			}
+		}
+	}
+	else if (l.clip == index)
+	{
+		return;
+	}
+	else
+	{
+		l.fadeFromSnapshot = false;
+	}
+	if (l.fadeFromSnapshot && l.clip == index)
+		nextTime = l.time;	// fading back to the clip that was fading out, keep its time
+	l.nextClip = index;
+	l.nextTime = nextTime;
+	l.fade = 0;
+	l.fadeSpeed = 1.0f / fadeLength;
+}
+
+void Animation::UpdateTrackMask(ClipBinding& binding)
+{
+	binding.trackMask.clear();
+	if (m_lod == AnimationLOD::Full || m_lod == AnimationLOD::Reduced)
+		return;
+	// Offscreen keeps the root positions only, that is where root motion comes from
+	const bool offscreen = m_lod == AnimationLOD::Offscreen;
+	const int maxDepth = offscreen ? 0 : m_maxBoneDepth;
+	auto Evaluated = [this, maxDepth](int bone) { return bone >= 0 && m_boneDepths[bone] <= maxDepth; };
+	for (int bone : binding.positionBones)
+		binding.trackMask.push_back(Evaluated(bone));
+	for (int bone : binding.rotationBones)
+		binding.trackMask.push_back(!offscreen && Evaluated(bone));
+	for (int bone : binding.scaleBones)
+		binding.trackMask.push_back(!offscreen && Evaluated(bone));
+}
+
+void Animation::SetLOD(AnimationLOD lod, const AnimationLODSettings& settings, int phase)
+{
+	int interval = 1;
+	if (lod == AnimationLOD::Reduced)
+		interval = settings.reducedUpdateInterval;
+	else if (lod == AnimationLOD::Minimal)
+		interval = settings.minimalUpdateInterval;
+	interval = std::max(interval, 1);
+
+	// A countdown in progress is kept(clamped to the new interval): resetting it on every LOD change would
+	// postpone the next sample again and again for a character hovering around a threshold.
+	// Coming from an interval of 1 there is no countdown yet, the phase spreads the characters instead.
+	if (m_updateInterval <= 1)
+		m_framesUntilUpdate = phase % interval;
+	else
+		m_framesUntilUpdate = std::min(m_framesUntilUpdate, interval - 1);
+	m_updateInterval = interval;
+	if (lod != m_lod || settings.minimalBoneDepth != m_maxBoneDepth)
+	{
+		m_lod = lod;
+		m_maxBoneDepth = settings.minimalBoneDepth;
+		for (auto& binding : m_clips)
+			UpdateTrackMask(binding);
+	}
+}
+
+void Animation::SampleClip(ClipBinding& binding, float time, AnimationPose& pose)
+{
+	if (binding.pose.empty())
+		return;
+	auto& compressed = binding.clip->m_compressedClip;
+	auto& sampled = binding.clip->m_sampledClip;
+	const bool isCompressed = compressed.IsValid();
+	const uint8_t* mask = binding.trackMask.empty() ? nullptr : binding.trackMask.data();
+	if (isCompressed)
+		compressed.Sample(time, true, binding.pose.data(), mask);
+	else	// all channels in one SIMD pass over two contiguous frames, the LOD only limits what is used
+		sampled.Sample(time, true, binding.pose.data());
+
+	int curve = 0;
+	const float* p = binding.pose.data() + (isCompressed ? compressed.GetPositionOffset() : sampled.GetPositionOffset());
+	for (int bone : binding.positionBones)
 	{
-		auto t = GetBone(curve.path, m_skeleton);
-		if (t != nullptr)
+		if (bone >= 0 && (mask == nullptr || mask[curve]))
 		{
-			auto v = curve.curve.Evaluate(m_localTimer, true);
-			t->SetLocalPosition(v);
+			pose.positions[bone].Set(p[0], p[1], p[2]);
+			m_boneChannels[bone] |= PositionChannel;
 		}
+		p += 3;
+		++curve;
 	}
-	//for (auto & curve : m_clip->m_rotationCurves)
-	//{
-	//	auto t = GetBone(curve.path, m_skeleton);
-	//	if (t != nullptr)
-	//	{
-	//		auto v = curve.curve.Evaluate(m_localTimer, true);
-	//		v.NormalizeSelf();
-	//		t->SetLocalRotation(v);
-	//	}
-	//}
-	for (auto & curve : m_clip->m_eulersCurves)
-	{
-		auto t = GetBone(curve.path, m_skeleton);
-		if (t != nullptr)
+	// both formats store quaternions, the constructor normalizes the lerped ones: no trigonometry here
+	p = binding.pose.data() + (isCompressed ? compressed.GetRotationOffset() : sampled.GetRotationOffset());
+	for (int bone : binding.rotationBones)
+	{
+		if (bone >= 0 && (mask == nullptr || mask[curve]))
+		{
+			pose.rotations[bone] = Quaternion(p[0], p[1], p[2], p[3]);
+			m_boneChannels[bone] |= RotationChannel;
+		}
+		p += 4;
+		++curve;
+	}
+	p = binding.pose.data() + (isCompressed ? compressed.GetScaleOffset() : sampled.GetScaleOffset());
+	for (int bone : binding.scaleBones)
+	{
+		if (bone >= 0 && (mask == nullptr || mask[curve]))
 		{
-			auto v = curve.curve.Evaluate(m_localTimer, true);
-			assert(!(isnan(v.x) || isnan(v.y) || isnan(v.z)));
-			t->SetLocalRotation(Quaternion::Euler(RotationOrder::XYZ, v));
+			pose.scales[bone].Set(p[0], p[1], p[2]);
+			m_boneChannels[bone] |= ScaleChannel;
 		}
+		p += 3;
+		++curve;
 	}
-	for (auto & curve : m_clip->m_scaleCurves)
+}
+
+void Animation::ApplyPose()
+{
+	m_appliedCurveCount = 0;
+	if (!m_poseSampled)
+		return;
+	// one write per bone, whatever the number of blended clips
+	for (size_t i = 0; i < m_bones.size(); ++i)
 	{
-		auto t = GetBone(curve.path, m_skeleton);
-		if (t != nullptr)
+		const uint8_t channels = m_boneChannels[i];
+		if (channels == 0)
+			continue;
+		auto bone = m_bones[i];
+		if (channels == AllChannels)
+		{
+			bone->SetLocalTRS(m_pose.positions[i], m_pose.rotations[i], m_pose.scales[i]);
+			m_appliedCurveCount += 3;
+			continue;
+		}
+		if (channels & PositionChannel)
+		{
+			bone->SetLocalPosition(m_pose.positions[i]);
+			++m_appliedCurveCount;
+		}
+		if (channels & RotationChannel)
+		{
+			bone->SetLocalRotation(m_pose.rotations[i]);
+			++m_appliedCurveCount;
+		}
+		if (channels & ScaleChannel)
 		{
-			auto v = curve.curve.Evaluate(m_localTimer, true);
-			t->SetLocalScale(v);
+			bone->SetLocalScale(m_pose.scales[i]);
+			++m_appliedCurveCount;
 		}
 	}
 }
+
+void Animation::Prepare()
+{
+	if (m_clip != m_boundClip)
+		Bind();
+}
+
+void Animation::SamplePose(float deltaTime)
+{
+	m_localTimer += deltaTime;
+	m_poseSampled = false;
+
+	// time always advances, so a frame skipped by the LOD is caught up by the next sample
+	for (auto& layer : m_layers)
+	{
+		if (layer.clip < 0)
+			continue;
+		layer.time += deltaTime;
+		if (layer.nextClip < 0)
+			continue;
+		layer.nextTime += deltaTime;
+		layer.fade += deltaTime * layer.fadeSpeed;
+		if (layer.fade >= 1.0f)
+		{
+			layer.clip = layer.nextClip;
+			layer.time = layer.nextTime;
+			layer.nextClip = -1;
+			layer.fade = 0;
+			layer.fadeFromSnapshot = false;
+		}
+	}
+
+	if (m_bones.empty())
+		return;
+	if (m_framesUntilUpdate > 0)
+	{
+		--m_framesUntilUpdate;
+		return;
+	}
+	m_framesUntilUpdate = m_updateInterval - 1;
+	m_poseSampled = true;
+
+	std::fill(m_boneChannels.begin(), m_boneChannels.end(), 0);
+	m_pose.CopyFrom(m_restPose);
+	for (auto& layer : m_layers)
+	{
+		if (layer.clip < 0 || layer.weight <= 0)
+			continue;
+		auto& binding = m_clips[layer.clip];
+		const bool fading = layer.nextClip >= 0;
+		if (!fading && layer.weight >= 1 && layer.boneMask.empty())
+		{
+			// overrides every bone it animates
+			SampleClip(binding, layer.time, m_pose);
+			continue;
+		}
+		if (fading && layer.fadeFromSnapshot)
+		{
+			m_layerPose.CopyFrom(layer.snapshot);
+		}
+		else
+		{
+			m_layerPose.CopyFrom(m_pose);
+			SampleClip(binding, layer.time, m_layerPose);
+		}
+		if (fading)
+		{
+			m_fadePose.CopyFrom(m_layerPose);
+			SampleClip(m_clips[layer.nextClip], layer.nextTime, m_fadePose);
+			m_layerPose.Blend(m_fadePose, layer.fade, nullptr);
+		}
+		m_pose.Blend(m_layerPose, layer.weight, layer.boneMask.empty() ? nullptr : layer.boneMask.data());
+	}
+}
+
+void Animation::Update(float deltaTime)
+{
+	Prepare();
+	SamplePose(deltaTime);
+	ApplyPose();
+}
@@ -1 +1,218 @@
 #include <FishEngine/Animation/AnimationClip.hpp>
+#include <FishEngine/Animation/Avatar.hpp>
+#include <FishEngine/Debug.hpp>
+
+#include <algorithm>
+#include <set>
+
+using namespace FishEngine;
+
+namespace
+{
+	template<class Curve>
+	bool AnyKeys(const std::vector<Curve>& curves)
+	{
+		for (auto& c : curves)
+		{
+			if (c.curve.keyframeCount() > 0)
+				return true;
+		}
+		return false;
+	}
+
+	// keep the path, free the keys
+	template<class Curve>
+	void ReleaseKeys(std::vector<Curve>& curves)
+	{
+		for (auto& c : curves)
+			c.curve = decltype(c.curve)();
+	}
+}
+
+bool AnimationClip::HasSourceKeys() const
+{
+	return AnyKeys(m_positionCurve) || AnyKeys(m_eulersCurves) || AnyKeys(m_rotationCurves) || AnyKeys(m_scaleCurves);
+}
+
+std::vector<const Vector3Curve*> AnimationClip::GetEulersRotationSources() const
+{
+	std::set<std::string> quaternionPaths;
+	for (auto& c : m_rotationCurves)
+		quaternionPaths.insert(c.path);
+	std::vector<const Vector3Curve*> sources;
+	sources.reserve(m_eulersCurves.size());
+	for (auto& c : m_eulersCurves)
+	{
+		if (quaternionPaths.count(c.path) == 0)
+			sources.push_back(&c);
+	}
+	return sources;
+}
+
+CompressedAnimationClip::Report AnimationClip::Compress(const CompressedAnimationClip::Settings& settings)
+{
+	if (!m_sampledClip.IsValid())
+	{
+		if (!HasSourceKeys())
+		{
+			LogWarning(Format("AnimationClip [{}]: no source keys to compress", m_Name));
+			return CompressedAnimationClip::Report();
+		}
+		BuildSampledClip();
+	}
+	auto report = m_compressedClip.Compress(m_sampledClip, settings);
+	if (m_compressedClip.IsValid())
+	{
+		m_sampledClip.Clear();
+		ReleaseKeys(m_positionCurve);
+		ReleaseKeys(m_eulersCurves);
+		ReleaseKeys(m_rotationCurves);
+		ReleaseKeys(m_scaleCurves);
+	}
+	return report;
+}
+
+
+namespace
+{
+	constexpr uint32_t ClipInfoID = CookedFourCC('A', 'I', 'N', 'F');
+	constexpr uint32_t ClipPathsID = CookedFourCC('A', 'P', 'T', 'H');
+	constexpr uint32_t ClipNameID = CookedFourCC('A', 'N', 'A', 'M');
+
+	struct ClipInfo
+	{
+		float	frameRate;
+		float	length;
+		int32_t	wrapMode;
+		int32_t	compressed;
+		int32_t	positionCount;
+		int32_t	eulersCount;
+		int32_t	rotationCount;
+		int32_t	scaleCount;
+		int64_t	avatarFileID;	// 0: no avatar
+	};
+
+	template<class Curve>
+	void AppendPaths(const std::vector<Curve>& curves, std::vector<char>& paths)
+	{
+		for (auto& c : curves)
+		{
+			paths.insert(paths.end(), c.path.begin(), c.path.end());
+			paths.push_back('\0');
+		}
+	}
+
+	// read count '\0' terminated paths from [p, end)
+	template<class Curve>
+	bool ReadPaths(const char*& p, const char* end, int count, std::vector<Curve>& curves)
+	{
+		curves.resize(count);
+		for (auto& c : curves)
+		{
+			auto e = std::find(p, end, '\0');
+			if (e == end)
+				return false;
+			c.path.assign(p, e);
+			p = e + 1;
+		}
+		return true;
+	}
+}
+
+bool AnimationClip::SaveCooked(const std::string& path)
+{
+	const bool compressed = m_compressedClip.IsValid();
+	if (!compressed && !m_sampledClip.IsValid())
+	{
+		if (!HasSourceKeys())
+			return false;
+		BuildSampledClip();
+	}
+
+	ClipInfo info;
+	info.frameRate = frameRate;
+	info.length = length;
+	info.wrapMode = static_cast<int32_t>(wrapMode);
+	info.compressed = compressed ? 1 : 0;
+	info.positionCount = static_cast<int32_t>(m_positionCurve.size());
+	info.eulersCount = static_cast<int32_t>(m_eulersCurves.size());
+	info.rotationCount = static_cast<int32_t>(m_rotationCurves.size());
+	info.scaleCount = static_cast<int32_t>(m_scaleCurves.size());
+	info.avatarFileID = m_avatar != nullptr ? static_cast<int64_t>(m_avatar->GetLocalIdentifierInFile()) : 0;
+	if (m_avatar != nullptr && info.avatarFileID == 0)
+		return false;	// the avatar could not be found again on load
+
+	std::vector<char> paths;
+	AppendPaths(m_positionCurve, paths);
+	AppendPaths(m_eulersCurves, paths);
+	AppendPaths(m_rotationCurves, paths);
+	AppendPaths(m_scaleCurves, paths);
+
+	CookedFileWriter writer(CookedFileType::AnimationClip);
+	writer.AddValue(ClipInfoID, info);
+	writer.AddSection(ClipPathsID, paths);
+	const auto& name = GetName();
+	writer.AddSection(ClipNameID, std::vector<char>(name.begin(), name.end()));
+	if (compressed)
+		m_compressedClip.Cook(writer);
+	else
+		m_sampledClip.Cook(writer);
+	return writer.Write(path);
+}
+
+AnimationClip* AnimationClip::FromCookedFile(const std::string& path, const std::map<int64_t, Object*>& fileIDToObject)
+{
+	auto file = CookedFile::Open(path, CookedFileType::AnimationClip);
+	if (file == nullptr)
+		return nullptr;
+	auto info = file->GetValue<ClipInfo>(ClipInfoID);
+	auto paths = file->GetSection<char>(ClipPathsID);
+	auto name = file->GetSection<char>(ClipNameID);
+	if (info == nullptr)
+		return nullptr;
+
+	Avatar* avatar = nullptr;
+	if (info->avatarFileID != 0)
+	{
+		auto it = fileIDToObject.find(info->avatarFileID);
+		if (it != fileIDToObject.end() && it->second->GetClassID() == Avatar::ClassID)
+			avatar = it->second->As<Avatar>();
+		if (avatar == nullptr)
+		{
+			LogWarning(Format("{}: the avatar {} of the animation clip is missing", path, info->avatarFileID));
+			return nullptr;
+		}
+	}
+
+	// everything is checked before the clip is created, clips are never deleted(AssetManager owns them)
+	std::vector<Vector3Curve> positionCurves, eulersCurves, scaleCurves;
+	std::vector<QuaternionCurve> rotationCurves;
+	SampledAnimationClip sampled;
+	CompressedAnimationClip compressed;
+	const char* p = paths.begin();
+	bool ok = ReadPaths(p, paths.end(), info->positionCount, positionCurves)
+		&& ReadPaths(p, paths.end(), info->eulersCount, eulersCurves)
+		&& ReadPaths(p, paths.end(), info->rotationCount, rotationCurves)
+		&& ReadPaths(p, paths.end(), info->scaleCount, scaleCurves);
+	if (ok)
+		ok = info->compressed ? compressed.LoadCooked(file) : sampled.LoadCooked(file);
+	if (!ok)
+	{
+		LogWarning(Format("{}: bad animation clip", path));
+		return nullptr;
+	}
+
+	auto clip = new AnimationClip();
+	clip->SetName(std::string(name.begin(), name.end()));
+	clip->m_avatar = avatar;
+	clip->frameRate = info->frameRate;
+	clip->length = info->length;
+	clip->wrapMode = static_cast<WrapMode>(info->wrapMode);
+	clip->m_positionCurve = std::move(positionCurves);
+	clip->m_eulersCurves = std::move(eulersCurves);
+	clip->m_rotationCurves = std::move(rotationCurves);
+	clip->m_scaleCurves = std::move(scaleCurves);
+	clip->m_sampledClip = std::move(sampled);
+	clip->m_compressedClip = std::move(compressed);
+	return clip;
+}
@@ -1,6 +1,8 @@
 #include <FishEngine/Animation/AnimationCurve.hpp>
 #include <FishEngine/Animation/AnimationCurveUtility.hpp>
 
+#include <limits>
+
 using namespace FishEngine;
 
 template <class T>
@@ -140,6 +142,30 @@ T TAnimationCurve<T>::Evaluate(float time, bool loop) const
 
 	FindKeys(time, leftKeyIdx, rightKeyIdx);
 
+	return EvaluateSegment(time, leftKeyIdx, rightKeyIdx);
+}
+
+
+template <class T>
+T TAnimationCurve<T>::Evaluate(float time, AnimationCurveCursor& cursor, bool loop) const
+{
+	if (m_keyframes.size() == 0)
+		return getZero<T>();
+
+	AnimationCurveUtility::WrapTime(time, m_start, m_end, loop);
+
+	uint32_t leftKeyIdx;
+	uint32_t rightKeyIdx;
+
+	FindKeys(time, cursor, leftKeyIdx, rightKeyIdx);
+
+	return EvaluateSegment(time, leftKeyIdx, rightKeyIdx);
+}
+
+
+template <class T>
+T TAnimationCurve<T>::EvaluateSegment(float time, uint32_t leftKeyIdx, uint32_t rightKeyIdx) const
+{
 	// Evaluate curve as hermit cubic spline
 	auto & leftKey = m_keyframes[leftKeyIdx];
 	auto & rightKey = m_keyframes[rightKeyIdx];
@@ -178,6 +204,52 @@ T TAnimationCurve<T>::Evaluate(float time, bool loop) const
 }
 
 
+template <class T>
+void TAnimationCurve<T>::FindKeys(float time, AnimationCurveCursor& cursor, uint32_t& leftKey, uint32_t& rightKey) const
+{
+	const uint32_t last = (uint32_t)m_keyframes.size() - 1;
+
+	if (time >= cursor.segmentStart && time < cursor.segmentEnd && cursor.rightKey <= last)
+	{
+		// same segment as last time
+	}
+	else if (time >= cursor.segmentEnd && cursor.rightKey < last && time < m_keyframes[cursor.rightKey+1].time)
+	{
+		// moved into the next segment
+		cursor.leftKey = cursor.rightKey;
+		cursor.rightKey++;
+		cursor.segmentStart = cursor.segmentEnd;
+		cursor.segmentEnd = m_keyframes[cursor.rightKey].time;
+	}
+	else
+	{
+		// jumped(or looped), search from scratch
+		FindKeys(time, cursor.leftKey, cursor.rightKey);
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+		if (cursor.leftKey != cursor.rightKey)
+		{
+			cursor.segmentStart = m_keyframes[cursor.leftKey].time;
+			cursor.segmentEnd = m_keyframes[cursor.rightKey].time;
+		}
+		else if (time < m_keyframes[0].time)
+		{
+			// before the first key
+			cursor.segmentStart = -infinity;
+			cursor.segmentEnd = m_keyframes[0].time;
+		}
+		else
+		{
+			// at or after the last key
+			cursor.segmentStart = m_keyframes[last].time;
+			cursor.segmentEnd = infinity;
+		}
+	}
+
+	leftKey = cursor.leftKey;
+	rightKey = cursor.rightKey;
+}
+
+
 template <class T>
 void TAnimationCurve<T>::FindKeys(float time, uint32_t& leftKey, uint32_t& rightKey) const
 {
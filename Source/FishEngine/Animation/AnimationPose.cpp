@@ -0,0 +1,45 @@
+#include <FishEngine/Animation/AnimationPose.hpp>
+
+#include <algorithm>
+
+namespace FishEngine
+{
+	void AnimationPose::Resize(int boneCount)
+	{
+		positions.resize(boneCount);
+		rotations.resize(boneCount);
+		scales.resize(boneCount);
+	}
+
+
+	void AnimationPose::CopyFrom(const AnimationPose& other)
+	{
+		std::copy(other.positions.begin(), other.positions.end(), positions.begin());
+		std::copy(other.rotations.begin(), other.rotations.end(), rotations.begin());
+		std::copy(other.scales.begin(), other.scales.end(), scales.begin());
+	}
+
+
+	void AnimationPose::Blend(const AnimationPose& other, float weight, const float* boneWeights)
+	{
+		if (weight <= 0)
+			return;
+		const int boneCount = GetBoneCount();
+		for (int i = 0; i < boneCount; ++i)
+		{
+			const float w = boneWeights == nullptr ? weight : weight * boneWeights[i];
+			if (w <= 0)
+				continue;
+			if (w >= 1)
+			{
+				positions[i] = other.positions[i];
+				rotations[i] = other.rotations[i];
+				scales[i] = other.scales[i];
+				continue;
+			}
+			positions[i] = Vector3::LerpUnClamped(positions[i], other.positions[i], w);
+			rotations[i] = Quaternion::LerpUnclamped(rotations[i], other.rotations[i], w);	// normalized by the constructor
+			scales[i] = Vector3::LerpUnClamped(scales[i], other.scales[i], w);
+		}
+	}
+}
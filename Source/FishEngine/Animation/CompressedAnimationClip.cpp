@@ -0,0 +1,426 @@
+#include <FishEngine/Animation/CompressedAnimationClip.hpp>
+#include <FishEngine/Animation/SampledAnimationClip.hpp>
+#include <FishEngine/Animation/AnimationCurveUtility.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace FishEngine;
+
+namespace
+{
+	// longest run of frames one segment may replace, bounds the cost of the greedy reduction
+	constexpr int MaxSegmentFrames = 256;
+
+	constexpr float SmallestThreeRange = 0.70710678118f;	// 1/sqrt(2)
+
+	uint16_t QuantizeUnit(float v)
+	{
+		v = std::min(std::max(v, 0.0f), 1.0f);
+		return static_cast<uint16_t>(std::lround(v * 65535.0f));
+	}
+
+	float DequantizeUnit(uint32_t q)
+	{
+		return q * (1.0f / 65535.0f);
+	}
+
+	void PackQuaternion(const float q[4], uint16_t out[3])
+	{
+		int largest = 0;
+		for (int i = 1; i < 4; ++i)
+		{
+			if (std::fabs(q[i]) > std::fabs(q[largest]))
+				largest = i;
+		}
+		// q and -q are the same rotation, make the dropped component positive
+		const float sign = q[largest] < 0 ? -1.0f : 1.0f;
+		uint64_t bits = static_cast<uint64_t>(largest) << 45;
+		int shift = 30;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			float v = q[i] * sign / SmallestThreeRange * 0.5f + 0.5f;
+			v = std::min(std::max(v, 0.0f), 1.0f);
+			bits |= static_cast<uint64_t>(std::lround(v * 32767.0f)) << shift;
+			shift -= 15;
+		}
+		out[0] = static_cast<uint16_t>(bits >> 32);
+		out[1] = static_cast<uint16_t>(bits >> 16);
+		out[2] = static_cast<uint16_t>(bits);
+	}
+
+	void UnpackQuaternion(const uint16_t in[3], float q[4])
+	{
+		const uint64_t bits = (static_cast<uint64_t>(in[0]) << 32) | (static_cast<uint64_t>(in[1]) << 16) | in[2];
+		const int largest = static_cast<int>(bits >> 45) & 3;
+		int shift = 30;
+		float sum = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			float v = ((bits >> shift) & 0x7FFF) * (1.0f / 32767.0f);
+			v = (v - 0.5f) * 2.0f * SmallestThreeRange;
+			q[i] = v;
+			sum += v * v;
+			shift -= 15;
+		}
+		q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+	}
+
+	// lerp for vectors, nlerp on the shorter arc for quaternions
+	void Interpolate(const float* a, const float* b, float t, bool rotation, float* out)
+	{
+		if (!rotation)
+		{
+			for (int i = 0; i < 3; ++i)
+				out[i] = a[i] + (b[i] - a[i]) * t;
+			return;
+		}
+		float dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+		float tb = dot < 0 ? -t : t;
+		float ta = 1.0f - t;
+		float lengthSq = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			out[i] = a[i] * ta + b[i] * tb;
+			lengthSq += out[i] * out[i];
+		}
+		float invLength = 1.0f / std::sqrt(lengthSq);
+		for (int i = 0; i < 4; ++i)
+			out[i] *= invLength;
+	}
+
+	// max component error for vectors, angle in degrees for quaternions
+	float Error(const float* a, const float* b, bool rotation)
+	{
+		if (!rotation)
+			return std::max(std::max(std::fabs(a[0] - b[0]), std::fabs(a[1] - b[1])), std::fabs(a[2] - b[2]));
+		float dot = std::fabs(a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3]);
+		return 2.0f * std::acos(std::min(dot, 1.0f)) * Mathf::Rad2Deg;
+	}
+
+	// Greedy key reduction: from every kept key, extend the segment as far as all skipped frames
+	// stay within tolerance. source/decoded hold frameCount values of 3(or 4 for rotations) floats,
+	// decoded being the quantized values the runtime will see.
+	std::vector<int> ReduceKeys(const float* source, const float* decoded, int frameCount, bool rotation, float tolerance)
+	{
+		const int dim = rotation ? 4 : 3;
+		std::vector<int> keys;
+		keys.push_back(0);
+
+		// constant track
+		bool constant = true;
+		for (int f = 1; f < frameCount && constant; ++f)
+			constant = Error(decoded, source + f*dim, rotation) <= tolerance;
+		if (constant)
+			return keys;
+
+		float value[4];
+		int left = 0;
+		while (left < frameCount - 1)
+		{
+			int right = left + 1;
+			const int last = std::min(frameCount - 1, left + MaxSegmentFrames);
+			for (int candidate = right + 1; candidate <= last; ++candidate)
+			{
+				bool ok = true;
+				for (int f = left + 1; f < candidate && ok; ++f)
+				{
+					float t = float(f - left) / float(candidate - left);
+					Interpolate(decoded + left*dim, decoded + candidate*dim, t, rotation, value);
+					ok = Error(value, source + f*dim, rotation) <= tolerance;
+				}
+				if (!ok)
+					break;
+				right = candidate;
+			}
+			keys.push_back(right);
+			left = right;
+		}
+		return keys;
+	}
+}
+
+
+CompressedAnimationClip::Report CompressedAnimationClip::Compress(const SampledAnimationClip& source, const Settings& settings)
+{
+	Clear();
+	Report report;
+	const int frameCount = source.GetFrameCount();
+	if (frameCount == 0 || frameCount > 65536)
+		return report;
+
+	m_SampleRate = source.GetSampleRate();
+	m_Length = source.GetLength();
+	m_PositionCount = source.GetPositionCount();
+	m_RotationCount = source.GetRotationCount();
+	m_ScaleCount = source.GetScaleCount();
+	const int trackCount = m_PositionCount + m_RotationCount + m_ScaleCount;
+	m_Tracks.reserve(trackCount);
+
+	std::vector<float> values(frameCount * 4);
+	std::vector<float> decoded(frameCount * 4);
+	std::vector<uint16_t> packed(frameCount * 3);
+
+	for (int trackIndex = 0; trackIndex < trackCount; ++trackIndex)
+	{
+		const bool rotation = trackIndex >= m_PositionCount && trackIndex < m_PositionCount + m_RotationCount;
+		const bool scale = trackIndex >= m_PositionCount + m_RotationCount;
+		const int dim = rotation ? 4 : 3;
+		int channel;
+		if (rotation)
+			channel = source.GetRotationOffset() + 4 * (trackIndex - m_PositionCount);
+		else if (scale)
+			channel = source.GetScaleOffset() + 3 * (trackIndex - m_PositionCount - m_RotationCount);
+		else
+			channel = source.GetPositionOffset() + 3 * trackIndex;
+
+		Track track;
+		track.firstKey = static_cast<uint32_t>(m_KeyFrames.size());
+		track.range = 0;
+
+		// gather and quantize every frame of the track
+		if (rotation)
+		{
+			for (int f = 0; f < frameCount; ++f)
+			{
+				std::copy(source.GetFrame(f) + channel, source.GetFrame(f) + channel + 4, &values[f*4]);
+				PackQuaternion(&values[f*4], &packed[f*3]);
+				UnpackQuaternion(&packed[f*3], &decoded[f*4]);
+			}
+		}
+		else
+		{
+			float minValue[3], maxValue[3];
+			for (int i = 0; i < 3; ++i)
+				minValue[i] = maxValue[i] = source.GetFrame(0)[channel + i];
+			for (int f = 0; f < frameCount; ++f)
+			{
+				const float* v = source.GetFrame(f) + channel;
+				for (int i = 0; i < 3; ++i)
+				{
+					values[f*3 + i] = v[i];
+					minValue[i] = std::min(minValue[i], v[i]);
+					maxValue[i] = std::max(maxValue[i], v[i]);
+				}
+			}
+			track.range = static_cast<uint32_t>(m_Ranges.size() / 6);
+			for (int i = 0; i < 3; ++i)
+				m_Ranges.push_back(minValue[i]);
+			for (int i = 0; i < 3; ++i)
+				m_Ranges.push_back(maxValue[i] - minValue[i]);
+			const float* range = &m_Ranges[track.range * 6];
+			for (int f = 0; f < frameCount; ++f)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					float extent = range[3 + i];
+					float unit = extent > 0 ? (values[f*3 + i] - range[i]) / extent : 0.0f;
+					packed[f*3 + i] = QuantizeUnit(unit);
+					decoded[f*3 + i] = range[i] + extent * DequantizeUnit(packed[f*3 + i]);
+				}
+			}
+		}
+
+		const float tolerance = rotation ? settings.rotationError : (scale ? settings.scaleError : settings.positionError);
+		auto keys = ReduceKeys(values.data(), decoded.data(), frameCount, rotation, tolerance);
+		for (int f : keys)
+		{
+			m_KeyFrames.push_back(static_cast<uint16_t>(f));
+			m_KeyValues.insert(m_KeyValues.end(), &packed[f*3], &packed[f*3] + 3);
+		}
+		track.keyCount = static_cast<uint32_t>(keys.size());
+		m_Tracks.push_back(track);
+
+		// measure what Sample will actually return on every source frame
+		float value[4];
+		float maxError = 0;
+		for (int f = 0; f < frameCount; ++f)
+		{
+			EvaluateTrack(track, rotation, static_cast<float>(f), value);
+			maxError = std::max(maxError, Error(value, &values[f*dim], rotation));
+		}
+		float& reportError = rotation ? report.maxRotationError : (scale ? report.maxScaleError : report.maxPositionError);
+		reportError = std::max(reportError, maxError);
+	}
+
+	report.trackCount = trackCount;
+	report.sourceKeyCount = trackCount * frameCount;
+	report.keyCount = static_cast<int>(m_KeyFrames.size());
+	report.sourceBytes = sizeof(float) * source.GetStride() * frameCount;
+	report.compressedBytes = GetMemorySize();
+	return report;
+}
+
+
+void CompressedAnimationClip::Clear()
+{
+	m_SampleRate = 0;
+	m_Length = 0;
+	m_PositionCount = 0;
+	m_RotationCount = 0;
+	m_ScaleCount = 0;
+	m_Tracks.clear();
+	m_KeyFrames.clear();
+	m_KeyValues.clear();
+	m_Ranges.clear();
+	m_CookedFile.reset();
+	m_CookedTracks = {};
+	m_CookedKeyFrames = {};
+	m_CookedKeyValues = {};
+	m_CookedRanges = {};
+}
+
+
+namespace
+{
+	constexpr uint32_t CompressedInfoID = CookedFourCC('C', 'I', 'N', 'F');
+	constexpr uint32_t CompressedTracksID = CookedFourCC('C', 'T', 'R', 'K');
+	constexpr uint32_t CompressedKeyFramesID = CookedFourCC('C', 'K', 'F', 'R');
+	constexpr uint32_t CompressedKeyValuesID = CookedFourCC('C', 'K', 'V', 'L');
+	constexpr uint32_t CompressedRangesID = CookedFourCC('C', 'R', 'N', 'G');
+
+	struct CompressedInfo
+	{
+		float	sampleRate;
+		float	length;
+		int32_t	positionCount;
+		int32_t	rotationCount;
+		int32_t	scaleCount;
+	};
+}
+
+
+void CompressedAnimationClip::Cook(CookedFileWriter& writer) const
+{
+	CompressedInfo info;
+	info.sampleRate = m_SampleRate;
+	info.length = m_Length;
+	info.positionCount = m_PositionCount;
+	info.rotationCount = m_RotationCount;
+	info.scaleCount = m_ScaleCount;
+	writer.AddValue(CompressedInfoID, info);
+	writer.AddSection(CompressedTracksID, GetTracks());
+	writer.AddSection(CompressedKeyFramesID, GetKeyFrames());
+	writer.AddSection(CompressedKeyValuesID, GetKeyValues());
+	writer.AddSection(CompressedRangesID, GetRanges());
+}
+
+
+bool CompressedAnimationClip::LoadCooked(const std::shared_ptr<CookedFile>& file)
+{
+	Clear();
+	auto info = file->GetValue<CompressedInfo>(CompressedInfoID);
+	auto tracks = file->GetSection<Track>(CompressedTracksID);
+	auto keyFrames = file->GetSection<uint16_t>(CompressedKeyFramesID);
+	auto keyValues = file->GetSection<uint16_t>(CompressedKeyValuesID);
+	auto ranges = file->GetSection<float>(CompressedRangesID);
+	if (info == nullptr || !(info->sampleRate > 0) || !(info->length >= 0)
+		|| info->positionCount < 0 || info->rotationCount < 0 || info->scaleCount < 0
+		|| tracks.size != size_t(info->positionCount) + size_t(info->rotationCount) + size_t(info->scaleCount)
+		|| keyValues.size != keyFrames.size * 3 || ranges.size % 6 != 0)
+		return false;
+
+	// every track has keys inside the key sections, in increasing frame order, and vector tracks a range
+	for (size_t i = 0; i < tracks.size; ++i)
+	{
+		auto& track = tracks[i];
+		const bool rotation = i >= size_t(info->positionCount) && i < size_t(info->positionCount) + size_t(info->rotationCount);
+		if (track.keyCount == 0 || uint64_t(track.firstKey) + track.keyCount > keyFrames.size
+			|| (!rotation && track.range >= ranges.size / 6))
+			return false;
+		const uint16_t* frames = keyFrames.data + track.firstKey;
+		for (uint32_t k = 1; k < track.keyCount; ++k)
+		{
+			if (frames[k] <= frames[k-1])
+				return false;
+		}
+	}
+
+	m_SampleRate = info->sampleRate;
+	m_Length = info->length;
+	m_PositionCount = info->positionCount;
+	m_RotationCount = info->rotationCount;
+	m_ScaleCount = info->scaleCount;
+	m_CookedFile = file;
+	m_CookedTracks = tracks;
+	m_CookedKeyFrames = keyFrames;
+	m_CookedKeyValues = keyValues;
+	m_CookedRanges = ranges;
+	return true;
+}
+
+
+size_t CompressedAnimationClip::GetMemorySize() const
+{
+	return sizeof(Track) * GetTracks().size
+		+ sizeof(uint16_t) * (GetKeyFrames().size + GetKeyValues().size)
+		+ sizeof(float) * GetRanges().size;
+}
+
+
+void CompressedAnimationClip::DecodeKey(const Track& track, bool rotation, uint32_t key, float* out) const
+{
+	const uint16_t* packed = GetKeyValues().data + (track.firstKey + key) * 3;
+	if (rotation)
+	{
+		UnpackQuaternion(packed, out);
+		return;
+	}
+	const float* range = GetRanges().data + track.range * 6;
+	for (int i = 0; i < 3; ++i)
+		out[i] = range[i] + range[3 + i] * DequantizeUnit(packed[i]);
+}
+
+
+void CompressedAnimationClip::EvaluateTrack(const Track& track, bool rotation, float frame, float* out) const
+{
+	const uint16_t* frames = GetKeyFrames().data + track.firstKey;
+	const uint32_t right = static_cast<uint32_t>(std::upper_bound(frames, frames + track.keyCount, frame) - frames);
+	if (right == 0 || right == track.keyCount)
+	{
+		// constant track, or at/after the last key
+		DecodeKey(track, rotation, right == 0 ? 0 : right - 1, out);
+		return;
+	}
+	const uint32_t left = right - 1;
+	float a[4], b[4];
+	DecodeKey(track, rotation, left, a);
+	DecodeKey(track, rotation, right, b);
+	float t = (frame - frames[left]) / float(frames[right] - frames[left]);
+	Interpolate(a, b, t, rotation, out);
+}
+
+
+void CompressedAnimationClip::Sample(float time, bool loop, float* pose, const uint8_t* trackMask) const
+{
+	auto tracks = GetTracks();
+	if (tracks.empty())
+		return;
+	AnimationCurveUtility::WrapTime(time, 0, m_Length, loop);
+	const float frame = time * m_SampleRate;
+	const Track* track = tracks.data;
+	if (trackMask == nullptr)
+	{
+		for (int i = 0; i < m_PositionCount; ++i)
+			EvaluateTrack(*track++, false, frame, pose + GetPositionOffset() + 3*i);
+		for (int i = 0; i < m_RotationCount; ++i)
+			EvaluateTrack(*track++, true, frame, pose + GetRotationOffset() + 4*i);
+		for (int i = 0; i < m_ScaleCount; ++i)
+			EvaluateTrack(*track++, false, frame, pose + GetScaleOffset() + 3*i);
+		return;
+	}
+	const uint8_t* mask = trackMask;
+	for (int i = 0; i < m_PositionCount; ++i, ++track)
+		if (*mask++)
+			EvaluateTrack(*track, false, frame, pose + GetPositionOffset() + 3*i);
+	for (int i = 0; i < m_RotationCount; ++i, ++track)
+		if (*mask++)
+			EvaluateTrack(*track, true, frame, pose + GetRotationOffset() + 4*i);
+	for (int i = 0; i < m_ScaleCount; ++i, ++track)
+		if (*mask++)
+			EvaluateTrack(*track, false, frame, pose + GetScaleOffset() + 3*i);
+}
@@ -0,0 +1,310 @@
+#include <FishEngine/Animation/SampledAnimationClip.hpp>
+#include <FishEngine/Internal/SIMD.hpp>
+#include <FishEngine/Animation/AnimationClip.hpp>
+#include <FishEngine/Animation/AnimationCurveUtility.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if FE_SIMD_AVX
+#	include <immintrin.h>
+#elif FE_SIMD_SSE
+#	include <emmintrin.h>
+#endif
+
+namespace FishEngine
+{
+	// cursors: one per curve, kept across frames; frames are sampled in order so the cursor almost always hits
+	static void SampleCurves(const std::vector<Vector3Curve>& curves, float time, AnimationCurveCursor* cursors, float* frame, int offset)
+	{
+		for (size_t i = 0; i < curves.size(); ++i)
+		{
+			// same wrapping as Animation's per-curve playback
+			auto v = curves[i].curve.Evaluate(time, cursors[i], true);
+			float* dst = frame + offset + 3*i;
+			dst[0] = v.x;
+			dst[1] = v.y;
+			dst[2] = v.z;
+		}
+	}
+
+	// previous: rotations of the previous frame(nullptr on the first one), to stay on its hemisphere
+	// eulers: clip.GetEulersRotationSources()
+	static void SampleRotations(const AnimationClip& clip, const std::vector<const Vector3Curve*>& eulers, float time, AnimationCurveCursor* cursors, const float* previous, float* rotations)
+	{
+		float* dst = rotations;
+		for (auto c : eulers)
+		{
+			auto q = Quaternion::Euler(RotationOrder::XYZ, c->curve.Evaluate(time, *cursors++, true));
+			std::copy(q.m, q.m + 4, dst);
+			dst += 4;
+		}
+		for (auto& c : clip.m_rotationCurves)
+		{
+			auto q = c.curve.Evaluate(time, *cursors++, true);
+			q.NormalizeSelf();
+			std::copy(q.m, q.m + 4, dst);
+			dst += 4;
+		}
+		if (previous == nullptr)
+			return;
+		for (float* q = rotations; q < dst; q += 4, previous += 4)
+		{
+			if (q[0]*previous[0] + q[1]*previous[1] + q[2]*previous[2] + q[3]*previous[3] < 0)
+			{
+				for (int i = 0; i < 4; ++i)
+					q[i] = -q[i];
+			}
+		}
+	}
+
+	// max component error for vectors, angle in degrees for quaternions(a not normalized, b unit)
+	static float ResampleError(const float* a, const float* b, bool rotation)
+	{
+		if (!rotation)
+			return std::max(std::max(std::fabs(a[0] - b[0]), std::fabs(a[1] - b[1])), std::fabs(a[2] - b[2]));
+		float lengthSq = a[0]*a[0] + a[1]*a[1] + a[2]*a[2] + a[3]*a[3];
+		if (lengthSq <= 0)
+			return 180.0f;
+		float dot = std::fabs(a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3]) / std::sqrt(lengthSq);
+		return 2.0f * std::acos(std::min(dot, 1.0f)) * Mathf::Rad2Deg;
+	}
+
+	SampledAnimationClip::Report SampledAnimationClip::Build(const AnimationClip& clip, float sampleRate)
+	{
+		Clear();
+		Report report;
+		if (sampleRate <= 0)
+			sampleRate = clip.frameRate > 0 ? clip.frameRate : 30.0f;
+
+		// the clip is as long as its longest curve; clip.length is not always filled in
+		float length = clip.length;
+		auto UpdateLength = [&length](const std::vector<Vector3Curve>& curves) {
+			for (auto& c : curves)
+				length = std::max(length, c.curve.m_end);
+		};
+		const auto eulers = clip.GetEulersRotationSources();
+		UpdateLength(clip.m_positionCurve);
+		UpdateLength(clip.m_scaleCurves);
+		for (auto c : eulers)
+			length = std::max(length, c->curve.m_end);
+		for (auto& c : clip.m_rotationCurves)
+			length = std::max(length, c.curve.m_end);
+
+		const int positionChannels = 3 * static_cast<int>(clip.m_positionCurve.size());
+		const int rotationChannels = 4 * static_cast<int>(eulers.size() + clip.m_rotationCurves.size());
+		const int scaleChannels = 3 * static_cast<int>(clip.m_scaleCurves.size());
+		m_ChannelCount = positionChannels + rotationChannels + scaleChannels;
+		if (m_ChannelCount == 0)
+			return report;
+
+		// Uniform grid from 0 to exactly length: a last frame clamped to length would make the final
+		// interval shorter than the others, while Sample lerps it as a full one.
+		// The epsilon keeps lengths that are a whole number of frames(up to float error) at that count.
+		const int intervals = std::max(static_cast<int>(std::ceil(length * sampleRate - 1e-3f)), 1);
+		if (length > 0)
+			sampleRate = intervals / length;
+
+		m_SampleRate = sampleRate;
+		m_Length = length;
+		m_RotationOffset = positionChannels;
+		m_ScaleOffset = positionChannels + rotationChannels;
+		m_Stride = (m_ChannelCount + 7) & ~7;
+		m_FrameCount = length > 0 ? intervals + 1 : 1;
+		m_Keys.assign(m_FrameCount * m_Stride, 0.0f);
+
+		std::vector<AnimationCurveCursor> positionCursors(clip.m_positionCurve.size());
+		std::vector<AnimationCurveCursor> rotationCursors(eulers.size() + clip.m_rotationCurves.size());
+		std::vector<AnimationCurveCursor> scaleCursors(clip.m_scaleCurves.size());
+		auto SampleFrame = [&](float time, const float* previousRotations, float* frame) {
+			SampleCurves(clip.m_positionCurve, time, positionCursors.data(), frame, GetPositionOffset());
+			SampleRotations(clip, eulers, time, rotationCursors.data(), previousRotations, frame + GetRotationOffset());
+			SampleCurves(clip.m_scaleCurves, time, scaleCursors.data(), frame, GetScaleOffset());
+		};
+
+		for (int f = 0; f < m_FrameCount; ++f)
+		{
+			float time = f + 1 == m_FrameCount ? length : f / sampleRate;
+			float* frame = m_Keys.data() + f * m_Stride;
+			const float* previous = f == 0 ? nullptr : frame - m_Stride + GetRotationOffset();
+			SampleFrame(time, previous, frame);
+		}
+
+		// measure the Hermite to linear resampling error at a few points inside every interval
+		constexpr int Substeps = 4;
+		std::vector<float> pose(m_Stride);
+		std::vector<float> exact(m_Stride);
+		for (auto* cursors : { &positionCursors, &rotationCursors, &scaleCursors })
+			cursors->assign(cursors->size(), AnimationCurveCursor());
+		for (int f = 0; f + 1 < m_FrameCount; ++f)
+		{
+			for (int k = 1; k < Substeps; ++k)
+			{
+				float time = (f + k / static_cast<float>(Substeps)) / sampleRate;
+				Sample(time, false, pose.data());
+				SampleFrame(time, nullptr, exact.data());
+				for (int i = GetPositionOffset(); i < m_RotationOffset; i += 3)
+					report.maxPositionError = std::max(report.maxPositionError, ResampleError(&pose[i], &exact[i], false));
+				for (int i = m_RotationOffset; i < m_ScaleOffset; i += 4)
+					report.maxRotationError = std::max(report.maxRotationError, ResampleError(&pose[i], &exact[i], true));
+				for (int i = m_ScaleOffset; i < m_ChannelCount; i += 3)
+					report.maxScaleError = std::max(report.maxScaleError, ResampleError(&pose[i], &exact[i], false));
+			}
+		}
+		return report;
+	}
+
+
+	void SampledAnimationClip::Clear()
+	{
+		m_SampleRate = 0;
+		m_Length = 0;
+		m_FrameCount = 0;
+		m_ChannelCount = 0;
+		m_Stride = 0;
+		m_RotationOffset = 0;
+		m_ScaleOffset = 0;
+		m_Keys.clear();
+		m_CookedFile.reset();
+		m_CookedKeys = nullptr;
+	}
+
+
+	namespace
+	{
+		constexpr uint32_t SampledInfoID = CookedFourCC('S', 'I', 'N', 'F');
+		constexpr uint32_t SampledKeysID = CookedFourCC('S', 'K', 'E', 'Y');
+
+		struct SampledInfo
+		{
+			float	sampleRate;
+			float	length;
+			int32_t	frameCount;
+			int32_t	channelCount;
+			int32_t	stride;
+			int32_t	rotationOffset;
+			int32_t	scaleOffset;
+		};
+	}
+
+	void SampledAnimationClip::Cook(CookedFileWriter& writer) const
+	{
+		SampledInfo info;
+		info.sampleRate = m_SampleRate;
+		info.length = m_Length;
+		info.frameCount = m_FrameCount;
+		info.channelCount = m_ChannelCount;
+		info.stride = m_Stride;
+		info.rotationOffset = m_RotationOffset;
+		info.scaleOffset = m_ScaleOffset;
+		writer.AddValue(SampledInfoID, info);
+		writer.AddSection(SampledKeysID, ArrayView<float>(GetKeys(), static_cast<size_t>(m_FrameCount) * m_Stride));
+	}
+
+	bool SampledAnimationClip::LoadCooked(const std::shared_ptr<CookedFile>& file)
+	{
+		Clear();
+		auto info = file->GetValue<SampledInfo>(SampledInfoID);
+		auto keys = file->GetSection<float>(SampledKeysID);
+		// the layout Build makes: padded rows, positions/rotations/scales in order and whole
+		if (info == nullptr || !(info->sampleRate > 0) || !(info->length >= 0) || info->frameCount < 1
+			|| info->stride < 0 || info->stride % 8 != 0 || info->channelCount < 0 || info->channelCount > info->stride
+			|| info->rotationOffset < 0 || info->rotationOffset % 3 != 0
+			|| info->scaleOffset < info->rotationOffset || (info->scaleOffset - info->rotationOffset) % 4 != 0
+			|| info->channelCount < info->scaleOffset || (info->channelCount - info->scaleOffset) % 3 != 0
+			|| keys.size != static_cast<size_t>(info->frameCount) * static_cast<size_t>(info->stride))
+			return false;
+		m_SampleRate = info->sampleRate;
+		m_Length = info->length;
+		m_FrameCount = info->frameCount;
+		m_ChannelCount = info->channelCount;
+		m_Stride = info->stride;
+		m_RotationOffset = info->rotationOffset;
+		m_ScaleOffset = info->scaleOffset;
+		m_CookedFile = file;
+		m_CookedKeys = keys.data;
+		return true;
+	}
+
+
+	void SampledAnimationClip::Sample(float time, bool loop, float* pose) const
+	{
+		if (m_FrameCount == 0)
+			return;
+		AnimationCurveUtility::WrapTime(time, 0, m_Length, loop);
+		float f = time * m_SampleRate;
+		int frame0 = std::min(static_cast<int>(f), m_FrameCount - 1);
+		int frame1 = std::min(frame0 + 1, m_FrameCount - 1);
+		float alpha = f - frame0;
+		Lerp(GetFrame(frame0), GetFrame(frame1), alpha, pose, m_Stride);
+	}
+
+
+	void SampledAnimationClip::Lerp_Scalar(const float* a, const float* b, float alpha, float* out, int count)
+	{
+		for (int i = 0; i < count; ++i)
+			out[i] = a[i] + (b[i] - a[i]) * alpha;
+	}
+
+
+	void SampledAnimationClip::Lerp_SSE(const float* a, const float* b, float alpha, float* out, int count)
+	{
+#if FE_SIMD_SSE
+		const __m128 t = _mm_set1_ps(alpha);
+		for (int i = 0; i < count; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(a + i);
+			__m128 y = _mm_loadu_ps(b + i);
+			_mm_storeu_ps(out + i, _mm_add_ps(x, _mm_mul_ps(_mm_sub_ps(y, x), t)));
+		}
+#else
+		Lerp_Scalar(a, b, alpha, out, count);
+#endif
+	}
+
+
+	FE_TARGET_AVX void SampledAnimationClip::Lerp_AVX(const float* a, const float* b, float alpha, float* out, int count)
+	{
+#if FE_SIMD_AVX
+		const __m256 t = _mm256_set1_ps(alpha);
+		for (int i = 0; i < count; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(a + i);
+			__m256 y = _mm256_loadu_ps(b + i);
+			_mm256_storeu_ps(out + i, _mm256_add_ps(x, _mm256_mul_ps(_mm256_sub_ps(y, x), t)));
+		}
+#else
+		Lerp_SSE(a, b, alpha, out, count);
+#endif
+	}
+
+
+	void SampledAnimationClip::Lerp(const float* a, const float* b, float alpha, float* out, int count)
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+		{
+			Lerp_AVX(a, b, alpha, out, count);
+			return;
+		}
+#endif
+#if FE_SIMD_SSE
+		Lerp_SSE(a, b, alpha, out, count);
+#else
+		Lerp_Scalar(a, b, alpha, out, count);
+#endif
+	}
+
+	const char* SampledAnimationClip::KernelName()
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+			return "AVX";
+#endif
+#if FE_SIMD_SSE
+		return "SSE";
+#else
+		return "Scalar";
+#endif
+	}
+}
@@ -9,13 +9,17 @@ void FishEngine::SkinnedMeshRenderer::UpdateMatrixPalette() const
 		m_MatrixPalette.resize(m_Mesh->GetBoneCount());
 	
 	const auto& worldToLocal = GetGameObject()->GetTransform()->GetWorldToLocalMatrix();
-	const auto& bindposes = m_Mesh->m_bindposes;
+	auto bindposes = m_Mesh->GetBindposes();
+	auto& boneBounds = m_Mesh->GetBoneBounds();
+	m_AnimatedBounds = Bounds();
 	for (uint32_t i = 0; i < m_MatrixPalette.size(); ++i)
 	{
 		auto bone = m_Bones[i];
 		auto& mat = m_MatrixPalette[i];
 		// we multiply worldToLocal because we assume that the mesh is in local space in shader.
 		mat = worldToLocal * bone->GetLocalToWorldMatrix() * bindposes[i];
+		// culled with these, limbs move far out of the bind pose bounds
+		m_AnimatedBounds.Encapsulate(boneBounds[i].Transform(mat));
 
 #if Enable_GPU_Skinning
 		// macOS bug
@@ -39,17 +43,30 @@ void FishEngine::SkinnedMeshRenderer::UpdateMatrixPalette() const
 			m_SkinnedVertexNormal.resize(mesh->m_vertexCount);
 		}
 
-		for (int i = 0; i < mesh->m_vertexCount; i++)
+		SkinningData data;
+		if (m_SkinningMethod == SkinningMethod::DualQuaternion)
 		{
-			auto boneIndex = mesh->m_boneWeights[i].boneIndex;
-			auto boneWeight = mesh->m_boneWeights[i].weight;
-			Matrix4x4 boneTransformation = m_MatrixPalette[boneIndex[0]] * boneWeight[0];
-			boneTransformation += m_MatrixPalette[boneIndex[1]] * boneWeight[1];
-			boneTransformation += m_MatrixPalette[boneIndex[2]] * boneWeight[2];
-			boneTransformation += m_MatrixPalette[boneIndex[3]] * boneWeight[3];
-			m_SkinnedVertexPosition[i] = boneTransformation.MultiplyPoint3x4(mesh->m_vertices[i]);
-			m_SkinnedVertexNormal[i] = boneTransformation.MultiplyVector(mesh->m_normals[i]);
+			m_DualQuaternionPalette.resize(m_MatrixPalette.size());
+			for (size_t i = 0; i < m_MatrixPalette.size(); ++i)
+				m_DualQuaternionPalette[i] = DualQuaternion(m_MatrixPalette[i]);
+			data.palette = nullptr;
+			data.dualQuaternions = m_DualQuaternionPalette.data();
 		}
+		else
+		{
+			m_MatrixPalette3x4.resize(m_MatrixPalette.size());
+			for (size_t i = 0; i < m_MatrixPalette.size(); ++i)
+				m_MatrixPalette3x4[i] = Matrix3x4(m_MatrixPalette[i]);
+			data.palette = m_MatrixPalette3x4.data();
+			data.dualQuaternions = nullptr;
+		}
+		// straight from the mapped pages if the mesh is cooked
+		data.boneWeights = mesh->GetBoneWeights().data;
+		data.positions = mesh->GetVertices().data;
+		data.normals = mesh->GetNormals().data;
+		data.skinnedPositions = m_SkinnedVertexPosition.data();
+		data.skinnedNormals = m_SkinnedVertexNormal.data();
+		Skinning::SkinVerticesParallel(data, mesh->m_vertexCount, m_SkinningMethod);
 	}
 	
 	mesh->UpdateCPUSkinneing(m_SkinnedVertexPosition, m_SkinnedVertexNormal);
@@ -6,6 +6,7 @@
 #include <FishEngine/System/InputSystem.hpp>
 #include <FishEngine/System/PhysicsSystem.hpp>
 #include <FishEngine/System/AnimationSystem.hpp>
+#include <FishEngine/System/JobSystem.hpp>
 #include <FishEngine/Render/Material.hpp>
 #include <FishEngine/Scene.hpp>
 
@@ -29,6 +30,7 @@ namespace FishEngine
 		puts("======== Init ========");
 		//Debug::Init();
 		//Debug::SetColorMode(true);
+		JobSystem::GetInstance().Init();
 		TextureSampler::StaticInit();
 		Mesh::StaticInit();
 		Pipeline::StaticInit();
@@ -45,9 +47,11 @@ namespace FishEngine
 
 		//AnimationSystem::GetInstance().Start();
 
-		for (auto o : Object::FindObjectsOfType<GameObject>())
+		// by index: Script::Start may instantiate GameObjects, which are appended to the list(and started too)
+		auto& gameObjects = Object::FindObjectsOfType<GameObject>();
+		for (size_t i = 0; i < gameObjects.size(); ++i)
 		{
-			auto go = (GameObject*)o;
+			auto go = (GameObject*)gameObjects[i];
 			for (auto comp : go->GetAllComponents())
 			{
 				 if (comp->GetClassID() == Script::ClassID)
@@ -97,6 +101,7 @@ namespace FishEngine
 		SceneManager::StaticClean();
 		ScriptSystem::GetInstance().Clean();	// put this after Scene::Clean
 		AssetManager::GetInstance().ClearAll();
+		JobSystem::GetInstance().Clean();
 		
 		// check memory leak
 		int a = Object::GetInstanceCounter();
@@ -105,15 +110,17 @@ namespace FishEngine
 		{
 			LogError(Format("Memory Leak in FishEngine::Clean(): [{}] objects created but only [{}] objects deleted", a, b));
 			
-			for (auto& p : Object::GetAllObjects())
+			auto& all = Object::GetAllObjects();
+			for (int classID = 0; classID < static_cast<int>(all.size()); ++classID)
 			{
-				if (p.second.size() != 0)
+				auto& objects = all[classID];
+				if (objects.size() != 0)
 				{
-//					int instanceID = (*p.second.begin())->GetInstanceID();
-					LogError(Format("Class[ID:{}, name:{}] has {} obj", p.first, GetNameByClassID(p.first), p.second.size()));
-					if (p.first == GameObject::ClassID)
+//					int instanceID = objects.front()->GetInstanceID();
+					LogError(Format("Class[ID:{}, name:{}] has {} obj", classID, GetNameByClassID(classID), objects.size()));
+					if (classID == GameObject::ClassID)
 					{
-						for (auto go : p.second)
+						for (auto go : objects)
 						{
 							printf("GameObject %s, %d\n", go->GetName().c_str(), go->GetInstanceID());
 						}
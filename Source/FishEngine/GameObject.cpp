@@ -7,6 +7,9 @@
 #include <pybind11/embed.h>
 #include <FishEngine/Debug.hpp>
 #include <FishEngine/Prefab.hpp>
+#include <FishEngine/Component/MeshFilter.hpp>
+#include <FishEngine/Component/Renderer.hpp>
+#include <FishEngine/Render/RendererRegistry.hpp>
 
 namespace FishEngine
 {
@@ -23,6 +26,7 @@ namespace FishEngine
 			m_Scene->AddRootTransform(m_Transform);
 			m_Transform->m_GameObject = this;
 			m_Component.push_back(m_Transform);
+			AddToComponentTable(m_Transform);
 		}
 		else if (flag == GameObjectConstructionFlag::WithRectTransform)
 		{
@@ -98,8 +102,40 @@ namespace FishEngine
 		// do not add it twice!
 		auto pos = std::find(m_Component.begin(), m_Component.end(), comp);
 		if (pos == m_Component.end())
+		{
 			m_Component.push_back(comp);
+			AddToComponentTable(comp);
+		}
 		comp->m_GameObject = this;
+
+		if (comp->Is<Renderer>())
+			RendererRegistry::GetInstance().SetDirty(static_cast<Renderer*>(comp));
+		else if (comp->GetClassID() == MeshFilter::ClassID)
+			RendererRegistry::GetInstance().OnMeshFilterChanged(static_cast<MeshFilter*>(comp));
+	}
+
+	void GameObject::AddToComponentTable(Component* comp)
+	{
+		const int classID = comp->GetClassID();
+		int count = m_ComponentTableCount;
+		if (count > ComponentTableSize)
+			count = ComponentTableSize;
+		for (int i = 0; i < count; ++i)
+		{
+			if (m_ComponentTable[i].classID == classID)
+				return;		// GetComponent returns the first one
+		}
+		if (m_ComponentTableCount < ComponentTableSize)
+			m_ComponentTable[m_ComponentTableCount] = {classID, comp};
+		m_ComponentTableCount++;
+	}
+
+	void GameObject::SetActive(bool active)
+	{
+		if (m_IsActive == active)
+			return;
+		m_IsActive = active;
+		RendererRegistry::GetInstance().OnHierarchyChanged(this);
 	}
 
 	
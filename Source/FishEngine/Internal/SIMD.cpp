@@ -0,0 +1,45 @@
+#include <FishEngine/Internal/SIMD.hpp>
+
+#if FE_SIMD_AVX
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+namespace FishEngine
+{
+	static bool DetectAVX()
+	{
+#if FE_SIMD_AVX
+		constexpr unsigned OSXSAVE = 1u << 27;
+		constexpr unsigned AVX = 1u << 28;
+#	if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		const unsigned ecx = static_cast<unsigned>(info[2]);
+		if ((ecx & OSXSAVE) == 0 || (ecx & AVX) == 0)
+			return false;
+		const unsigned long long xcr0 = _xgetbv(0);
+#	else
+		unsigned eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			return false;
+		if ((ecx & OSXSAVE) == 0 || (ecx & AVX) == 0)
+			return false;
+		unsigned xcr0, xcr0High;
+		__asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+#	endif
+		return (xcr0 & 6) == 6;	// xmm and ymm state
+#else
+		return false;
+#endif
+	}
+
+	bool CPU::HasAVX()
+	{
+		static const bool hasAVX = DetectAVX();
+		return hasAVX;
+	}
+}
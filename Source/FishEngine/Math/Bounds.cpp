@@ -1,5 +1,6 @@
 #include <FishEngine/Math/Bounds.hpp>
 #include <FishEngine/Math/Ray.hpp>
+#include <FishEngine/Math/Matrix4x4.hpp>
 
 using namespace FishEngine;
 
@@ -29,3 +30,19 @@ bool FishEngine::Bounds::IntersectRay(const Ray& ray, float* outDistance /*= nul
 	}
 	return true;
 }
+
+FishEngine::Bounds FishEngine::Bounds::Transform(const Matrix4x4& matrix) const
+{
+	if (!IsValid())
+		return *this;
+	// Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990
+	Bounds result;
+	result.m_center = matrix.MultiplyPoint3x4(m_center);
+	for (int i = 0; i < 3; ++i)
+	{
+		result.m_extents[i] = std::fabs(matrix.m[i][0]) * m_extents.x
+			+ std::fabs(matrix.m[i][1]) * m_extents.y
+			+ std::fabs(matrix.m[i][2]) * m_extents.z;
+	}
+	return result;
+}
@@ -0,0 +1,46 @@
+#include <FishEngine/Math/Frustum.hpp>
+#include <FishEngine/Math/Matrix4x4.hpp>
+
+namespace FishEngine
+{
+	FrustumPlanes FrustumPlanes::FromMatrix(const Matrix4x4& m)
+	{
+		// Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"
+		// clip space z is in [-1, 1](OpenGL)
+		FrustumPlanes result;
+		const Vector4 r0 = m.rows[0];
+		const Vector4 r1 = m.rows[1];
+		const Vector4 r2 = m.rows[2];
+		const Vector4 r3 = m.rows[3];
+		result.planes[Left]   = r3 + r0;
+		result.planes[Right]  = r3 - r0;
+		result.planes[Bottom] = r3 + r1;
+		result.planes[Top]    = r3 - r1;
+		result.planes[Near]   = r3 + r2;
+		result.planes[Far]    = r3 - r2;
+		for (auto& p : result.planes)
+		{
+			float len = Mathf::Sqrt(p.x*p.x + p.y*p.y + p.z*p.z);
+			if (len > 0)
+				p *= 1.0f / len;
+		}
+		return result;
+	}
+
+	bool FrustumPlanes::Intersects(const Bounds& worldBounds) const
+	{
+		if (!worldBounds.IsValid())
+			return true;
+		const Vector3 c = worldBounds.center();
+		const Vector3 e = worldBounds.extents();
+		for (auto& p : planes)
+		{
+			// signed distance of center + projected radius of the box on the plane normal
+			float d = p.x*c.x + p.y*c.y + p.z*c.z + p.w;
+			float r = std::fabs(p.x)*e.x + std::fabs(p.y)*e.y + std::fabs(p.z)*e.z;
+			if (d + r < 0)
+				return false;
+		}
+		return true;
+	}
+}
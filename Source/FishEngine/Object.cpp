@@ -1,11 +1,115 @@
 #include <FishEngine/Object.hpp>
 
+#include <cstdlib>
+#include <mutex>
+
 namespace FishEngine
 {
-    int Object::s_InstanceCounter = 0;
-	int Object::s_DeleteCounter = 0;
-	
-	std::unordered_map<int, std::unordered_set<Object*>> Object::s_Objects;
-	
-	
+	std::atomic<int> Object::s_InstanceCounter {0};
+	std::atomic<int> Object::s_DeleteCounter {0};
+
+	namespace
+	{
+		struct Slot
+		{
+			Object*		object = nullptr;
+			uint32_t	generation = 0;
+		};
+
+		struct ObjectRegistry
+		{
+			std::mutex							mutex;
+			// per-ClassID dense lists, swap-and-pop removal. Sized once: the lists never move, so the references
+			// returned by FindObjectsOfType stay valid when objects of a new ClassID are created
+			std::vector<std::vector<Object*>>	objects = std::vector<std::vector<Object*>>(Object::MaxClassID);
+			std::vector<Slot>					slots = std::vector<Slot>(1);	// slot 0 is the invalid handle
+			std::vector<uint32_t>				freeSlots;
+		};
+
+		// Built on first use, objects may be created during the static initialization of other translation units.
+		// Never destroyed, so static objects can still unregister during exit.
+		ObjectRegistry& GetRegistry()
+		{
+			static ObjectRegistry* registry = new ObjectRegistry;
+			return *registry;
+		}
+	}
+
+
+	const std::vector<Object*>& Object::FindObjectsOfType(int classID)
+	{
+		static const std::vector<Object*> empty;
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (classID < 0 || classID >= static_cast<int>(registry.objects.size()))
+			return empty;
+		return registry.objects[classID];
+	}
+
+
+	const std::vector<std::vector<Object*>>& Object::GetAllObjects()
+	{
+		return GetRegistry().objects;
+	}
+
+
+	ObjectHandle Object::GetHandle() const
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		return ObjectHandle{m_HandleIndex, registry.slots[m_HandleIndex].generation};
+	}
+
+
+	Object* Object::Resolve(ObjectHandle handle)
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (handle.index == 0 || handle.index >= registry.slots.size())
+			return nullptr;
+		auto& slot = registry.slots[handle.index];
+		return slot.generation == handle.generation ? slot.object : nullptr;
+	}
+
+
+	void Object::Register()
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (registry.freeSlots.empty())
+		{
+			m_HandleIndex = static_cast<uint32_t>(registry.slots.size());
+			registry.slots.emplace_back();
+		}
+		else
+		{
+			m_HandleIndex = registry.freeSlots.back();
+			registry.freeSlots.pop_back();
+		}
+		registry.slots[m_HandleIndex].object = this;
+
+		if (m_ClassID < 0 || m_ClassID >= MaxClassID)
+			abort();	// raise MaxClassID
+		auto& list = registry.objects[m_ClassID];
+		m_ClassListIndex = static_cast<int>(list.size());
+		list.push_back(this);
+	}
+
+
+	void Object::Unregister()
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		auto& slot = registry.slots[m_HandleIndex];
+		slot.object = nullptr;
+		slot.generation++;		// invalidates outstanding handles
+		registry.freeSlots.push_back(m_HandleIndex);
+
+		auto& list = registry.objects[m_ClassID];
+		Assert(list[m_ClassListIndex] == this);
+		auto last = list.back();
+		list[m_ClassListIndex] = last;
+		last->m_ClassListIndex = m_ClassListIndex;
+		list.pop_back();
+	}
 }
@@ -0,0 +1,247 @@
+#include <FishEngine/Render/Culling.hpp>
+#include <FishEngine/Internal/SIMD.hpp>
+
+#include <cmath>
+
+#if FE_SIMD_AVX
+#	include <immintrin.h>
+#elif FE_SIMD_SSE
+#	include <emmintrin.h>
+#endif
+
+namespace FishEngine
+{
+	// large enough to pass every plane, small enough to not produce inf/nan when multiplied by 0
+	constexpr float kInfiniteExtent = 1e30f;
+
+	void BoundsCache::Clear()
+	{
+		m_Count = 0;
+		m_CenterX.clear();
+		m_CenterY.clear();
+		m_CenterZ.clear();
+		m_ExtentX.clear();
+		m_ExtentY.clear();
+		m_ExtentZ.clear();
+	}
+
+	void BoundsCache::Reserve(int count)
+	{
+		size_t padded = (count + 7) & ~7;
+		m_CenterX.reserve(padded);
+		m_CenterY.reserve(padded);
+		m_CenterZ.reserve(padded);
+		m_ExtentX.reserve(padded);
+		m_ExtentY.reserve(padded);
+		m_ExtentZ.reserve(padded);
+	}
+
+	void BoundsCache::Add(const Bounds& bounds)
+	{
+		if ((m_Count & 7) == 0)
+		{
+			size_t padded = m_Count + 8;
+			m_CenterX.resize(padded, 0.f);
+			m_CenterY.resize(padded, 0.f);
+			m_CenterZ.resize(padded, 0.f);
+			m_ExtentX.resize(padded, 0.f);
+			m_ExtentY.resize(padded, 0.f);
+			m_ExtentZ.resize(padded, 0.f);
+		}
+
+		const int i = m_Count;
+		if (bounds.IsValid())
+		{
+			auto c = bounds.center();
+			auto e = bounds.extents();
+			m_CenterX[i] = c.x;
+			m_CenterY[i] = c.y;
+			m_CenterZ[i] = c.z;
+			m_ExtentX[i] = e.x;
+			m_ExtentY[i] = e.y;
+			m_ExtentZ[i] = e.z;
+		}
+		else
+		{
+			m_CenterX[i] = m_CenterY[i] = m_CenterZ[i] = 0.f;
+			m_ExtentX[i] = m_ExtentY[i] = m_ExtentZ[i] = kInfiniteExtent;
+		}
+		++m_Count;
+	}
+
+
+	static void ResetMask(int count, std::vector<uint32_t>& outMask)
+	{
+		outMask.assign((count + 31) / 32, 0u);
+	}
+
+	// clear the bits of the padding boxes
+	static void TrimMask(int count, std::vector<uint32_t>& outMask)
+	{
+		int tail = count & 31;
+		if (tail != 0)
+			outMask.back() &= (1u << tail) - 1u;
+	}
+
+
+	void Culling::CullBounds_Scalar(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask)
+	{
+		const int count = bounds.size();
+		ResetMask(count, outMask);
+		const float* cx = bounds.centerX();
+		const float* cy = bounds.centerY();
+		const float* cz = bounds.centerZ();
+		const float* ex = bounds.extentX();
+		const float* ey = bounds.extentY();
+		const float* ez = bounds.extentZ();
+
+		for (int i = 0; i < count; ++i)
+		{
+			bool visible = true;
+			for (auto& p : frustum.planes)
+			{
+				float d = p.x*cx[i] + p.y*cy[i] + p.z*cz[i] + p.w;
+				float r = std::fabs(p.x)*ex[i] + std::fabs(p.y)*ey[i] + std::fabs(p.z)*ez[i];
+				if (d + r < 0)
+				{
+					visible = false;
+					break;
+				}
+			}
+			if (visible)
+				outMask[i >> 5] |= 1u << (i & 31);
+		}
+	}
+
+
+	void Culling::CullBounds_SSE(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask)
+	{
+#if FE_SIMD_SSE
+		const int count = bounds.size();
+		ResetMask(count, outMask);
+		const float* cx = bounds.centerX();
+		const float* cy = bounds.centerY();
+		const float* cz = bounds.centerZ();
+		const float* ex = bounds.extentX();
+		const float* ey = bounds.extentY();
+		const float* ez = bounds.extentZ();
+
+		__m128 px[6], py[6], pz[6], pw[6], apx[6], apy[6], apz[6];
+		for (int j = 0; j < 6; ++j)
+		{
+			auto& p = frustum.planes[j];
+			px[j] = _mm_set1_ps(p.x);
+			py[j] = _mm_set1_ps(p.y);
+			pz[j] = _mm_set1_ps(p.z);
+			pw[j] = _mm_set1_ps(p.w);
+			apx[j] = _mm_set1_ps(std::fabs(p.x));
+			apy[j] = _mm_set1_ps(std::fabs(p.y));
+			apz[j] = _mm_set1_ps(std::fabs(p.z));
+		}
+		const __m128 zero = _mm_setzero_ps();
+
+		for (int i = 0; i < count; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(cx + i);
+			__m128 y = _mm_loadu_ps(cy + i);
+			__m128 z = _mm_loadu_ps(cz + i);
+			__m128 u = _mm_loadu_ps(ex + i);
+			__m128 v = _mm_loadu_ps(ey + i);
+			__m128 w = _mm_loadu_ps(ez + i);
+			__m128 outside = zero;
+			for (int j = 0; j < 6; ++j)
+			{
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[j], x), _mm_mul_ps(py[j], y)), _mm_add_ps(_mm_mul_ps(pz[j], z), pw[j]));
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(apx[j], u), _mm_mul_ps(apy[j], v)), _mm_mul_ps(apz[j], w));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+			}
+			uint32_t bits = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xFu;
+			outMask[i >> 5] |= bits << (i & 31);
+		}
+		TrimMask(count, outMask);
+#else
+		CullBounds_Scalar(frustum, bounds, outMask);
+#endif
+	}
+
+
+	FE_TARGET_AVX void Culling::CullBounds_AVX(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask)
+	{
+#if FE_SIMD_AVX
+		const int count = bounds.size();
+		ResetMask(count, outMask);
+		const float* cx = bounds.centerX();
+		const float* cy = bounds.centerY();
+		const float* cz = bounds.centerZ();
+		const float* ex = bounds.extentX();
+		const float* ey = bounds.extentY();
+		const float* ez = bounds.extentZ();
+
+		__m256 px[6], py[6], pz[6], pw[6], apx[6], apy[6], apz[6];
+		for (int j = 0; j < 6; ++j)
+		{
+			auto& p = frustum.planes[j];
+			px[j] = _mm256_set1_ps(p.x);
+			py[j] = _mm256_set1_ps(p.y);
+			pz[j] = _mm256_set1_ps(p.z);
+			pw[j] = _mm256_set1_ps(p.w);
+			apx[j] = _mm256_set1_ps(std::fabs(p.x));
+			apy[j] = _mm256_set1_ps(std::fabs(p.y));
+			apz[j] = _mm256_set1_ps(std::fabs(p.z));
+		}
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (int i = 0; i < count; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(cx + i);
+			__m256 y = _mm256_loadu_ps(cy + i);
+			__m256 z = _mm256_loadu_ps(cz + i);
+			__m256 u = _mm256_loadu_ps(ex + i);
+			__m256 v = _mm256_loadu_ps(ey + i);
+			__m256 w = _mm256_loadu_ps(ez + i);
+			__m256 outside = zero;
+			for (int j = 0; j < 6; ++j)
+			{
+				__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[j], x), _mm256_mul_ps(py[j], y)), _mm256_add_ps(_mm256_mul_ps(pz[j], z), pw[j]));
+				__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(apx[j], u), _mm256_mul_ps(apy[j], v)), _mm256_mul_ps(apz[j], w));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+			}
+			uint32_t bits = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFFu;
+			outMask[i >> 5] |= bits << (i & 31);
+		}
+		TrimMask(count, outMask);
+#else
+		CullBounds_SSE(frustum, bounds, outMask);
+#endif
+	}
+
+
+	void Culling::CullBounds(const FrustumPlanes& frustum, const BoundsCache& bounds, std::vector<uint32_t>& outMask)
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+		{
+			CullBounds_AVX(frustum, bounds, outMask);
+			return;
+		}
+#endif
+#if FE_SIMD_SSE
+		CullBounds_SSE(frustum, bounds, outMask);
+#else
+		CullBounds_Scalar(frustum, bounds, outMask);
+#endif
+	}
+
+	const char* Culling::KernelName()
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+			return "AVX";
+#endif
+#if FE_SIMD_SSE
+		return "SSE";
+#else
+		return "Scalar";
+#endif
+	}
+}
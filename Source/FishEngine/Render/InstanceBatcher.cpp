@@ -0,0 +1,64 @@
+#include <FishEngine/Render/InstanceBatcher.hpp>
+
+namespace FishEngine
+{
+	void InstanceBatcher::Clear()
+	{
+		m_Items.clear();
+		m_KeyToBatch.clear();
+		m_Batches.clear();
+		m_Matrices.clear();
+		m_ObjectIndices.clear();
+	}
+
+	void InstanceBatcher::Add(Mesh* mesh, Material* material, const Matrix4x4& modelMatrix, int objectIndex, bool instanceable)
+	{
+		int batch = -1;
+		if (instanceable)
+		{
+			BatchKey key{mesh, material};
+			auto it = m_KeyToBatch.find(key);
+			if (it != m_KeyToBatch.end())
+			{
+				batch = it->second;
+			}
+			else
+			{
+				batch = static_cast<int>(m_Batches.size());
+				m_KeyToBatch.emplace(key, batch);
+			}
+		}
+		else
+		{
+			batch = static_cast<int>(m_Batches.size());
+		}
+
+		if (batch == static_cast<int>(m_Batches.size()))
+			m_Batches.push_back({mesh, material, 0, 0});
+		m_Batches[batch].count++;
+		m_Items.push_back({modelMatrix, objectIndex, batch});
+	}
+
+	void InstanceBatcher::Build()
+	{
+		int offset = 0;
+		for (auto& b : m_Batches)
+		{
+			b.first = offset;
+			offset += b.count;
+		}
+
+		m_Matrices.resize(m_Items.size());
+		m_ObjectIndices.resize(m_Items.size());
+		std::vector<int> cursor(m_Batches.size());
+		for (size_t i = 0; i < m_Batches.size(); ++i)
+			cursor[i] = m_Batches[i].first;
+
+		for (auto& item : m_Items)
+		{
+			int dst = cursor[item.batch]++;
+			m_Matrices[dst] = item.modelMatrix;
+			m_ObjectIndices[dst] = item.objectIndex;
+		}
+	}
+}
@@ -4,6 +4,7 @@
 #include <FishEngine/Debug.hpp>
 
 #include <sstream>
+#include <algorithm>
 #include <cassert>
 
 constexpr int PositionIndex = 0;
@@ -87,11 +88,203 @@ namespace FishEngine
 		return mesh;
 	}
 	
+
+	namespace
+	{
+		constexpr uint32_t MeshInfoID = CookedFourCC('M', 'I', 'N', 'F');
+		constexpr uint32_t MeshVerticesID = CookedFourCC('V', 'P', 'O', 'S');
+		constexpr uint32_t MeshNormalsID = CookedFourCC('V', 'N', 'R', 'M');
+		constexpr uint32_t MeshUVID = CookedFourCC('V', 'U', 'V', '0');
+		constexpr uint32_t MeshTangentsID = CookedFourCC('V', 'T', 'A', 'N');
+		constexpr uint32_t MeshTrianglesID = CookedFourCC('I', 'N', 'D', 'X');
+		constexpr uint32_t MeshSubMeshesID = CookedFourCC('S', 'U', 'B', 'M');
+		constexpr uint32_t MeshBindposesID = CookedFourCC('B', 'I', 'N', 'D');
+		constexpr uint32_t MeshBoneWeightsID = CookedFourCC('B', 'W', 'G', 'T');
+		constexpr uint32_t MeshBoneNamesID = CookedFourCC('B', 'O', 'N', 'E');
+
+		struct MeshInfo
+		{
+			uint32_t	vertexCount;
+			uint32_t	triangleCount;
+			int32_t		subMeshCount;
+			int32_t		skinned;
+			Vector3		boundsMin;
+			Vector3		boundsMax;
+		};
+
+		// nullptr if the streams of file agree with info, else what is wrong.
+		// Vertex streams are empty or have vertexCount elements, indices and bone indices are in range.
+		const char* CheckCookedMesh(const CookedFile& file, const MeshInfo& info, size_t boneCount)
+		{
+			const size_t vertexCount = info.vertexCount;
+			if (file.GetSection<Vector3>(MeshVerticesID).size != vertexCount)
+				return "vertex count";
+			auto isVertexStream = [vertexCount](size_t size) { return size == 0 || size == vertexCount; };
+			if (!isVertexStream(file.GetSection<Vector3>(MeshNormalsID).size)
+				|| !isVertexStream(file.GetSection<Vector2>(MeshUVID).size)
+				|| !isVertexStream(file.GetSection<Vector3>(MeshTangentsID).size))
+				return "vertex stream size";
+
+			const uint64_t indexCount = uint64_t(info.triangleCount) * 3;
+			auto triangles = file.GetSection<uint32_t>(MeshTrianglesID);
+			if (triangles.size != indexCount)
+				return "triangle count";
+			for (auto index : triangles)
+			{
+				if (index >= vertexCount)
+					return "vertex index";
+			}
+
+			// one start per submesh, in order(a single submesh may have its start or none)
+			auto subMeshes = file.GetSection<uint32_t>(MeshSubMeshesID);
+			if (info.subMeshCount < 1 || (info.subMeshCount > 1 ? subMeshes.size != size_t(info.subMeshCount) : subMeshes.size > 1))
+				return "submesh count";
+			for (size_t i = 0; i < subMeshes.size; ++i)
+			{
+				if (subMeshes[i] > indexCount || (i > 0 && subMeshes[i] < subMeshes[i-1]))
+					return "submesh offset";
+			}
+
+			if (file.GetSection<Matrix4x4>(MeshBindposesID).size != boneCount)
+				return "bindpose count";
+			auto boneWeights = file.GetSection<BoneWeight>(MeshBoneWeightsID);
+			if (!isVertexStream(boneWeights.size))
+				return "bone weight count";
+			for (auto& bw : boneWeights)
+			{
+				for (int j = 0; j < MaxBoneForEachVertex; ++j)
+				{
+					if (bw.weight[j] > 0 && (bw.boneIndex[j] < 0 || size_t(bw.boneIndex[j]) >= boneCount))
+						return "bone index";
+				}
+			}
+			return nullptr;
+		}
+
+		template<class T>
+		ArrayView<T> GetStream(const std::shared_ptr<CookedFile>& file, uint32_t id, const std::vector<T>& v)
+		{
+			return file ? file->GetSection<T>(id) : ArrayView<T>(v);
+		}
+	}
+
+	ArrayView<Vector3> Mesh::GetVertices() const
+	{
+		return GetStream(m_CookedFile, MeshVerticesID, m_vertices);
+	}
+
+	ArrayView<Vector3> Mesh::GetNormals() const
+	{
+		return GetStream(m_CookedFile, MeshNormalsID, m_normals);
+	}
+
+	ArrayView<Vector2> Mesh::GetUV() const
+	{
+		return GetStream(m_CookedFile, MeshUVID, m_uv);
+	}
+
+	ArrayView<Vector3> Mesh::GetTangents() const
+	{
+		return GetStream(m_CookedFile, MeshTangentsID, m_tangents);
+	}
+
+	ArrayView<uint32_t> Mesh::GetTriangles() const
+	{
+		return GetStream(m_CookedFile, MeshTrianglesID, m_triangles);
+	}
+
+	ArrayView<uint32_t> Mesh::GetSubMeshIndexOffset() const
+	{
+		return GetStream(m_CookedFile, MeshSubMeshesID, m_subMeshIndexOffset);
+	}
+
+	ArrayView<Matrix4x4> Mesh::GetBindposes() const
+	{
+		return GetStream(m_CookedFile, MeshBindposesID, m_bindposes);
+	}
+
+	ArrayView<BoneWeight> Mesh::GetBoneWeights() const
+	{
+		return GetStream(m_CookedFile, MeshBoneWeightsID, m_boneWeights);
+	}
+
+
+	Mesh* Mesh::FromCookedFile(const std::string &path)
+	{
+		auto file = CookedFile::Open(path, CookedFileType::Mesh);
+		if (file == nullptr)
+			return nullptr;
+		auto info = file->GetValue<MeshInfo>(MeshInfoID);
+		if (info == nullptr)
+		{
+			LogWarning(Format("{}: bad mesh", path));
+			return nullptr;
+		}
+
+		std::vector<std::string> boneNames;
+		auto names = file->GetSection<char>(MeshBoneNamesID);
+		for (auto p = names.begin(); p != names.end(); )
+		{
+			auto e = std::find(p, names.end(), '\0');
+			boneNames.emplace_back(p, e);
+			p = (e == names.end()) ? e : e + 1;
+		}
+
+		auto error = CheckCookedMesh(*file, *info, boneNames.size());
+		if (error != nullptr)
+		{
+			LogWarning(Format("{}: bad mesh({})", path, error));
+			return nullptr;
+		}
+
+		auto mesh = new Mesh();
+		mesh->m_CookedFile = file;
+		mesh->m_vertexCount = info->vertexCount;
+		mesh->m_triangleCount = info->triangleCount;
+		mesh->m_subMeshCount = info->subMeshCount;
+		mesh->m_skinned = info->skinned != 0;
+		mesh->m_bounds.SetMinMax(info->boundsMin, info->boundsMax);
+		mesh->m_boneNames = std::move(boneNames);
+		return mesh;
+	}
+
+	bool Mesh::SaveCooked(const std::string &path) const
+	{
+		MeshInfo info;
+		info.vertexCount = m_vertexCount;
+		info.triangleCount = m_triangleCount;
+		info.subMeshCount = m_subMeshCount;
+		info.skinned = m_skinned ? 1 : 0;
+		info.boundsMin = m_bounds.min();
+		info.boundsMax = m_bounds.max();
+
+		std::vector<char> names;
+		for (auto& name : m_boneNames)
+		{
+			names.insert(names.end(), name.begin(), name.end());
+			names.push_back('\0');
+		}
+
+		CookedFileWriter writer(CookedFileType::Mesh);
+		writer.AddValue(MeshInfoID, info);
+		writer.AddSection(MeshVerticesID, GetVertices());
+		writer.AddSection(MeshNormalsID, GetNormals());
+		writer.AddSection(MeshUVID, GetUV());
+		writer.AddSection(MeshTangentsID, GetTangents());
+		writer.AddSection(MeshTrianglesID, GetTriangles());
+		writer.AddSection(MeshSubMeshesID, GetSubMeshIndexOffset());
+		writer.AddSection(MeshBindposesID, GetBindposes());
+		writer.AddSection(MeshBoneWeightsID, GetBoneWeights());
+		writer.AddSection(MeshBoneNamesID, names);
+		return writer.Write(path);
+	}
+
+	
 	void Mesh::RecalculateBounds()
 	{
 		Vector3 bmin(Mathf::Infinity, Mathf::Infinity, Mathf::Infinity);
 		Vector3 bmax(Mathf::NegativeInfinity, Mathf::NegativeInfinity, Mathf::NegativeInfinity);
-		for (auto & v : m_vertices)
+		for (auto & v : GetVertices())
 		{
 			if (bmin.x > v.x)
 				bmin.x = v.x;
@@ -147,6 +340,30 @@ namespace FishEngine
 		//m_boneWeightBuffer.clear();
 		m_boneWeights.clear();
 		m_boneWeights.shrink_to_fit();
+		m_CookedFile.reset();
+		m_boneBounds.clear();
+	}
+
+
+	const std::vector<Bounds>& Mesh::GetBoneBounds() const
+	{
+		if (m_boneBounds.size() == GetBoneCount())
+			return m_boneBounds;
+		m_boneBounds.assign(GetBoneCount(), Bounds());
+		auto vertices = GetVertices();
+		auto boneWeights = GetBoneWeights();
+		const size_t count = std::min(vertices.size, boneWeights.size);
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto& bw = boneWeights[i];
+			for (int j = 0; j < MaxBoneForEachVertex; ++j)
+			{
+				int bone = bw.boneIndex[j];
+				if (bw.weight[j] > 0 && bone >= 0 && bone < static_cast<int>(m_boneBounds.size()))
+					m_boneBounds[bone].Encapsulate(vertices[i]);
+			}
+		}
+		return m_boneBounds;
 	}
 
 
@@ -154,6 +371,12 @@ namespace FishEngine
 
 	void Mesh::GenerateBuffer()
 	{
+		auto triangles = GetTriangles();
+		auto vertices = GetVertices();
+		auto normals = GetNormals();
+		auto uv = GetUV();
+		auto tangents = GetTangents();
+
 		// VAO
 		assert(m_VAO == 0);
 		glGenVertexArrays(1, &m_VAO);
@@ -161,31 +384,32 @@ namespace FishEngine
 		// index VBO
 		glGenBuffers(1, &m_indexVBO);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexVBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_triangles.size() * 4, m_triangles.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size * 4, triangles.data, GL_STATIC_DRAW);
 		
 		glGenBuffers(1, &m_positionVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_positionVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * 3 * 4, m_vertices.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size * 3 * 4, vertices.data, GL_STATIC_DRAW);
 		
 		glGenBuffers(1, &m_normalVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_normalVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_normals.size() * 3 * 4, m_normals.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, normals.size * 3 * 4, normals.data, GL_STATIC_DRAW);
 		
 		glGenBuffers(1, &m_uvVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_uvVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_uv.size() * 2 * 4, m_uv.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, uv.size * 2 * 4, uv.data, GL_STATIC_DRAW);
 
 		glGenBuffers(1, &m_tangentVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_tangentVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_tangents.size() * 3 * 4, m_tangents.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, tangents.size * 3 * 4, tangents.data, GL_STATIC_DRAW);
 		
 		if (m_skinned)
 		{
 			std::vector<Int4> boneIndexBuffer;
 			std::vector<Vector4> boneWeightBuffer;
-			boneIndexBuffer.reserve(m_boneWeights.size());
-			boneIndexBuffer.reserve(m_boneWeights.size());
-			for (auto const & b : m_boneWeights)
+			auto boneWeights = GetBoneWeights();
+			boneIndexBuffer.reserve(boneWeights.size);
+			boneWeightBuffer.reserve(boneWeights.size);
+			for (auto const & b : boneWeights)
 			{
 				boneIndexBuffer.emplace_back(b.boneIndex[0], b.boneIndex[1], b.boneIndex[2], b.boneIndex[3]);
 				boneWeightBuffer.emplace_back(b.weight[0], b.weight[1], b.weight[2], b.weight[3]);
@@ -198,15 +422,15 @@ namespace FishEngine
 			
 			glGenBuffers(1, &m_animationOutputPositionVBO);
 			glBindBuffer(GL_ARRAY_BUFFER, m_animationOutputPositionVBO);
-			glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * 3 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size * 3 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
 			
 			glGenBuffers(1, &m_animationOutputNormalVBO);
 			glBindBuffer(GL_ARRAY_BUFFER, m_animationOutputNormalVBO);
-			glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * 3 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size * 3 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
 			
 			glGenBuffers(1, &m_animationOutputTangentVBO);
 			glBindBuffer(GL_ARRAY_BUFFER, m_animationOutputTangentVBO);
-			glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * 3 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size * 3 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
 			
 			glGenBuffers(1, &m_boneIndexVBO);
 			glBindBuffer(GL_ARRAY_BUFFER, m_boneIndexVBO);
@@ -314,6 +538,12 @@ namespace FishEngine
 #else
 	void Mesh::GenerateBuffer()
 	{
+		auto triangles = GetTriangles();
+		auto vertices = GetVertices();
+		auto normals = GetNormals();
+		auto uv = GetUV();
+		auto tangents = GetTangents();
+
 		// VAO
 		assert(m_VAO == 0);
 		glGenVertexArrays(1, &m_VAO);
@@ -323,23 +553,23 @@ namespace FishEngine
 		// index VBO
 		glGenBuffers(1, &m_indexVBO);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexVBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_triangles.size() * 4, m_triangles.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size * 4, triangles.data, GL_STATIC_DRAW);
 
 		glGenBuffers(1, &m_positionVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_positionVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * 3 * 4, m_vertices.data(), drawType);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size * 3 * 4, vertices.data, drawType);
 
 		glGenBuffers(1, &m_normalVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_normalVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_normals.size() * 3 * 4, m_normals.data(), drawType);
+		glBufferData(GL_ARRAY_BUFFER, normals.size * 3 * 4, normals.data, drawType);
 
 		glGenBuffers(1, &m_uvVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_uvVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_uv.size() * 2 * 4, m_uv.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, uv.size * 2 * 4, uv.data, GL_STATIC_DRAW);
 
 		glGenBuffers(1, &m_tangentVBO);
 		glBindBuffer(GL_ARRAY_BUFFER, m_tangentVBO);
-		glBufferData(GL_ARRAY_BUFFER, m_tangents.size() * 3 * 4, m_tangents.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, tangents.size * 3 * 4, tangents.data, GL_STATIC_DRAW);
 	}
 
 
@@ -373,16 +603,35 @@ namespace FishEngine
 #endif
 	
 	void Mesh::Render( int subMeshIndex /* = -1*/)
+	{
+		BindVertexArray();
+		DrawElements(subMeshIndex);
+		glBindVertexArray(0);
+		glCheckError();
+	}
+
+
+	void Mesh::BindVertexArray()
 	{
 		//assert(m_uploaded);
 		if (!m_uploaded)
 		{
 			UploadMeshData();
 		}
-		
+
 		glBindVertexArray(m_VAO);
 		glCheckError();
-		
+	}
+
+
+	void Mesh::DrawElements(int subMeshIndex /* = -1*/)
+	{
+		DrawElementsInstanced(1, subMeshIndex);
+	}
+
+
+	void Mesh::DrawElementsInstanced(int instanceCount, int subMeshIndex /* = -1*/)
+	{
 		if (subMeshIndex < 0 && subMeshIndex != -1)
 		{
 			LogWarning(Format( "invalid subMeshIndex {}", subMeshIndex ));
@@ -394,28 +643,27 @@ namespace FishEngine
 			subMeshIndex = m_subMeshCount;
 		}
 		
-		if (subMeshIndex == -1 || m_subMeshCount == 1)
-		{
-			glDrawElements(GL_TRIANGLES, m_triangleCount * 3, GL_UNSIGNED_INT, 0);
-			glCheckError();
-		}
-		else
+		GLvoid * offset = 0;
+		int index_count = m_triangleCount * 3;
+		if (subMeshIndex != -1 && m_subMeshCount != 1)
 		{
-			GLvoid * offset = (GLvoid *)( m_subMeshIndexOffset[subMeshIndex] * sizeof(GLuint) );
-			int index_count = 0;
+			auto subMeshIndexOffset = GetSubMeshIndexOffset();
+			offset = (GLvoid *)( subMeshIndexOffset[subMeshIndex] * sizeof(GLuint) );
 			if (subMeshIndex == m_subMeshCount-1) // the last one
 			{
-				index_count = m_triangleCount * 3 - m_subMeshIndexOffset[m_subMeshCount-1];
+				index_count = m_triangleCount * 3 - subMeshIndexOffset[m_subMeshCount-1];
 				//index_count = 0;
 			}
 			else
 			{
-				index_count = m_subMeshIndexOffset[subMeshIndex+1] - m_subMeshIndexOffset[subMeshIndex];
+				index_count = subMeshIndexOffset[subMeshIndex+1] - subMeshIndexOffset[subMeshIndex];
 			}
-			glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, offset);
 		}
-		
-		glBindVertexArray(0);
+
+		if (instanceCount == 1)
+			glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, offset);
+		else
+			glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, offset, instanceCount);
 		glCheckError();
 	}
 
@@ -32,6 +32,7 @@ namespace FishEngine
 	unsigned int        Pipeline::s_perDrawUBO = 0;
 	unsigned int        Pipeline::s_lightingUBO = 0;
 	unsigned int        Pipeline::s_bonesUBO = 0;
+	unsigned int        Pipeline::s_instanceVBO = 0;
 
 	void Pipeline::StaticInit()
 	{
@@ -40,6 +41,7 @@ namespace FishEngine
 		glGenBuffers(1, &s_perDrawUBO);
 		glGenBuffers(1, &s_lightingUBO);
 		glGenBuffers(1, &s_bonesUBO);
+		glGenBuffers(1, &s_instanceVBO);
 	}
 
 	void Pipeline::BindCamera(Camera* camera)
@@ -171,6 +173,32 @@ namespace FishEngine
 		glCheckError();
 	}
 
+	void Pipeline::UpdateInstanceMatrices(const Matrix4x4* modelMatrices, int count)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, s_instanceVBO);
+		// orphan the old storage, the previous batch may still be in flight
+		glBufferData(GL_ARRAY_BUFFER, count * sizeof(Matrix4x4), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Matrix4x4), (void*)modelMatrices);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glCheckError();
+	}
+
+	void Pipeline::BindInstanceAttributes()
+	{
+		// a mat4 attribute takes 4 locations, one vec4 each.
+		// the matrices are row major, so shaders get the transpose: pos * InstanceObjectToWorld
+		glBindBuffer(GL_ARRAY_BUFFER, s_instanceVBO);
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			auto location = InstanceMatrixAttribIndex + i;
+			glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix4x4), (GLvoid*)(i * sizeof(Vector4)));
+			glEnableVertexAttribArray(location);
+			glVertexAttribDivisor(location, 1);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glCheckError();
+	}
+
 	void Pipeline::UpdateBonesUniforms(const std::vector<Matrix4x4>& bones)
 	{
 		glBindBuffer(GL_UNIFORM_BUFFER, s_bonesUBO);
@@ -0,0 +1,82 @@
+#include <FishEngine/Render/RenderSorter.hpp>
+#include <FishEngine/Render/Material.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace FishEngine
+{
+	constexpr uint64_t kMask12 = 0xFFF;
+	constexpr uint64_t kMask16 = 0xFFFF;
+
+	bool RenderSorter::IsTransparent(int renderQueue)
+	{
+		return renderQueue > static_cast<int>(RenderQueue::GeometryLast);
+	}
+
+	uint64_t RenderSorter::MakeSortKey(int renderQueue, uint32_t program, uint32_t material, uint32_t mesh, float depth01)
+	{
+		depth01 = std::min(std::max(depth01, 0.0f), 1.0f);
+		uint64_t depth = static_cast<uint64_t>(depth01 * kMask16);
+		uint64_t queue = static_cast<uint64_t>(std::min(std::max(renderQueue, 0), 4095));
+		uint64_t state = ((program & kMask12) << 24) | ((material & kMask12) << 12) | (mesh & kMask12);
+
+		if (IsTransparent(renderQueue))
+			return (queue << 52) | ((kMask16 - depth) << 36) | state;
+		return (queue << 52) | (state << 16) | depth;
+	}
+
+	void RenderSorter::RadixSort(std::vector<uint64_t>& keys, std::vector<int>& values)
+	{
+		std::vector<uint64_t> tempKeys;
+		std::vector<int> tempValues;
+		RadixSort(keys, values, tempKeys, tempValues);
+	}
+
+	void RenderSorter::RadixSort(std::vector<uint64_t>& keys, std::vector<int>& values,
+								 std::vector<uint64_t>& tempKeys, std::vector<int>& tempValues)
+	{
+		assert(keys.size() == values.size());
+		const size_t count = keys.size();
+		if (count <= 1)
+			return;
+
+		tempKeys.resize(count);
+		tempValues.resize(count);
+
+		// histograms of all 8 digits in one pass over the keys
+		size_t histograms[8][256] = {};
+		for (auto key : keys)
+		{
+			for (int pass = 0; pass < 8; ++pass)
+				histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			const int shift = pass * 8;
+			auto& histogram = histograms[pass];
+
+			// all keys share this digit
+			if (histogram[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+
+			size_t offsets[256];
+			size_t sum = 0;
+			for (int i = 0; i < 256; ++i)
+			{
+				offsets[i] = sum;
+				sum += histogram[i];
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				size_t dst = offsets[(keys[i] >> shift) & 0xFF]++;
+				tempKeys[dst] = keys[i];
+				tempValues[dst] = values[i];
+			}
+			keys.swap(tempKeys);
+			values.swap(tempValues);
+		}
+	}
+}
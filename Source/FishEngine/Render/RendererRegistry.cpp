@@ -0,0 +1,187 @@
+#include <FishEngine/Render/RendererRegistry.hpp>
+#include <FishEngine/GameObject.hpp>
+#include <FishEngine/Transform.hpp>
+#include <FishEngine/Component/MeshFilter.hpp>
+#include <FishEngine/Component/MeshRenderer.hpp>
+#include <FishEngine/Component/SkinnedMeshRenderer.hpp>
+#include <FishEngine/Render/Material.hpp>
+
+#include <cassert>
+
+namespace FishEngine
+{
+	void RendererRegistry::Register(Renderer* renderer)
+	{
+		assert(renderer->m_RegistryIndex == -1);
+		int index = static_cast<int>(m_Entries.size());
+		renderer->m_RegistryIndex = index;
+		Entry entry;
+		entry.renderer = renderer;
+		m_Entries.push_back(entry);
+		m_DirtyEntries.push_back(index);
+	}
+
+	void RendererRegistry::Unregister(Renderer* renderer)
+	{
+		int index = renderer->m_RegistryIndex;
+		if (index < 0)
+			return;
+		RemoveDrawable(index);
+		if (m_Entries[index].meshFilter != nullptr)
+			m_MeshFilterToEntry.erase(m_Entries[index].meshFilter);
+		renderer->m_RegistryIndex = -1;
+
+		// swap with the last one
+		int last = static_cast<int>(m_Entries.size()) - 1;
+		if (index != last)
+		{
+			auto& moved = m_Entries[index];
+			moved = m_Entries[last];
+			moved.renderer->m_RegistryIndex = index;
+			if (moved.drawableIndex >= 0)
+				m_DrawableToEntry[moved.drawableIndex] = index;
+			if (moved.meshFilter != nullptr)
+				m_MeshFilterToEntry[moved.meshFilter] = index;
+			// the old index in m_DirtyEntries is out of range now
+			if (moved.dirty)
+				m_DirtyEntries.push_back(index);
+		}
+		m_Entries.pop_back();
+	}
+
+	void RendererRegistry::MarkDirty(int entryIndex)
+	{
+		auto& entry = m_Entries[entryIndex];
+		if (!entry.dirty)
+		{
+			entry.dirty = true;
+			m_DirtyEntries.push_back(entryIndex);
+		}
+	}
+
+	void RendererRegistry::SetDirty(Renderer* renderer)
+	{
+		if (renderer->m_RegistryIndex >= 0)
+			MarkDirty(renderer->m_RegistryIndex);
+	}
+
+	void RendererRegistry::OnMeshFilterChanged(MeshFilter* meshFilter)
+	{
+		auto it = m_MeshFilterToEntry.find(meshFilter);
+		if (it != m_MeshFilterToEntry.end())
+		{
+			MarkDirty(it->second);
+			return;
+		}
+		auto go = meshFilter->GetGameObject();
+		if (go == nullptr)
+			return;
+		for (auto comp : go->GetAllComponents())
+		{
+			if (comp->Is<Renderer>())
+				SetDirty(static_cast<Renderer*>(comp));
+		}
+	}
+
+	void RendererRegistry::OnMeshFilterDestroyed(MeshFilter* meshFilter)
+	{
+		auto it = m_MeshFilterToEntry.find(meshFilter);
+		if (it == m_MeshFilterToEntry.end())
+			return;
+		int index = it->second;
+		m_MeshFilterToEntry.erase(it);
+		m_Entries[index].meshFilter = nullptr;
+		MarkDirty(index);
+	}
+
+	void RendererRegistry::OnHierarchyChanged(GameObject* gameObject)
+	{
+		for (auto comp : gameObject->GetAllComponents())
+		{
+			if (comp->Is<Renderer>())
+				SetDirty(static_cast<Renderer*>(comp));
+		}
+		auto t = gameObject->GetTransform();
+		if (t == nullptr)
+			return;
+		for (auto child : t->GetChildren())
+		{
+			OnHierarchyChanged(child->GetGameObject());
+		}
+	}
+
+	void RendererRegistry::RemoveDrawable(int entryIndex)
+	{
+		auto& entry = m_Entries[entryIndex];
+		int d = entry.drawableIndex;
+		if (d < 0)
+			return;
+		int last = static_cast<int>(m_Drawables.size()) - 1;
+		m_Drawables[d] = m_Drawables[last];
+		m_DrawableToEntry[d] = m_DrawableToEntry[last];
+		m_Entries[m_DrawableToEntry[d]].drawableIndex = d;
+		m_Drawables.pop_back();
+		m_DrawableToEntry.pop_back();
+		entry.drawableIndex = -1;
+	}
+
+	void RendererRegistry::Sync()
+	{
+		const int count = static_cast<int>(m_Entries.size());
+		for (int index : m_DirtyEntries)
+		{
+			if (index >= count)
+				continue;
+			auto& entry = m_Entries[index];
+			if (!entry.dirty)
+				continue;
+			entry.dirty = false;
+
+			auto renderer = entry.renderer;
+			auto go = renderer->GetGameObject();
+			Mesh* mesh = nullptr;
+			if (go != nullptr)
+			{
+				if (renderer->GetClassID() == SkinnedMeshRenderer::ClassID)
+				{
+					mesh = static_cast<SkinnedMeshRenderer*>(renderer)->GetSharedMesh();
+				}
+				else
+				{
+					if (entry.meshFilter == nullptr)
+					{
+						entry.meshFilter = go->GetComponent<MeshFilter>();
+						if (entry.meshFilter != nullptr)
+							m_MeshFilterToEntry[entry.meshFilter] = index;
+					}
+					if (entry.meshFilter != nullptr)
+						mesh = entry.meshFilter->GetMesh();
+				}
+			}
+
+			bool drawable = go != nullptr && mesh != nullptr && renderer->GetEnabled() && go->IsActiveInHierarchy();
+			if (!drawable)
+			{
+				RemoveDrawable(index);
+				continue;
+			}
+
+			auto material = renderer->GetMaterial();
+			if (material == nullptr)
+				material = Material::GetErrorMaterial();
+
+			RegisteredRenderer r{go, renderer, mesh, material};
+			if (entry.drawableIndex < 0)
+			{
+				entry.drawableIndex = static_cast<int>(m_Drawables.size());
+				m_Drawables.push_back(r);
+				m_DrawableToEntry.push_back(index);
+			}
+			else
+			{
+				m_Drawables[entry.drawableIndex] = r;
+			}
+		}
+		m_DirtyEntries.clear();
+	}
+}
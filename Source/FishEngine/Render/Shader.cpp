@@ -177,6 +177,8 @@ namespace FishEngine
 //			}
 			if (m_GLProgram != 0)
 				glDeleteProgram(m_GLProgram);
+			if (m_InstancedGLProgram != 0)
+				glDeleteProgram(m_InstancedGLProgram);
 		}
 
 		void set(const std::string& shaderText)
@@ -185,14 +187,15 @@ namespace FishEngine
 		}
 
 //		GLuint CompileAndLink(ShaderKeywords keywords)
-		GLuint CompileAndLink()
+		// instancing: compile the INSTANCING_ON variant
+		GLuint CompileAndLink(bool instancing = false)
 		{
 			//Debug::LogWarning("CompileAndLink %s", m_filePath.c_str());
-			auto vs = Compile(ShaderType::VertexShader);
+			auto vs = Compile(ShaderType::VertexShader, instancing);
 			GLuint gs = 0;
 			if (m_hasGeometryShader)
-				gs = Compile(ShaderType::GeometryShader);
-			auto fs = Compile(ShaderType::FragmentShader);
+				gs = Compile(ShaderType::GeometryShader, instancing);
+			auto fs = Compile(ShaderType::FragmentShader, instancing);
 			//auto glsl_program = LinkShader(vs, 0, 0, gs, fs);
 			GLuint glsl_program = LinkShader(vs, 0, 0, gs, fs);
 			if (m_transformFeedback)
@@ -204,7 +207,10 @@ namespace FishEngine
 				glsl_program = LinkShader(vs, 0, 0, gs, fs);
 			}
 //			m_keywordToGLPrograms[keywords] = glsl_program;
-			m_GLProgram = glsl_program;
+			if (instancing)
+				m_InstancedGLProgram = glsl_program;
+			else
+				m_GLProgram = glsl_program;
 			GetAllUniforms(glsl_program);
 			glDeleteShader(vs);
 			glDeleteShader(fs);
@@ -218,6 +224,12 @@ namespace FishEngine
 			return m_GLProgram;
 		}
 
+		// shaders opt in to instancing by checking INSTANCING_ON
+		bool SupportsInstancing() const
+		{
+			return m_shaderTextRaw.find("INSTANCING_ON") != std::string::npos;
+		}
+
 		const std::string& shaderTextRaw() const
 		{
 			return m_shaderTextRaw;
@@ -233,11 +245,12 @@ namespace FishEngine
 		std::string                         m_shaderTextRaw;
 //		std::map<ShaderKeywords, GLuint>    m_keywordToGLPrograms;
 		GLuint m_GLProgram = 0;
+		GLuint m_InstancedGLProgram = 0;
 		std::map<GLuint, std::vector<UniformInfo>> m_GLProgramToUniforms;
 		int m_renderQueue = -1;
 
 
-		GLuint Compile(ShaderType type)
+		GLuint Compile(ShaderType type, bool instancing)
 		{
 			std::string text = "#version 410 core\n";
 			m_lineCount = 1;
@@ -274,6 +287,11 @@ namespace FishEngine
 //				add_macro_definition("_AMBIENT_IBL");
 //			}
 
+			if (instancing)
+			{
+				add_macro_definition("INSTANCING_ON");
+			}
+
 			text += m_shaderTextRaw;
 
 			return CompileShader(t, text);
@@ -397,6 +415,10 @@ namespace FishEngine
 		s->m_impl->m_hasGeometryShader = hasGeometryShader;
 		s->m_impl->CompileAndLink();
 		s->m_GLProgram = s->m_impl->glslProgram();
+		if (s->m_impl->SupportsInstancing())
+		{
+			s->m_InstancedGLProgram = s->m_impl->CompileAndLink(true);
+		}
 		return s;
 	}
 	
@@ -427,6 +449,12 @@ namespace FishEngine
 		glUseProgram(m_GLProgram);
 	}
 
+	void Shader::UseInstanced() const
+	{
+		assert(m_InstancedGLProgram != 0);
+		glUseProgram(m_InstancedGLProgram);
+	}
+
 	const std::vector<UniformInfo>& Shader::GetUniforms() const
 	{
 		return m_impl->m_GLProgramToUniforms[m_GLProgram];
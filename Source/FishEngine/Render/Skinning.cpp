@@ -0,0 +1,369 @@
+#include <FishEngine/Render/Skinning.hpp>
+#include <FishEngine/Internal/SIMD.hpp>
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <cmath>
+
+#if FE_SIMD_AVX
+#	include <immintrin.h>
+#elif FE_SIMD_SSE
+#	include <emmintrin.h>
+#endif
+
+static_assert(FishEngine::MaxBoneForEachVertex == 4, "the skinning kernels blend exactly 4 bones");
+
+namespace FishEngine
+{
+	// Vector3::Set is not inline
+	inline void Store(Vector3& v, float x, float y, float z)
+	{
+		v.x = x;
+		v.y = y;
+		v.z = z;
+	}
+
+	void Skinning::SkinVertices_Scalar(const SkinningData& data, int first, int last)
+	{
+		for (int i = first; i < last; ++i)
+		{
+			const auto& bw = data.boneWeights[i];
+			float m[12];
+			const float* m0 = data.palette[bw.boneIndex[0]].m[0];
+			for (int k = 0; k < 12; ++k)
+				m[k] = m0[k] * bw.weight[0];
+			for (int b = 1; b < 4; ++b)
+			{
+				const float* mb = data.palette[bw.boneIndex[b]].m[0];
+				const float w = bw.weight[b];
+				for (int k = 0; k < 12; ++k)
+					m[k] += mb[k] * w;
+			}
+
+			const auto& p = data.positions[i];
+			const auto& n = data.normals[i];
+			auto& sp = data.skinnedPositions[i];
+			auto& sn = data.skinnedNormals[i];
+			sp.x = m[0]*p.x + m[1]*p.y + m[2]*p.z + m[3];
+			sp.y = m[4]*p.x + m[5]*p.y + m[6]*p.z + m[7];
+			sp.z = m[8]*p.x + m[9]*p.y + m[10]*p.z + m[11];
+			sn.x = m[0]*n.x + m[1]*n.y + m[2]*n.z;
+			sn.y = m[4]*n.x + m[5]*n.y + m[6]*n.z;
+			sn.z = m[8]*n.x + m[9]*n.y + m[10]*n.z;
+		}
+	}
+
+
+	void Skinning::SkinVertices_SSE(const SkinningData& data, int first, int last)
+	{
+#if FE_SIMD_SSE
+		alignas(16) float result[4];
+		for (int i = first; i < last; ++i)
+		{
+			// blend the 3 rows of the 4 bone matrices
+			const auto& bw = data.boneWeights[i];
+			__m128 r0 = _mm_setzero_ps();
+			__m128 r1 = _mm_setzero_ps();
+			__m128 r2 = _mm_setzero_ps();
+			for (int b = 0; b < 4; ++b)
+			{
+				const float* mb = data.palette[bw.boneIndex[b]].m[0];
+				const __m128 w = _mm_set1_ps(bw.weight[b]);
+				r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_loadu_ps(mb), w));
+				r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_loadu_ps(mb + 4), w));
+				r2 = _mm_add_ps(r2, _mm_mul_ps(_mm_loadu_ps(mb + 8), w));
+			}
+
+			// dot products of the rows: transpose the products and add them up
+			const auto& p = data.positions[i];
+			const __m128 vp = _mm_set_ps(1.0f, p.z, p.y, p.x);
+			__m128 x = _mm_mul_ps(r0, vp);
+			__m128 y = _mm_mul_ps(r1, vp);
+			__m128 z = _mm_mul_ps(r2, vp);
+			__m128 w = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_store_ps(result, _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+			Store(data.skinnedPositions[i], result[0], result[1], result[2]);
+
+			const auto& n = data.normals[i];
+			const __m128 vn = _mm_set_ps(0.0f, n.z, n.y, n.x);
+			x = _mm_mul_ps(r0, vn);
+			y = _mm_mul_ps(r1, vn);
+			z = _mm_mul_ps(r2, vn);
+			w = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_store_ps(result, _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+			Store(data.skinnedNormals[i], result[0], result[1], result[2]);
+		}
+#else
+		SkinVertices_Scalar(data, first, last);
+#endif
+	}
+
+
+	FE_TARGET_AVX void Skinning::SkinVertices_AVX(const SkinningData& data, int first, int last)
+	{
+#if FE_SIMD_AVX
+		alignas(16) float xy[4];
+		alignas(16) float z[4];
+		for (int i = first; i < last; ++i)
+		{
+			// rows 0 and 1 blended in one 256 bit register, row 2 in a 128 bit one
+			const auto& bw = data.boneWeights[i];
+			__m256 r01 = _mm256_setzero_ps();
+			__m128 r2 = _mm_setzero_ps();
+			for (int b = 0; b < 4; ++b)
+			{
+				const float* mb = data.palette[bw.boneIndex[b]].m[0];
+				r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_loadu_ps(mb), _mm256_set1_ps(bw.weight[b])));
+				r2 = _mm_add_ps(r2, _mm_mul_ps(_mm_loadu_ps(mb + 8), _mm_set1_ps(bw.weight[b])));
+			}
+
+			const auto& p = data.positions[i];
+			const auto& n = data.normals[i];
+			const __m128 vp = _mm_set_ps(1.0f, p.z, p.y, p.x);
+			const __m128 vn = _mm_set_ps(0.0f, n.z, n.y, n.x);
+			const __m256 vp2 = _mm256_insertf128_ps(_mm256_castps128_ps256(vp), vp, 1);
+			const __m256 vn2 = _mm256_insertf128_ps(_mm256_castps128_ps256(vn), vn, 1);
+
+			// per 128 bit lane(row 0 / row 1): [row.p, row.n, row.p, row.n]
+			__m256 h = _mm256_hadd_ps(_mm256_mul_ps(r01, vp2), _mm256_mul_ps(r01, vn2));
+			h = _mm256_hadd_ps(h, h);
+			// [row2.p, row2.n, row2.p, row2.n]
+			__m128 h2 = _mm_hadd_ps(_mm_mul_ps(r2, vp), _mm_mul_ps(r2, vn));
+			h2 = _mm_hadd_ps(h2, h2);
+
+			// [p.x, p.y, n.x, n.y]
+			_mm_store_ps(xy, _mm_unpacklo_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1)));
+			_mm_store_ps(z, h2);
+			Store(data.skinnedPositions[i], xy[0], xy[1], z[0]);
+			Store(data.skinnedNormals[i], xy[2], xy[3], z[1]);
+		}
+#else
+		SkinVertices_SSE(data, first, last);
+#endif
+	}
+
+
+	DualQuaternion::DualQuaternion(const Matrix4x4& mat)
+	{
+		Vector3 t;
+		Quaternion q;
+		Matrix4x4::Decompose(mat, &t, &q, nullptr);
+		real[0] = q.x;
+		real[1] = q.y;
+		real[2] = q.z;
+		real[3] = q.w;
+		// dual = 0.5 * (t, 0) * q
+		dual[0] = 0.5f * ( t.x*q.w + t.y*q.z - t.z*q.y);
+		dual[1] = 0.5f * (-t.x*q.z + t.y*q.w + t.z*q.x);
+		dual[2] = 0.5f * ( t.x*q.y - t.y*q.x + t.z*q.w);
+		dual[3] = -0.5f * (t.x*q.x + t.y*q.y + t.z*q.z);
+	}
+
+
+	// weight of bone b, negated when its rotation is on the other hemisphere of the first bone
+	inline float HemisphereWeight(const DualQuaternion* palette, const BoneWeight& bw, int b)
+	{
+		const float* r0 = palette[bw.boneIndex[0]].real;
+		const float* rb = palette[bw.boneIndex[b]].real;
+		float dot = r0[0]*rb[0] + r0[1]*rb[1] + r0[2]*rb[2] + r0[3]*rb[3];
+		return dot < 0 ? -bw.weight[b] : bw.weight[b];
+	}
+
+
+	void Skinning::SkinVerticesDQ_Scalar(const SkinningData& data, int first, int last)
+	{
+		for (int i = first; i < last; ++i)
+		{
+			const auto& bw = data.boneWeights[i];
+			float r[4] = { 0, 0, 0, 0 };
+			float d[4] = { 0, 0, 0, 0 };
+			for (int b = 0; b < 4; ++b)
+			{
+				const auto& dq = data.dualQuaternions[bw.boneIndex[b]];
+				const float w = HemisphereWeight(data.dualQuaternions, bw, b);
+				for (int k = 0; k < 4; ++k)
+				{
+					r[k] += dq.real[k] * w;
+					d[k] += dq.dual[k] * w;
+				}
+			}
+			const float invLength = 1.0f / std::sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2] + r[3]*r[3]);
+			for (int k = 0; k < 4; ++k)
+			{
+				r[k] *= invLength;
+				d[k] *= invLength;
+			}
+
+			// p' = p + 2 r x (r x p + r.w p) + 2 (r.w d - d.w r + r x d)
+			const auto& p = data.positions[i];
+			float tx = r[1]*p.z - r[2]*p.y + r[3]*p.x;
+			float ty = r[2]*p.x - r[0]*p.z + r[3]*p.y;
+			float tz = r[0]*p.y - r[1]*p.x + r[3]*p.z;
+			const float ox = r[3]*d[0] - d[3]*r[0] + r[1]*d[2] - r[2]*d[1];
+			const float oy = r[3]*d[1] - d[3]*r[1] + r[2]*d[0] - r[0]*d[2];
+			const float oz = r[3]*d[2] - d[3]*r[2] + r[0]*d[1] - r[1]*d[0];
+			Store(data.skinnedPositions[i],
+				p.x + 2 * (r[1]*tz - r[2]*ty + ox),
+				p.y + 2 * (r[2]*tx - r[0]*tz + oy),
+				p.z + 2 * (r[0]*ty - r[1]*tx + oz));
+
+			const auto& n = data.normals[i];
+			tx = r[1]*n.z - r[2]*n.y + r[3]*n.x;
+			ty = r[2]*n.x - r[0]*n.z + r[3]*n.y;
+			tz = r[0]*n.y - r[1]*n.x + r[3]*n.z;
+			Store(data.skinnedNormals[i],
+				n.x + 2 * (r[1]*tz - r[2]*ty),
+				n.y + 2 * (r[2]*tx - r[0]*tz),
+				n.z + 2 * (r[0]*ty - r[1]*tx));
+		}
+	}
+
+
+#if FE_SIMD_SSE
+	inline __m128 Cross(__m128 a, __m128 b)
+	{
+		const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	// transform the vertex by the normalized blended dual quaternion (r, d), w lanes of the results are 0
+	inline void TransformDQ(__m128 r, __m128 d, const Vector3& p, const Vector3& n, Vector3& outP, Vector3& outN)
+	{
+		alignas(16) float result[4];
+		const __m128 rw = _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3));
+		const __m128 dw = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 3, 3));
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		const __m128 vp = _mm_set_ps(0.0f, p.z, p.y, p.x);
+		__m128 t = _mm_add_ps(Cross(r, vp), _mm_mul_ps(rw, vp));
+		__m128 offset = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(rw, d), _mm_mul_ps(dw, r)), Cross(r, d));
+		_mm_store_ps(result, _mm_add_ps(vp, _mm_mul_ps(two, _mm_add_ps(Cross(r, t), offset))));
+		Store(outP, result[0], result[1], result[2]);
+
+		const __m128 vn = _mm_set_ps(0.0f, n.z, n.y, n.x);
+		t = _mm_add_ps(Cross(r, vn), _mm_mul_ps(rw, vn));
+		_mm_store_ps(result, _mm_add_ps(vn, _mm_mul_ps(two, Cross(r, t))));
+		Store(outN, result[0], result[1], result[2]);
+	}
+
+	inline __m128 InverseLength(__m128 r)
+	{
+		__m128 lengthSq = _mm_mul_ps(r, r);
+		lengthSq = _mm_add_ps(lengthSq, _mm_shuffle_ps(lengthSq, lengthSq, _MM_SHUFFLE(2, 3, 0, 1)));
+		lengthSq = _mm_add_ps(lengthSq, _mm_shuffle_ps(lengthSq, lengthSq, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+	}
+#endif
+
+
+	void Skinning::SkinVerticesDQ_SSE(const SkinningData& data, int first, int last)
+	{
+#if FE_SIMD_SSE
+		for (int i = first; i < last; ++i)
+		{
+			const auto& bw = data.boneWeights[i];
+			__m128 r = _mm_setzero_ps();
+			__m128 d = _mm_setzero_ps();
+			for (int b = 0; b < 4; ++b)
+			{
+				const auto& dq = data.dualQuaternions[bw.boneIndex[b]];
+				const __m128 w = _mm_set1_ps(HemisphereWeight(data.dualQuaternions, bw, b));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(dq.real), w));
+				d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(dq.dual), w));
+			}
+			const __m128 invLength = InverseLength(r);
+			TransformDQ(_mm_mul_ps(r, invLength), _mm_mul_ps(d, invLength),
+				data.positions[i], data.normals[i], data.skinnedPositions[i], data.skinnedNormals[i]);
+		}
+#else
+		SkinVerticesDQ_Scalar(data, first, last);
+#endif
+	}
+
+
+	FE_TARGET_AVX void Skinning::SkinVerticesDQ_AVX(const SkinningData& data, int first, int last)
+	{
+#if FE_SIMD_AVX
+		for (int i = first; i < last; ++i)
+		{
+			// real and dual parts blended in one 256 bit register
+			const auto& bw = data.boneWeights[i];
+			__m256 rd = _mm256_setzero_ps();
+			for (int b = 0; b < 4; ++b)
+			{
+				const auto& dq = data.dualQuaternions[bw.boneIndex[b]];
+				const __m256 w = _mm256_set1_ps(HemisphereWeight(data.dualQuaternions, bw, b));
+				rd = _mm256_add_ps(rd, _mm256_mul_ps(_mm256_loadu_ps(dq.real), w));
+			}
+			const __m128 r = _mm256_castps256_ps128(rd);
+			const __m128 d = _mm256_extractf128_ps(rd, 1);
+			const __m128 invLength = InverseLength(r);
+			TransformDQ(_mm_mul_ps(r, invLength), _mm_mul_ps(d, invLength),
+				data.positions[i], data.normals[i], data.skinnedPositions[i], data.skinnedNormals[i]);
+		}
+#else
+		SkinVerticesDQ_SSE(data, first, last);
+#endif
+	}
+
+
+	void Skinning::SkinVertices(const SkinningData& data, int first, int last)
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+		{
+			SkinVertices_AVX(data, first, last);
+			return;
+		}
+#endif
+#if FE_SIMD_SSE
+		SkinVertices_SSE(data, first, last);
+#else
+		SkinVertices_Scalar(data, first, last);
+#endif
+	}
+
+
+	void Skinning::SkinVerticesDQ(const SkinningData& data, int first, int last)
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+		{
+			SkinVerticesDQ_AVX(data, first, last);
+			return;
+		}
+#endif
+#if FE_SIMD_SSE
+		SkinVerticesDQ_SSE(data, first, last);
+#else
+		SkinVerticesDQ_Scalar(data, first, last);
+#endif
+	}
+
+
+	void Skinning::SkinVerticesParallel(const SkinningData& data, int vertexCount, SkinningMethod method)
+	{
+		auto kernel = method == SkinningMethod::DualQuaternion ? SkinVerticesDQ : SkinVertices;
+		// every range writes its own vertices only
+		JobSystem::GetInstance().ParallelFor(0, vertexCount, s_VertexGrainSize, [&data, kernel](int first, int last) {
+			kernel(data, first, last);
+		});
+	}
+
+
+	const char* Skinning::KernelName()
+	{
+#if FE_SIMD_AVX
+		if (CPU::HasAVX())
+			return "AVX";
+#endif
+#if FE_SIMD_SSE
+		return "SSE";
+#else
+		return "Scalar";
+#endif
+	}
+}
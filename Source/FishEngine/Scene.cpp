@@ -46,6 +46,7 @@ namespace FishEngine
 			return;
 		m_RootTransforms.push_back(t);
 //		t->m_RootOrder = m_RootTransforms.size() - 1;
+		TransformHierarchy::SetStructureDirty();
 	}
 	
 	void Scene::RemoveRootTransform(Transform* t)
@@ -57,6 +58,7 @@ namespace FishEngine
 			return;
 		}
 		m_RootTransforms.erase(pos);
+		TransformHierarchy::SetStructureDirty();
 	}
 	
 //	void CleanRecursively(Transform* t)
@@ -139,6 +141,7 @@ namespace FishEngine
 		{
 			cloned->m_RootTransforms.push_back(o->As<GameObject>()->GetTransform());
 		}
+		TransformHierarchy::SetStructureDirty();
 //		cloned->m_RenderSettings = memo[this->m_RenderSettings]->As<RenderSettings>();
 		cloned->m_RenderSettings = CloneObject(this->m_RenderSettings)->As<RenderSettings>();
 //
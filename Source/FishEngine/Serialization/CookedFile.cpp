@@ -0,0 +1,245 @@
+#include <FishEngine/Serialization/CookedFile.hpp>
+#include <FishEngine/Debug.hpp>
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#if FISHENGINE_PLATFORM_WINDOWS
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#	undef GetClassName
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+namespace FishEngine
+{
+	// MappedFile
+
+#if FISHENGINE_PLATFORM_WINDOWS
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_file = file;
+		m_mapping = mapping;
+		m_data = static_cast<const uint8_t*>(data);
+		m_size = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != nullptr)
+			CloseHandle(m_file);
+		m_data = nullptr;
+		m_size = 0;
+		m_mapping = nullptr;
+		m_file = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+		void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);	// the mapping keeps the file
+		if (data == MAP_FAILED)
+			return false;
+		m_data = static_cast<const uint8_t*>(data);
+		m_size = static_cast<size_t>(st.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data != nullptr)
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+		m_data = nullptr;
+		m_size = 0;
+	}
+#endif
+
+
+	// CookedFile
+
+	std::shared_ptr<CookedFile> CookedFile::Open(const std::string& path, CookedFileType type)
+	{
+		auto file = std::make_shared<CookedFile>();
+		if (!file->m_file.Open(path))
+			return nullptr;
+
+		auto data = file->m_file.GetData();
+		auto size = file->m_file.GetSize();
+		if (size < sizeof(CookedFileHeader))
+			return nullptr;
+		auto header = reinterpret_cast<const CookedFileHeader*>(data);
+		if (header->magic != CookedFileMagic || header->headerSize != sizeof(CookedFileHeader))
+		{
+			LogWarning(Format("{} is not a cooked file", path));
+			return nullptr;
+		}
+		if (header->version != CookedFileVersion || header->type != type)
+		{
+			LogWarning(Format("{}: version {} type {}, expected version {} type {}", path,
+				header->version, static_cast<uint32_t>(header->type), CookedFileVersion, static_cast<uint32_t>(type)));
+			return nullptr;
+		}
+		if (header->fileSize != size || sizeof(CookedFileHeader) + header->sectionCount * sizeof(CookedSection) > size)
+		{
+			LogWarning(Format("{} is truncated", path));
+			return nullptr;
+		}
+
+		auto sections = reinterpret_cast<const CookedSection*>(data + sizeof(CookedFileHeader));
+		for (uint32_t i = 0; i < header->sectionCount; ++i)
+		{
+			auto& s = sections[i];
+			if (s.offset % CookedSectionAlignment != 0 || s.offset + s.size > size || s.size != s.count * s.elementSize)
+			{
+				LogWarning(Format("{}: bad section {}", path, i));
+				return nullptr;
+			}
+		}
+
+		file->m_header = header;
+		file->m_sections = sections;
+		return file;
+	}
+
+	const CookedSection* CookedFile::FindSection(uint32_t id) const
+	{
+		for (uint32_t i = 0; i < m_header->sectionCount; ++i)
+		{
+			if (m_sections[i].id == id)
+				return &m_sections[i];
+		}
+		return nullptr;
+	}
+
+
+	// CookedFileWriter
+
+	void CookedFileWriter::AddSection(uint32_t id, const void* data, uint32_t elementSize, size_t count)
+	{
+		Section s;
+		s.id = id;
+		s.elementSize = elementSize;
+		s.count = count;
+		auto bytes = static_cast<const uint8_t*>(data);
+		s.bytes.assign(bytes, bytes + static_cast<size_t>(elementSize) * count);
+		m_sections.push_back(std::move(s));
+	}
+
+	bool CookedFileWriter::Write(const std::string& path) const
+	{
+		auto align = [](uint64_t offset) {
+			return (offset + CookedSectionAlignment - 1) / CookedSectionAlignment * CookedSectionAlignment;
+		};
+
+		std::vector<CookedSection> table(m_sections.size());
+		uint64_t offset = align(sizeof(CookedFileHeader) + sizeof(CookedSection) * m_sections.size());
+		for (size_t i = 0; i < m_sections.size(); ++i)
+		{
+			auto& s = m_sections[i];
+			auto& t = table[i];
+			t.id = s.id;
+			t.elementSize = s.elementSize;
+			t.count = s.count;
+			t.offset = offset;
+			t.size = static_cast<uint64_t>(s.elementSize) * s.count;
+			offset = align(t.offset + t.size);
+		}
+
+		CookedFileHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = CookedFileMagic;
+		header.version = CookedFileVersion;
+		header.headerSize = sizeof(CookedFileHeader);
+		header.type = m_type;
+		header.sectionCount = static_cast<uint32_t>(m_sections.size());
+		header.fileSize = offset;
+
+		// write to a temp file and rename it, so a mapping of the old file stays valid and a half written
+		// file is never opened
+		auto tempPath = path + ".tmp";
+		std::ofstream fout(tempPath, std::ios::binary);
+		if (!fout)
+		{
+			LogWarning(Format("can not write {}", tempPath));
+			return false;
+		}
+
+		static const char padding[CookedSectionAlignment] = {};
+		uint64_t written = 0;
+		auto pad = [&](uint64_t to) {
+			fout.write(padding, static_cast<std::streamsize>(to - written));
+			written = to;
+		};
+
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fout.write(reinterpret_cast<const char*>(table.data()), sizeof(CookedSection) * table.size());
+		written = sizeof(header) + sizeof(CookedSection) * table.size();
+		for (size_t i = 0; i < m_sections.size(); ++i)
+		{
+			pad(table[i].offset);
+			fout.write(reinterpret_cast<const char*>(m_sections[i].bytes.data()), static_cast<std::streamsize>(table[i].size));
+			written += table[i].size;
+		}
+		pad(offset);
+		fout.close();
+		if (!fout)
+		{
+			std::remove(tempPath.c_str());
+			return false;
+		}
+#if FISHENGINE_PLATFORM_WINDOWS
+		std::remove(path.c_str());
+#endif
+		if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+		{
+			LogWarning(Format("can not write {}", path));
+			std::remove(tempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
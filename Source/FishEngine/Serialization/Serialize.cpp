@@ -1,6 +1,7 @@
 #include <FishEngine/Serialization/Serialize.hpp>
 #include <FishEngine/Serialization/Archive.hpp>
 #include <FishEngine/FishEngine2.hpp>
+#include <FishEngine/TransformHierarchy.hpp>
 
 using namespace FishEngine;
 using namespace FishEditor;
@@ -136,6 +137,9 @@ namespace FishEngine
 		archive.AddNVP("m_Children", this->m_Children);
 		archive.AddNVP("m_Father", this->m_Father);
 		archive.AddNVP("m_RootOrder", this->m_RootOrder);
+		TransformHierarchy::SetStructureDirty();
+		m_IsDirty = true;
+		s_ChangeVersion.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	void Transform::Serialize(OutputArchive& archive) const
@@ -274,6 +278,7 @@ namespace FishEngine
 		archive.AddNVP("m_Avatar", this->m_Avatar);
 		archive.AddNVP("m_RootBone", this->m_RootBone);
 		archive.AddNVP("m_Bones", this->m_Bones);
+		archive.AddOptionalNVP("m_SkinningMethod", this->m_SkinningMethod);	// not in Unity's files
 	}
 
 	void SkinnedMeshRenderer::Serialize(OutputArchive& archive) const
@@ -283,6 +288,7 @@ namespace FishEngine
 		archive.AddNVP("m_Avatar", this->m_Avatar);
 		archive.AddNVP("m_RootBone", this->m_RootBone);
 		archive.AddNVP("m_Bones", this->m_Bones);
+		archive.AddNVP("m_SkinningMethod", this->m_SkinningMethod);
 	}
 
 
@@ -1,6 +1,10 @@
 #include <FishEngine/System/AnimationSystem.hpp>
 #include <FishEngine/Scene.hpp>
 #include <FishEngine/Animation/Animation.hpp>
+#include <FishEngine/System/JobSystem.hpp>
+#include <FishEngine/Component/Camera.hpp>
+#include <FishEngine/Transform.hpp>
+#include <FishEngine/Math/Frustum.hpp>
 
 //#include <FishEngine/Gizmos.hpp>
 //using namespace FishEngine;
@@ -29,13 +33,70 @@ void FishEngine::AnimationSystem::Start()
 
 
 
+FishEngine::AnimationLOD FishEngine::AnimationSystem::ComputeLOD(const Animation* animation, const Camera* camera, const FrustumPlanes& frustum) const
+{
+	if (camera == nullptr || !m_LODSettings.enabled)
+		return AnimationLOD::Full;
+
+	const float radius = animation->m_boundsRadius;
+	const Vector3 center = animation->GetTransform()->GetPosition();
+	if (!frustum.Intersects(Bounds(center, Vector3::one * (2 * radius))))
+		return AnimationLOD::Offscreen;
+
+	// projected radius over half the screen height
+	float screenSize;
+	if (camera->GetOrthographic())
+	{
+		screenSize = radius / camera->GetOrthographicSize();
+	}
+	else
+	{
+		const float distance = Vector3::Distance(center, camera->GetTransform()->GetPosition());
+		if (distance <= radius)
+			return AnimationLOD::Full;
+		screenSize = radius / (distance * Mathf::Tan(Mathf::Radians(camera->GetFieldOfView()) * 0.5f));
+	}
+	if (screenSize >= m_LODSettings.reducedScreenSize)
+		return AnimationLOD::Full;
+	if (screenSize >= m_LODSettings.minimalScreenSize)
+		return AnimationLOD::Reduced;
+	return AnimationLOD::Minimal;
+}
+
+
 void FishEngine::AnimationSystem::Update()
 {
 	auto scene = SceneManager::GetActiveScene();
 	auto animations = scene->FindComponents<Animation>();
+	const float deltaTime = 0.03333f;
+	auto camera = Camera::GetMainCamera();
+	FrustumPlanes frustum;
+	if (camera != nullptr)
+		frustum = FrustumPlanes::FromMatrix(camera->GetProjectionMatrix() * camera->GetWorldToCameraMatrix());
+	for (size_t i = 0; i < animations.size(); ++i)
+	{
+		auto animation = animations[i];
+		animation->Prepare();
+		// the index as phase spreads characters of the same LOD over the frames of its interval
+		animation->SetLOD(ComputeLOD(animation, camera, frustum), m_LODSettings, static_cast<int>(i));
+	}
+
+	// characters are independent, sample their poses on worker threads
+	JobSystem::GetInstance().ParallelFor(0, static_cast<int>(animations.size()), s_SampleGrainSize,
+		[&animations, deltaTime](int first, int last) {
+			for (int i = first; i < last; ++i)
+				animations[i]->SamplePose(deltaTime);
+		});
+
+	// writing transforms marks the shared hierarchy dirty, keep it on the main thread
+	m_LODStats = AnimationLODStats();
 	for (auto animation : animations)
 	{
-		animation->Update(0.03333f);
+		animation->ApplyPose();
+		const int lod = static_cast<int>(animation->GetLOD());
+		m_LODStats.animationCount[lod]++;
+		m_LODStats.sampledCount[lod] += animation->IsPoseSampled();
+		m_LODStats.curveCount[lod] += animation->GetAppliedCurveCount();
 		//DrawSkeleton(animation->m_skeleton);
 	}
 }
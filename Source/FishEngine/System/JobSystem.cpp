@@ -0,0 +1,281 @@
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace FishEngine
+{
+	thread_local int JobSystem::s_ThreadIndex = -1;
+
+	void JobSystem::Init(int threadCount)
+	{
+		if (!m_Queues.empty())
+			Clean();
+
+		if (threadCount <= 0)
+			threadCount = static_cast<int>(std::thread::hardware_concurrency());
+		m_ThreadCount = std::max(threadCount, 1);
+
+		// one more for foreign threads
+		for (int i = 0; i <= m_ThreadCount; ++i)
+		{
+			m_Queues.push_back(new WorkQueue);
+			m_JobPools.push_back(new Job[MaxJobsPerThread]);
+		}
+		m_JobPoolHeads.assign(m_ThreadCount+1, 0);
+
+		m_Quit = false;
+		s_ThreadIndex = 0;
+		for (int i = 1; i < m_ThreadCount; ++i)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerMain, this, i);
+		}
+	}
+
+
+	void JobSystem::Clean()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_Quit = true;
+		}
+		m_WakeUp.notify_all();
+		for (auto& w : m_Workers)
+			w.join();
+		m_Workers.clear();
+
+		for (auto q : m_Queues)
+			delete q;
+		m_Queues.clear();
+		for (auto p : m_JobPools)
+			delete[] p;
+		m_JobPools.clear();
+		m_JobPoolHeads.clear();
+		m_QueuedJobs = 0;
+		m_ThreadCount = 1;
+	}
+
+
+	Job* JobSystem::AllocateJob()
+	{
+		Assert(!m_JobPools.empty());
+		static_assert((MaxJobsPerThread & (MaxJobsPerThread-1)) == 0, "MaxJobsPerThread must be power of 2");
+		const int index = GetQueueIndex();
+		uint32_t slot;
+		if (s_ThreadIndex >= 0)
+		{
+			slot = m_JobPoolHeads[index]++;
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_ForeignPoolMutex);
+			slot = m_JobPoolHeads[index]++;
+		}
+		Job* job = &m_JobPools[index][slot & (MaxJobsPerThread-1)];
+
+		// the ring wrapped around onto a job that is still in flight
+		Wait(job);
+		return job;
+	}
+
+
+	JobHandle JobSystem::CreateJob(std::function<void()> function)
+	{
+		Job* job = AllocateJob();
+		job->function = std::move(function);
+		job->parent = nullptr;
+		job->unfinished.store(1, std::memory_order_relaxed);
+		job->pending.store(1, std::memory_order_relaxed);
+		job->continuationCount.store(0, std::memory_order_relaxed);
+		return job;
+	}
+
+
+	JobHandle JobSystem::CreateChildJob(JobHandle parent, std::function<void()> function)
+	{
+		parent->unfinished.fetch_add(1);
+		Job* job = CreateJob(std::move(function));
+		job->parent = parent;
+		return job;
+	}
+
+
+	void JobSystem::AddDependency(JobHandle ancestor, JobHandle continuation)
+	{
+		int i = ancestor->continuationCount.fetch_add(1);
+		Assert(i < Job::MaxContinuations);
+		ancestor->continuations[i] = continuation;
+		continuation->pending.fetch_add(1);
+	}
+
+
+	void JobSystem::Run(JobHandle job)
+	{
+		if (job->pending.fetch_sub(1) == 1)
+			Push(job);
+	}
+
+
+	void JobSystem::Wait(JobHandle job)
+	{
+		while (!IsFinished(job))
+		{
+			Job* next = GetJob();
+			if (next != nullptr)
+				Execute(next);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+
+	void JobSystem::Push(Job* job)
+	{
+		auto q = m_Queues[GetQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(q->mutex);
+			q->jobs.push_back(job);
+		}
+		m_QueuedJobs.fetch_add(1);
+
+		// pairs with WorkerMain: either we see the sleeper, or the sleeper sees m_QueuedJobs
+		if (m_SleepingWorkers.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_WakeUp.notify_one();
+		}
+	}
+
+
+	Job* JobSystem::GetJob()
+	{
+		const int self = GetQueueIndex();
+		const int queueCount = static_cast<int>(m_Queues.size());
+		Job* job = nullptr;
+
+		// own queue, LIFO: the most recently pushed job is the most likely to be in cache
+		{
+			auto q = m_Queues[self];
+			std::lock_guard<std::mutex> lock(q->mutex);
+			if (!q->jobs.empty())
+			{
+				job = q->jobs.back();
+				q->jobs.pop_back();
+			}
+		}
+
+		// steal, FIFO: the oldest job is usually the biggest one(e.g. the root of a split)
+		for (int i = 1; job == nullptr && i < queueCount; ++i)
+		{
+			auto q = m_Queues[(self + i) % queueCount];
+			std::lock_guard<std::mutex> lock(q->mutex);
+			if (!q->jobs.empty())
+			{
+				job = q->jobs.front();
+				q->jobs.pop_front();
+			}
+		}
+
+		if (job != nullptr)
+			m_QueuedJobs.fetch_sub(1);
+		return job;
+	}
+
+
+	void JobSystem::Execute(Job* job)
+	{
+		if (job->function)
+		{
+			job->function();
+			job->function = nullptr;	// release captures now, not when the slot is recycled
+		}
+		Finish(job);
+	}
+
+
+	void JobSystem::Finish(Job* job)
+	{
+		// copied before the decrement: once unfinished is 0 the owner may recycle the slot
+		Job* parent = job->parent;
+		const int count = job->continuationCount.load();
+		Job* continuations[Job::MaxContinuations];
+		std::copy(job->continuations, job->continuations + count, continuations);
+
+		if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		if (parent != nullptr)
+			Finish(parent);
+
+		for (int i = 0; i < count; ++i)
+			Run(continuations[i]);
+	}
+
+
+	void JobSystem::WorkerMain(int index)
+	{
+		s_ThreadIndex = index;
+		while (!m_Quit)
+		{
+			Job* job = GetJob();
+			if (job != nullptr)
+			{
+				Execute(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_SleepingWorkers.fetch_add(1);
+			m_WakeUp.wait(lock, [this]() { return m_QueuedJobs.load() > 0 || m_Quit; });
+			m_SleepingWorkers.fetch_sub(1);
+		}
+	}
+
+
+	void JobSystem::ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+	{
+		const int count = end - begin;
+		if (count <= 0)
+			return;
+		grainSize = std::max(grainSize, 1);
+		if (m_ThreadCount <= 1 || count <= grainSize)
+		{
+			body(begin, end);
+			return;
+		}
+
+		// a few chunks per thread so that stealing can even out uneven chunks
+		int chunkCount = std::min((count + grainSize - 1) / grainSize, m_ThreadCount * 4);
+		JobHandle root = CreateJob(nullptr);
+		for (int i = 0; i < chunkCount; ++i)
+		{
+			int first = begin + static_cast<int>(static_cast<int64_t>(count) * i / chunkCount);
+			int last = begin + static_cast<int>(static_cast<int64_t>(count) * (i+1) / chunkCount);
+			JobHandle job = CreateChildJob(root, [&body, first, last]() { body(first, last); });
+			Run(job);
+		}
+		Finish(root);	// the root itself has no work
+		Wait(root);
+	}
+
+
+	void JobSystem::RunOnMainThread(std::function<void()> f)
+	{
+		std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+		m_MainThreadJobs.push_back(std::move(f));
+	}
+
+
+	void JobSystem::ExecuteMainThreadJobs()
+	{
+		Assert(s_ThreadIndex == 0);
+		{
+			std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+			std::swap(m_MainThreadJobs, m_MainThreadJobsExecuting);
+		}
+		// jobs queued from here on run next frame
+		for (auto& f : m_MainThreadJobsExecuting)
+			f();
+		m_MainThreadJobsExecuting.clear();
+	}
+}
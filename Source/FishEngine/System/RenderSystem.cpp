@@ -14,6 +14,11 @@
 #include <FishEngine/Render/Material.hpp>
 #include <FishEngine/Render/Mesh.hpp>
 #include <FishEngine/Render/Pipeline.hpp>
+#include <FishEngine/Math/Frustum.hpp>
+#include <FishEngine/Render/Culling.hpp>
+#include <FishEngine/Render/InstanceBatcher.hpp>
+#include <FishEngine/Render/RendererRegistry.hpp>
+#include <FishEngine/System/JobSystem.hpp>
 
 #include <FishEditor/Path.hpp>
 
@@ -32,15 +37,70 @@
 
 namespace FishEngine
 {
+	// skinned meshes share one vertex buffer that holds the skinned result of the last renderer,
+	// so they can not be instanced.
+	inline bool IsInstanceable(const RenderObject& ro)
+	{
+		return ro.renderer->GetClassID() != SkinnedMeshRenderer::ClassID;
+	}
+
 
-	void RenderShadowMap(Shader* shader, Camera* camera, Light* light, std::vector<RenderObject> const& renderObjects)
+	// group objects by mesh(the shader is fixed in depth & shadow pass)
+	void BuildMeshBatches(InstanceBatcher& batcher, std::vector<RenderObject> const& renderObjects, std::vector<int> const& indices)
 	{
-		if (light == nullptr)
+		batcher.Clear();
+		for (int index : indices)
 		{
-			return;
+			auto& ro = renderObjects[index];
+			auto& modelMat = ro.gameObject->GetTransform()->GetLocalToWorldMatrix();
+			batcher.Add(ro.mesh, nullptr, modelMat, index, IsInstanceable(ro));
 		}
+		batcher.Build();
+	}
 
-#define DEBUG_SHADOW 1
+
+	// Draw every batch with one shader.
+	// Batches with more than one draw use a single instanced call if the shader has an instancing variant.
+	void DrawBatches(Shader* shader, const InstanceBatcher& batcher)
+	{
+		auto& matrices = batcher.GetMatrices();
+		bool instancedProgram = false;
+		shader->Use();
+		for (auto& batch : batcher.GetBatches())
+		{
+			batch.mesh->BindVertexArray();
+			if (batch.count > 1 && shader->SupportsInstancing())
+			{
+				if (!instancedProgram)
+				{
+					shader->UseInstanced();
+					instancedProgram = true;
+				}
+				Pipeline::UpdateInstanceMatrices(&matrices[batch.first], batch.count);
+				Pipeline::BindInstanceAttributes();
+				batch.mesh->DrawElementsInstanced(batch.count);
+			}
+			else
+			{
+				if (instancedProgram)
+				{
+					shader->Use();
+					instancedProgram = false;
+				}
+				for (int i = batch.first; i < batch.first + batch.count; ++i)
+				{
+					Pipeline::UpdatePerDrawUniforms(matrices[i]);
+					batch.mesh->DrawElements(-1);
+				}
+			}
+		}
+		glBindVertexArray(0);
+	}
+
+
+	// compute the view & projection matrix of each cascade
+	void UpdateCascades(Camera* camera, Light* light)
+	{
 		auto    camera_to_world = camera->GetCameraToWorldMatrix();
 		float   near = camera->GetNearClipPlane();
 		//float   far = camera->farClipPlane();
@@ -161,6 +221,17 @@ namespace FishEngine
 			light->m_cascadesSplitPlaneNear[splitInex] = split_near;
 			light->m_cascadesSplitPlaneFar[splitInex] = split_far;
 		}
+	}
+
+
+	void RenderShadowMap(Shader* shader, Light* light, InstanceBatcher const& casters)
+	{
+		if (light == nullptr)
+		{
+			return;
+		}
+
+#define DEBUG_SHADOW 1
 
 ////		auto shadow_map_material = Material::builtinMaterial("CascadedShadowMap");
 //		static Material* shadow_map_material = nullptr;
@@ -187,14 +258,8 @@ namespace FishEngine
 		glCullFace(GL_BACK);
 		glEnable(GL_DEPTH_CLAMP);
 
-		for (auto&& ro : renderObjects)
-		{
-			if (!ro.renderer->GetEnabled() || ro.renderer->GetCastShadows() == ShadowCastingMode::Off)
-				continue;
-			auto modelMat = ro.gameObject->GetTransform()->GetLocalToWorldMatrix();
-			Pipeline::UpdatePerDrawUniforms(modelMat);
-			ro.mesh->Render(-1);
-		}
+		// one draw for all cascades, the geometry shader writes every layer
+		DrawBatches(shader, casters);
 
 		glDisable(GL_DEPTH_CLAMP);
 		Pipeline::PopRenderTarget();
@@ -341,7 +406,7 @@ namespace FishEngine
 	}
 
 
-	void RenderDepthPass(Shader* shader, std::vector<RenderObject> const& renderObjects)
+	void RenderDepthPass(Shader* shader, InstanceBatcher const& batcher)
 	{
 		glFrontFace(GL_CW);
 		glEnable(GL_DEPTH_TEST);
@@ -349,69 +414,190 @@ namespace FishEngine
 		glCullFace(GL_BACK);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-		shader->Use();
-		for (auto&& ro : renderObjects)
-		{
-			auto& modelMat = ro.gameObject->GetTransform()->GetLocalToWorldMatrix();
-			Pipeline::UpdatePerDrawUniforms(modelMat);
-			shader->Use();
-			ro.mesh->Render(-1);
-		}
+		DrawBatches(shader, batcher);
 	}
 
 	void RenderSystem::GetRenderObjects()
 	{
 		this->m_RenderObjects.clear();
 		auto scene = SceneManager::GetActiveScene();
-		auto mfs = scene->FindComponents<MeshFilter>();
 
-//		auto& mrs = Object::FindObjectsOfType<MeshRenderer>();
-		std::vector<GameObject*> intersection;
-		for (auto mf : mfs)
+		auto& registry = RendererRegistry::GetInstance();
+		registry.Sync();
+		auto& renderers = registry.GetRenderers();
+		m_RenderObjects.reserve(renderers.size());
+		for (auto&& r : renderers)
 		{
-			auto go = ((MeshFilter*)mf)->GetGameObject();
-			if (!go->IsActiveInHierarchy())
+			auto go = r.gameObject;
+			if (go->GetScene() != scene)
 				continue;
-//			auto mr = GetComponent<MeshRenderer>(go);
-			auto mr = go->GetComponent<MeshRenderer>();
-			if (mr != nullptr)
+			const Bounds* localBounds = &r.mesh->m_bounds;
+			if (r.renderer->GetClassID() == SkinnedMeshRenderer::ClassID)
+			{
+				auto skinned = static_cast<SkinnedMeshRenderer*>(r.renderer);
+				skinned->UpdateMatrixPalette();
+				if (skinned->GetAnimatedBounds().IsValid())
+					localBounds = &skinned->GetAnimatedBounds();
+			}
+			m_RenderObjects.emplace_back(go, r.renderer, r.mesh, r.material);
+			m_RenderObjects.back().bounds = localBounds->Transform(go->GetTransform()->GetLocalToWorldMatrix());
+		}
+		glCheckError();
+	}
+
+
+	void MaskToIndices(const std::vector<uint32_t>& mask, std::vector<int>& indices)
+	{
+		indices.clear();
+		const int words = static_cast<int>(mask.size());
+		for (int w = 0; w < words; ++w)
+		{
+			uint32_t bits = mask[w];
+			for (int b = 0; bits != 0; ++b, bits >>= 1)
 			{
-				intersection.push_back(go);
+				if (bits & 1u)
+					indices.push_back(w * 32 + b);
 			}
 		}
+	}
+
+
+	void RenderSystem::Cull(Camera* camera)
+	{
+		auto worldToClip = camera->GetProjectionMatrix() * camera->GetWorldToCameraMatrix();
+		auto frustum = FrustumPlanes::FromMatrix(worldToClip);
+
+		m_BoundsCache.Clear();
+		m_BoundsCache.Reserve(static_cast<int>(m_RenderObjects.size()));
+		for (auto&& ro : m_RenderObjects)
+			m_BoundsCache.Add(ro.bounds);
+
+		Culling::CullBounds(frustum, m_BoundsCache, m_VisibilityMask);
+		MaskToIndices(m_VisibilityMask, m_VisibleObjects);
+	}
+
+
+	void RenderSystem::SortVisibleObjects(Camera* camera)
+	{
+		auto cameraPos = camera->GetTransform()->GetPosition();
+		auto cameraDir = camera->GetTransform()->GetForward();
+		const float invFar = 1.0f / camera->GetFarClipPlane();
+
+		m_SortKeys.resize(m_VisibleObjects.size());
+		for (size_t i = 0; i < m_VisibleObjects.size(); ++i)
+		{
+			auto& ro = m_RenderObjects[m_VisibleObjects[i]];
+			float depth = Vector3::Dot(ro.bounds.center() - cameraPos, cameraDir) * invFar;
+			uint32_t program = ro.material->GetShader()->GetClassIndex();
+			uint32_t material = ro.material->GetClassIndex();
+			uint32_t mesh = ro.mesh->GetClassIndex();
+			m_SortKeys[i] = RenderSorter::MakeSortKey(ro.material->GetRenderQueue(), program, material, mesh, depth);
+		}
+		RenderSorter::RadixSort(m_SortKeys, m_VisibleObjects, m_SortTempKeys, m_SortTempValues);
+	}
+
 
-		for (auto go : intersection)
+	void RenderSystem::SubmitVisibleObjects()
+	{
+		// group opaque objects with the same mesh and material, keep the sorted order of the first object of each group.
+		// transparent objects are never grouped, their order matters.
+		m_Batcher.Clear();
+		for (int index : m_VisibleObjects)
+		{
+			auto& ro = m_RenderObjects[index];
+			auto& model = ro.gameObject->GetTransform()->GetLocalToWorldMatrix();
+			bool instanceable = IsInstanceable(ro)
+				&& !RenderSorter::IsTransparent(ro.material->GetRenderQueue())
+				&& ro.material->GetShader()->SupportsInstancing();
+			m_Batcher.Add(ro.mesh, ro.material, model, index, instanceable);
+		}
+		m_Batcher.Build();
+
+		m_Stats.Reset();
+		Shader* lastShader = nullptr;
+		bool lastInstanced = false;
+		Mesh* lastMesh = nullptr;
+		auto& matrices = m_Batcher.GetMatrices();
+		for (auto& batch : m_Batcher.GetBatches())
 		{
-			auto mesh = go->GetComponent<MeshFilter>()->GetMesh();
-			if (mesh != nullptr)
+			const bool instanced = batch.count > 1;
+			auto shader = batch.material->GetShader();
+			if (shader != lastShader || instanced != lastInstanced)
+			{
+				if (instanced)
+					shader->UseInstanced();
+				else
+					shader->Use();
+				lastShader = shader;
+				lastInstanced = instanced;
+				m_Stats.shaderChanges++;
+			}
+			else
 			{
-				auto renderer = go->GetComponent<MeshRenderer>();
-				auto material = renderer->GetMaterial();
-				if (material == nullptr)
-					material = Material::GetErrorMaterial();
+				m_Stats.shaderChangesSaved++;
+			}
+
+			if (batch.mesh != lastMesh)
+			{
+				batch.mesh->BindVertexArray();
+				lastMesh = batch.mesh;
+				m_Stats.meshChanges++;
+			}
+			else
+			{
+				m_Stats.meshChangesSaved++;
+			}
 
-				m_RenderObjects.emplace_back(go, renderer, mesh, material);
+			if (instanced)
+			{
+				Pipeline::UpdateInstanceMatrices(&matrices[batch.first], batch.count);
+				Pipeline::BindInstanceAttributes();
+				batch.mesh->DrawElementsInstanced(batch.count);
+				m_Stats.drawCalls++;
+				m_Stats.instancedDrawCalls++;
+				m_Stats.instances += batch.count;
+			}
+			else
+			{
+				Pipeline::UpdatePerDrawUniforms(matrices[batch.first]);
+				batch.mesh->DrawElements(-1);
+				m_Stats.drawCalls++;
 			}
 		}
-		glCheckError();
+		glBindVertexArray(0);
+	}
+
 
-		auto skinnedMRs = scene->FindComponents<SkinnedMeshRenderer>();
-		for (auto r : skinnedMRs)
+	void RenderSystem::CullShadowCasters(Light* light)
+	{
+		// objects that can not cast shadows
+		auto& casterMask = m_CasterMask;
+		casterMask.assign(m_VisibilityMask.size(), 0u);
+		const int count = static_cast<int>(m_RenderObjects.size());
+		for (int index = 0; index < count; ++index)
 		{
-			auto mesh = r->GetSharedMesh();
-			if (mesh == nullptr)
-				continue;
-			auto material = r->GetMaterial();
-			if (material == nullptr)
-				material = Material::GetErrorMaterial();
+			auto& ro = m_RenderObjects[index];
+			if (ro.renderer->GetEnabled() && ro.renderer->GetCastShadows() != ShadowCastingMode::Off)
+				casterMask[index >> 5] |= 1u << (index & 31);
+		}
 
-			auto go = r->GetGameObject();
-			if (!go->IsActiveInHierarchy())
-				continue;
-			
-			r->UpdateMatrixPalette();
-			m_RenderObjects.emplace_back(go, r, mesh, material);
+		auto& anyCascade = m_AnyCascadeMask;
+		anyCascade.assign(casterMask.size(), 0u);
+		for (int i = 0; i < 4; ++i)
+		{
+			auto worldToClip = light->m_projectMatrixForShadowMap[i] * light->m_viewMatrixForShadowMap[i];
+			auto cascade = FrustumPlanes::FromMatrix(worldToClip);
+			// objects between the light and the near plane still cast shadows(depth is clamped)
+			cascade.planes[FrustumPlanes::Near] = Vector4(0, 0, 0, 1);
+			Culling::CullBounds(cascade, m_BoundsCache, m_VisibilityMask);
+			for (size_t w = 0; w < casterMask.size(); ++w)
+			{
+				m_VisibilityMask[w] &= casterMask[w];
+				anyCascade[w] |= m_VisibilityMask[w];
+			}
+			MaskToIndices(m_VisibilityMask, m_CascadeCasters[i]);
 		}
+		MaskToIndices(anyCascade, m_ShadowCasters);
 	}
 
 
@@ -436,7 +622,10 @@ namespace FishEngine
 
 	void RenderSystem::Update()
 	{
+		JobSystem::GetInstance().ExecuteMainThreadJobs();
+
 		auto scene = SceneManager::GetActiveScene();
+		scene->UpdateWorldMatrices();
 		Camera* camera = Camera::GetMainCamera();
 
 //		auto light = scene->FindComponent<Light>();
@@ -464,6 +653,8 @@ namespace FishEngine
 
 
 		this->GetRenderObjects();
+		this->Cull(camera);
+		this->SortVisibleObjects(camera);
 
 		GLint old_framebuffer = 0;
 		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &old_framebuffer);
@@ -476,12 +667,16 @@ namespace FishEngine
 		m_SceneDepth->Resize(w, h);
 		Pipeline::PushRenderTarget(m_DepthPassRT);
 		glViewport(0, 0, w, h);
-		RenderDepthPass(m_RenderDepthShader, m_RenderObjects);
+		BuildMeshBatches(m_Batcher, m_RenderObjects, m_VisibleObjects);
+		RenderDepthPass(m_RenderDepthShader, m_Batcher);
 		Pipeline::PopRenderTarget();
 
 
 		// ShadowMap - CSM
-		RenderShadowMap(m_CSMShader, camera, light, m_RenderObjects);
+		UpdateCascades(camera, light);
+		this->CullShadowCasters(light);
+		BuildMeshBatches(m_Batcher, m_RenderObjects, m_ShadowCasters);
+		RenderShadowMap(m_CSMShader, light, m_Batcher);
 
 //		glFlush();
 
@@ -520,12 +715,7 @@ namespace FishEngine
 		glEnable(GL_CULL_FACE);
 		glCullFace(GL_BACK);
 
-		for (auto&& ro : m_RenderObjects)
-		{
-			auto& model = ro.gameObject->GetTransform()->GetLocalToWorldMatrix();
-			Pipeline::UpdatePerDrawUniforms(model);
-			Graphics::DrawMesh(ro.mesh, ro.material, -1);
-		}
+		this->SubmitVisibleObjects();
 
 
 		Pipeline::PopRenderTarget();
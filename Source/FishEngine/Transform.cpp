@@ -2,9 +2,15 @@
 #include <FishEngine/Scene.hpp>
 #include <FishEngine/GameObject.hpp>
 #include <FishEngine/Scene.hpp>
+#include <FishEngine/Render/RendererRegistry.hpp>
+#include <FishEngine/TransformHierarchy.hpp>
+
+#include <algorithm>
 
 namespace FishEngine
 {
+	std::atomic<uint32_t> Transform::s_ChangeVersion {1};
+
 	Transform::Transform() : Component(Transform::ClassID, ClassName)
 	{
 		LOGF;
@@ -21,8 +27,20 @@ namespace FishEngine
 			delete m_Children[i]->GetGameObject();
 		}
 //		m_children.clear();
-		// TODO
-		SetParent(nullptr); // remove from parent
+
+		// remove from parent(or scene roots) without re-parenting, so no dangling pointer is left behind
+		if (m_Father != nullptr)
+		{
+			auto& siblings = m_Father->m_Children;
+			siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+		}
+		else if (m_GameObject != nullptr && m_GameObject->GetScene() != nullptr)
+		{
+			auto scene = m_GameObject->GetScene();
+			if (!scene->m_Cleaning)
+				scene->RemoveRootTransform(this);
+		}
+		TransformHierarchy::SetStructureDirty();
 	}
 	
 	void Transform::SetRootOrder(int index)
@@ -44,6 +62,7 @@ namespace FishEngine
 		c[index]->m_RootOrder = old;
 		std::swap(c[index], c[old]);
 		m_RootOrder = index;
+		TransformHierarchy::SetStructureDirty();
 	}
 	
 	
@@ -66,12 +85,22 @@ namespace FishEngine
 	
 	void Transform::UpdateMatrix() const
 	{
-		if (!m_IsDirty)
+		// no transform anywhere changed since this one was last brought up to date
+		const uint32_t changeVersion = s_ChangeVersion.load(std::memory_order_relaxed);
+		if (m_CheckedVersion == changeVersion)
+			return;
+		m_CheckedVersion = changeVersion;
+
+		// MakeDirty does not touch children, so a clean matrix is still stale when any ancestor changed
+		if (m_Father != nullptr)
+			m_Father->UpdateMatrix();
+		if (!m_IsDirty && (m_Father == nullptr || m_Father->m_Version == m_ParentVersion))
 			return;
 #if 1
 		m_LocalToWorldMatrix.SetTRS(m_LocalPosition, m_LocalRotation, m_LocalScale);
 		if (m_Father != nullptr) {
-			m_LocalToWorldMatrix = m_Father->GetLocalToWorldMatrix() * m_LocalToWorldMatrix;
+			m_LocalToWorldMatrix = m_Father->m_LocalToWorldMatrix * m_LocalToWorldMatrix;
+			m_ParentVersion = m_Father->m_Version;
 		}
 //		m_worldToLocalMatrix = m_localToWorldMatrix.inverse();
 #else
@@ -83,11 +112,20 @@ namespace FishEngine
 			m_worldToLocalMatrix = m_worldToLocalMatrix * m_Father.lock()->worldToLocalMatrix();
 		}
 #endif
+		m_Version++;
 		m_IsDirty = false;
 	}
 	
 	
 	void Transform::SetParent(Transform* parent, bool worldPositionStays)
+	{
+		auto old_parent = m_Father;
+		SetParentImpl(parent, worldPositionStays);
+		if (m_Father != old_parent)
+			RendererRegistry::GetInstance().OnHierarchyChanged(m_GameObject);
+	}
+
+	void Transform::SetParentImpl(Transform* parent, bool worldPositionStays)
 	{
 		auto old_parent = m_Father;
 		if (parent == old_parent)
@@ -95,14 +133,6 @@ namespace FishEngine
 			return;
 		}
 
-		if (parent == nullptr)
-		{
-			auto scene = m_GameObject->GetScene();
-			scene->AddRootTransform(this);
-		}
-		else if (old_parent == nullptr)
-			SceneManager::GetActiveScene()->RemoveRootTransform(this);
-		
 		// new parent can not be child of this
 		auto p = parent;
 		while (p != nullptr)
@@ -114,15 +144,22 @@ namespace FishEngine
 			}
 			p = p->GetParent();
 		}
-		
+
+		if (parent == nullptr)
+		{
+			auto scene = m_GameObject->GetScene();
+			scene->AddRootTransform(this);
+		}
+		else if (old_parent == nullptr)
+			m_GameObject->GetScene()->RemoveRootTransform(this);
 		
 		// remove from old parent
 		if (old_parent != nullptr)
 		{
 			//p->m_children.remove(this);
-			// TODO: remove first, not remove all
 //			old_parent->m_children.erase(old_parent->m_children.begin()+m_RootOrder);
-			std::remove(old_parent->m_Children.begin(), old_parent->m_Children.end(), this);
+			auto& siblings = old_parent->m_Children;
+			siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
 		}
 		
 		// old_parent.localToWorld * old_localToWorld = new_parent.localToWorld * new_localToWorld
@@ -145,20 +182,17 @@ namespace FishEngine
 			Matrix4x4::Decompose(mat, &m_LocalPosition, &m_LocalRotation, &m_LocalScale);
 		}
 		//UpdateMatrix();
+		TransformHierarchy::SetStructureDirty();
 		MakeDirty();
 	}
 	
 	
 	void Transform::MakeDirty() const
 	{
-		if (!m_IsDirty)
-		{
-			for (auto& c : m_Children)
-			{
-				c->MakeDirty();
-			}
-			m_IsDirty = true;
-		}
+		m_IsDirty = true;
+		s_ChangeVersion.fetch_add(1, std::memory_order_relaxed);
+		if (m_Hierarchy != nullptr)
+			m_Hierarchy->SetDirty(m_HierarchyIndex);
 	}
 
 	
@@ -196,6 +230,7 @@ namespace FishEngine
 			children[index] = this;
 		}
 		m_RootOrder = index;
+		TransformHierarchy::SetStructureDirty();
 	}
 	
 	
@@ -0,0 +1,136 @@
+#include <FishEngine/TransformHierarchy.hpp>
+#include <FishEngine/Transform.hpp>
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <algorithm>
+
+namespace FishEngine
+{
+	std::atomic<uint32_t> TransformHierarchy::s_StructureVersion {1};
+	int TransformHierarchy::s_ParallelThreshold = 2048;
+
+	void TransformHierarchy::Rebuild(const std::vector<Transform*>& roots)
+	{
+		m_Transforms.clear();
+		m_Parent.clear();
+		m_RootOf.clear();
+		m_RootBegin.clear();
+
+		// depth-first, children pushed in reverse so they come out in sibling order
+		std::vector<std::pair<Transform*, int>> stack;
+		for (auto root : roots)
+		{
+			const int rootIndex = static_cast<int>(m_RootBegin.size());
+			m_RootBegin.push_back(static_cast<int>(m_Transforms.size()));
+			stack.emplace_back(root, -1);
+			while (!stack.empty())
+			{
+				auto t = stack.back().first;
+				int parent = stack.back().second;
+				stack.pop_back();
+				int index = static_cast<int>(m_Transforms.size());
+				t->m_Hierarchy = this;
+				t->m_HierarchyIndex = index;
+				m_Transforms.push_back(t);
+				m_Parent.push_back(parent);
+				m_RootOf.push_back(rootIndex);
+				auto& children = t->m_Children;
+				for (auto it = children.rbegin(); it != children.rend(); ++it)
+					stack.emplace_back(*it, index);
+			}
+		}
+		m_RootBegin.push_back(static_cast<int>(m_Transforms.size()));
+
+		const size_t n = m_Transforms.size();
+		m_LocalToWorld.resize(n);
+		m_Dirty.assign(n, 1);
+		m_RootDirty.assign(roots.size(), 1);
+		m_StructureVersion = s_StructureVersion.load(std::memory_order_relaxed);
+	}
+
+
+	void TransformHierarchy::UpdateRoots(int first, int last)
+	{
+		for (int r = first; r < last; ++r)
+		{
+			const int root = m_DirtyRoots[r];
+			const int begin = m_RootBegin[root];
+			const int end = m_RootBegin[root+1];
+
+			// parents come first, so m_Dirty[parent] already tells whether the parent was recomputed
+			for (int i = begin; i < end; ++i)
+			{
+				const int p = m_Parent[i];
+				if (m_Dirty[i] == 0 && (p < 0 || m_Dirty[p] == 0))
+					continue;
+				m_Dirty[i] = 1;
+
+				auto t = m_Transforms[i];
+				auto& l2w = m_LocalToWorld[i];
+				l2w.SetTRS(t->m_LocalPosition, t->m_LocalRotation, t->m_LocalScale);
+				if (p >= 0)
+				{
+					l2w = m_LocalToWorld[p] * l2w;
+					t->m_ParentVersion = m_Transforms[p]->m_Version;
+				}
+				t->m_LocalToWorldMatrix = l2w;
+				t->m_Version++;
+				t->m_IsDirty = false;
+			}
+
+			std::fill(m_Dirty.begin() + begin, m_Dirty.begin() + end, 0);
+			m_RootDirty[root] = 0;
+		}
+	}
+
+
+	void TransformHierarchy::UpdateWorldMatrices(const std::vector<Transform*>& roots)
+	{
+		if (m_StructureVersion != s_StructureVersion.load(std::memory_order_relaxed))
+			Rebuild(roots);
+
+		m_DirtyRoots.clear();
+		int total = 0;
+		for (int r = 0; r < static_cast<int>(m_RootDirty.size()); ++r)
+		{
+			if (m_RootDirty[r] != 0)
+			{
+				m_DirtyRoots.push_back(r);
+				total += m_RootBegin[r+1] - m_RootBegin[r];
+			}
+		}
+
+		const int rootCount = static_cast<int>(m_DirtyRoots.size());
+		auto& jobs = JobSystem::GetInstance();
+		int threadCount = jobs.GetThreadCount();
+		threadCount = std::min(threadCount, rootCount);
+		threadCount = std::min(threadCount, total / std::max(s_ParallelThreshold/2, 1));
+		if (total < s_ParallelThreshold || threadCount <= 1)
+		{
+			UpdateRoots(0, rootCount);
+			return;
+		}
+
+		// split the dirty roots into chunks of roughly total/threadCount transforms each;
+		// subtrees never straddle chunks, so no synchronization is needed inside the sweep
+		std::vector<int> split;
+		split.reserve(threadCount+1);
+		split.push_back(0);
+		int acc = 0;
+		for (int r = 0; r < rootCount && static_cast<int>(split.size()) < threadCount; ++r)
+		{
+			const int root = m_DirtyRoots[r];
+			acc += m_RootBegin[root+1] - m_RootBegin[root];
+			if (acc * threadCount >= total * static_cast<int>(split.size()))
+				split.push_back(r+1);
+		}
+		split.push_back(rootCount);
+
+		// ParallelFor returns only after every chunk is done, which is the barrier RenderSystem relies on
+		const int chunkCount = static_cast<int>(split.size()) - 1;
+		jobs.ParallelFor(0, chunkCount, 1, [this, &split](int first, int last) {
+			for (int i = first; i < last; ++i)
+				UpdateRoots(split[i], split[i+1]);
+		});
+	}
+}
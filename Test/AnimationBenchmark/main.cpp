@@ -0,0 +1,160 @@
+#include <FishEngine/System/AnimationSystem.hpp>
+#include <FishEngine/System/JobSystem.hpp>
+#include <FishEngine/Animation/Animation.hpp>
+#include <FishEngine/Animation/AnimationClip.hpp>
+#include <FishEngine/Animation/Avatar.hpp>
+#include <FishEngine/GameObject.hpp>
+#include <FishEngine/Transform.hpp>
+#include <FishEngine/Scene.hpp>
+#include <FishEngine/Component/Camera.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace FishEngine;
+
+// 4 limbs of 15 bones, roughly a game character
+constexpr int LimbCount = 4;
+constexpr int BonesPerLimb = 15;
+
+AnimationClip* CreateClip(Avatar* avatar, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> value(-30.f, 30.f);
+	auto clip = new AnimationClip;
+	clip->frameRate = 30;
+	clip->length = 2;
+	clip->m_avatar = avatar;
+	for (int limb = 0; limb < LimbCount; ++limb)
+	{
+		std::string path;
+		for (int b = 0; b < BonesPerLimb; ++b)
+		{
+			std::string name = "bone" + std::to_string(limb) + "_" + std::to_string(b);
+			avatar->m_boneToIndex[name] = static_cast<int>(avatar->m_indexToBoneName.size());
+			avatar->m_indexToBoneName.push_back(name);
+			path = b == 0 ? name : path + "/" + name;
+
+			std::vector<TKeyframe<Vector3>> position, eulers, scale;
+			for (int f = 0; f <= 60; f += 2)
+			{
+				const float time = f / 30.f;
+				position.push_back({time, Vector3(0, 1, 0), Vector3::zero, Vector3::zero});
+				eulers.push_back({time, Vector3(value(rng), value(rng), value(rng)), Vector3::zero, Vector3::zero});
+				scale.push_back({time, Vector3::one, Vector3::zero, Vector3::zero});
+			}
+			clip->m_positionCurve.push_back({path, TAnimationCurve<Vector3>(position)});
+			clip->m_eulersCurves.push_back({path, TAnimationCurve<Vector3>(eulers)});
+			clip->m_scaleCurves.push_back({path, TAnimationCurve<Vector3>(scale)});
+		}
+	}
+	clip->BuildSampledClip();
+	return clip;
+}
+
+// spacing > 0: a camera at the origin looks at rows of 10 characters going away from it
+Scene* CreateCrowd(int characterCount, AnimationClip* clip, float spacing = 0)
+{
+	auto scene = SceneManager::CreateScene("Crowd" + std::to_string(characterCount));
+	SceneManager::SetActiveScene(scene);
+	if (spacing > 0)
+	{
+		auto cameraObject = new GameObject("Main Camera");
+		cameraObject->AddComponent(new Camera);
+	}
+	for (int c = 0; c < characterCount; ++c)
+	{
+		auto character = new GameObject("Character");
+		if (spacing > 0)
+			character->GetTransform()->SetPosition(((c % 10) - 4.5f) * spacing, 0, (1 + c / 10) * spacing);
+		for (int limb = 0; limb < LimbCount; ++limb)
+		{
+			Transform* parent = character->GetTransform();
+			for (int b = 0; b < BonesPerLimb; ++b)
+			{
+				auto bone = new GameObject("bone" + std::to_string(limb) + "_" + std::to_string(b));
+				bone->GetTransform()->SetParent(parent, false);
+				parent = bone->GetTransform();
+			}
+		}
+		auto animation = new Animation;
+		character->AddComponent(animation);
+		animation->SetClip(clip);
+	}
+	return scene;
+}
+
+double Benchmark(int threadCount, Scene* scene, int iterations)
+{
+	auto& js = JobSystem::GetInstance();
+	js.Init(threadCount);
+	SceneManager::SetActiveScene(scene);
+	auto& system = AnimationSystem::GetInstance();
+	system.Update();	// warm up
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		system.Update();
+	auto end = std::chrono::high_resolution_clock::now();
+	js.Clean();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+// usage: AnimationBenchmark [maxThreads]
+int main(int argc, char** argv)
+{
+	constexpr int iterations = 50;
+	int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	if (argc > 1)
+		maxThreads = std::max(atoi(argv[1]), 1);
+
+	std::mt19937 rng(42);
+	auto sampledClip = CreateClip(new Avatar, rng);
+	auto compressedClip = CreateClip(new Avatar, rng);
+	compressedClip->Compress(CompressedAnimationClip::Settings());
+
+	printf("bones per character: %d, max threads: %d\n", LimbCount * BonesPerLimb, maxThreads);
+	for (auto clip : { sampledClip, compressedClip })
+	{
+		printf("%s clip\n", clip == sampledClip ? "sampled" : "compressed");
+		printf("characters");
+		for (int threads = 1; threads <= maxThreads; threads *= 2)
+			printf(" %6d thr", threads);
+		printf("   (ms/frame)\n");
+		for (int characters = 1; characters <= 1000; characters *= 10)
+		{
+			auto scene = CreateCrowd(characters, clip);
+			printf("%10d", characters);
+			for (int threads = 1; threads <= maxThreads; threads *= 2)
+				printf(" %10.3f", Benchmark(threads, scene, iterations));
+			printf("\n");
+		}
+	}
+
+	// a crowd seen by a camera, most characters are small on the screen
+	auto& system = AnimationSystem::GetInstance();
+	auto scene = CreateCrowd(1000, compressedClip, 2.0f);
+	printf("1000 characters in view, 1 thread (ms/frame)\n");
+	for (bool lod : { false, true })
+	{
+		system.GetLODSettings().enabled = lod;
+		printf("LOD %-3s %10.3f\n", lod ? "on" : "off", Benchmark(1, scene, iterations));
+		const char* names[] = { "Full", "Reduced", "Minimal", "Offscreen" };
+		auto& stats = system.GetLODStats();
+		for (int i = 0; i < (int)AnimationLOD::Count; ++i)
+			printf("  %-9s characters %4d, sampled %4d, curves %6d\n", names[i], stats.animationCount[i], stats.sampledCount[i], stats.curveCount[i]);
+	}
+
+	// crossfading samples two clips per character but still writes every bone once
+	system.GetLODSettings().enabled = false;
+	scene = CreateCrowd(100, sampledClip);
+	printf("100 characters, 1 thread (ms/frame)\n");
+	printf("single clip %10.3f\n", Benchmark(1, scene, iterations));
+	for (auto animation : scene->FindComponents<Animation>())
+		animation->CrossFade(compressedClip, 1000.0f);
+	printf("crossfade   %10.3f\n", Benchmark(1, scene, iterations));
+	return 0;
+}
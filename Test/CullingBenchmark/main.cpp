@@ -0,0 +1,86 @@
+#include <FishEngine/Render/Culling.hpp>
+#include <FishEngine/Internal/SIMD.hpp>
+#include <FishEngine/Math/Matrix4x4.hpp>
+
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using namespace FishEngine;
+
+typedef void (*CullFunction)(const FrustumPlanes&, const BoundsCache&, std::vector<uint32_t>&);
+
+double Benchmark(CullFunction func, const FrustumPlanes* frustums, int frustumCount, const BoundsCache& bounds, std::vector<uint32_t>& mask, int iterations)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		for (int f = 0; f < frustumCount; ++f)
+			func(frustums[f], bounds, mask);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int CountVisible(const std::vector<uint32_t>& mask, int count)
+{
+	int visible = 0;
+	for (int i = 0; i < count; ++i)
+		visible += Culling::IsVisible(mask, i);
+	return visible;
+}
+
+int main()
+{
+	constexpr int objectCount = 20000;
+	constexpr int iterations = 200;
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(-500.f, 500.f);
+	std::uniform_real_distribution<float> size(0.5f, 10.f);
+
+	BoundsCache bounds;
+	bounds.Reserve(objectCount);
+	for (int i = 0; i < objectCount; ++i)
+	{
+		Vector3 center(position(rng), position(rng) * 0.1f, position(rng));
+		Vector3 s(size(rng), size(rng), size(rng));
+		bounds.Add(Bounds(center, s));
+	}
+
+	// 1 camera + 4 cascades
+	FrustumPlanes frustums[5];
+	auto view = Matrix4x4::LookAt(Vector3(0, 10, -50), Vector3(0, 0, 0), Vector3::up);
+	frustums[0] = FrustumPlanes::FromMatrix(Matrix4x4::Perspective(60, 16.f / 9.f, 0.3f, 1000.f) * view);
+	for (int i = 1; i < 5; ++i)
+	{
+		float r = 10.f * i * i;
+		auto lightView = Matrix4x4::LookAt(Vector3(r, 100, r), Vector3(0, 0, 0), Vector3::up);
+		frustums[i] = FrustumPlanes::FromMatrix(Matrix4x4::Ortho(-r, r, -r, r, 0, 2 * r + 100) * lightView);
+	}
+
+	std::vector<uint32_t> scalarMask, sseMask, avxMask;
+	for (auto& f : frustums)
+	{
+		Culling::CullBounds_Scalar(f, bounds, scalarMask);
+		Culling::CullBounds_SSE(f, bounds, sseMask);
+		avxMask = sseMask;
+		if (CPU::HasAVX())
+			Culling::CullBounds_AVX(f, bounds, avxMask);
+		if (scalarMask != sseMask || scalarMask != avxMask)
+		{
+			puts("FAILED: SIMD kernel result differs from scalar kernel");
+			return 1;
+		}
+	}
+
+	printf("objects: %d, visible from camera: %d\n", objectCount, (Culling::CullBounds(frustums[0], bounds, scalarMask), CountVisible(scalarMask, objectCount)));
+	printf("kernel: %s\n", Culling::KernelName());
+	printf("scalar: %.3f ms/frame\n", Benchmark(Culling::CullBounds_Scalar, frustums, 5, bounds, scalarMask, iterations));
+	printf("SSE:    %.3f ms/frame\n", Benchmark(Culling::CullBounds_SSE, frustums, 5, bounds, sseMask, iterations));
+	if (CPU::HasAVX())
+		printf("AVX:    %.3f ms/frame\n", Benchmark(Culling::CullBounds_AVX, frustums, 5, bounds, avxMask, iterations));
+	else
+		puts("AVX:    not supported");
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace FishEngine;
+
+// a few hundred flops per element, roughly the cost of one bone or one culling test
+void Work(std::vector<float>& data, int first, int last)
+{
+	for (int i = first; i < last; ++i)
+	{
+		float x = data[i];
+		for (int k = 0; k < 64; ++k)
+			x = std::sqrt(x * x + 1.0f) * 0.5f;
+		data[i] = x;
+	}
+}
+
+double Benchmark(int threadCount, std::vector<float>& data, int iterations)
+{
+	auto& js = JobSystem::GetInstance();
+	js.Init(threadCount);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		js.ParallelFor(0, static_cast<int>(data.size()), 1024, [&data](int first, int last) {
+			Work(data, first, last);
+		});
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	js.Clean();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+// usage: JobSystemBenchmark [maxThreads]
+int main(int argc, char** argv)
+{
+	constexpr int elementCount = 1 << 18;
+	constexpr int iterations = 20;
+	std::vector<float> data(elementCount, 1.0f);
+
+	int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	if (argc > 1)
+		maxThreads = std::max(atoi(argv[1]), 1);
+	printf("elements: %d, max threads: %d\n", elementCount, maxThreads);
+
+	double baseline = 0;
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		double ms = Benchmark(threads, data, iterations);
+		if (threads == 1)
+			baseline = ms;
+		printf("%2d threads: %8.3f ms/frame, speedup %.2fx\n", threads, ms, baseline / ms);
+	}
+	return 0;
+}
@@ -0,0 +1,307 @@
+#include <FishEditor/Serialization/YAMLArchive.hpp>
+#include <FishEditor/Serialization/NativeFormatImporter.hpp>
+#include <FishEditor/AssetDatabase.hpp>
+#include <FishEngine/GameObject.hpp>
+#include <FishEngine/Transform.hpp>
+#include <FishEngine/Scene.hpp>
+#include <FishEngine/Prefab.hpp>
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+using namespace FishEngine;
+using namespace FishEditor;
+
+const char* SourcePrefabGUID = "5e7100000000000000000000000000a1";
+const char* SourcePrefabPath = "Assets/SceneLoadBenchmark/Source.prefab";
+
+// the prefab instantiated by the scene, fileID 4000011 is the Transform of its root
+const char* SourcePrefab = R"(%YAML 1.1
+%TAG !u! tag:unity3d.com,2011:
+--- !u!1001 &100100000
+Prefab:
+  m_ObjectHideFlags: 1
+  serializedVersion: 2
+  m_Modification:
+    m_TransformParent: {fileID: 0}
+    m_Modifications: []
+    m_RemovedComponents: []
+  m_ParentPrefab: {fileID: 0}
+  m_RootGameObject: {fileID: 1000011}
+  m_IsPrefabParent: 1
+--- !u!1 &1000011
+GameObject:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  serializedVersion: 5
+  m_Component:
+  - component: {fileID: 4000011}
+  m_Layer: 0
+  m_Name: SourceRoot
+  m_IsActive: 1
+--- !u!4 &4000011
+Transform:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  m_GameObject: {fileID: 1000011}
+  m_LocalRotation: {x: 0, y: 0, z: 0, w: 1}
+  m_LocalPosition: {x: 0, y: 0, z: 0}
+  m_LocalScale: {x: 1, y: 1, z: 1}
+  m_Children:
+  - {fileID: 4000013}
+  m_Father: {fileID: 0}
+  m_RootOrder: 0
+--- !u!1 &1000013
+GameObject:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  serializedVersion: 5
+  m_Component:
+  - component: {fileID: 4000013}
+  m_Layer: 0
+  m_Name: SourceChild
+  m_IsActive: 1
+--- !u!4 &4000013
+Transform:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  m_GameObject: {fileID: 1000013}
+  m_LocalRotation: {x: 0, y: 0, z: 0, w: 1}
+  m_LocalPosition: {x: 0, y: 5, z: 0}
+  m_LocalScale: {x: 1, y: 1, z: 1}
+  m_Children: []
+  m_Father: {fileID: 4000011}
+  m_RootOrder: 0
+)";
+
+// the importer of SourcePrefab, loaded from the string above instead of a project file
+class SourcePrefabImporter : public NativeFormatImporter
+{
+public:
+	virtual void Import() override
+	{
+		YAMLInputArchive archive;
+		archive.LoadAllFromString(SourcePrefab);
+		m_FileIDToObject = archive.GetFileIDToObject();
+		auto prefab = m_FileIDToObject[100100000]->As<Prefab>();
+		for (auto&& p : m_FileIDToObject)
+			prefab->AddObject(p.first, p.second);
+		m_MainAsset = prefab;
+		m_Imported = true;
+	}
+};
+
+// gameObjectCount GameObjects with a Transform, in chains of 10 under gameObjectCount/10 roots.
+// Each chain is written leaf first and every Transform before its GameObject, so most references
+// are to objects not read yet. Every 10th chain is followed by an instance of SourcePrefab, its
+// stripped Transform first.
+std::string GenerateScene(int gameObjectCount)
+{
+	std::ostringstream s;
+	s << "%YAML 1.1\n%TAG !u! tag:unity3d.com,2011:\n";
+	for (int first = 0; first < gameObjectCount; first += 10)
+	{
+		const int last = std::min(first + 10, gameObjectCount) - 1;
+		for (int i = last; i >= first; --i)
+		{
+			const int64_t gameObject = 1000000 + i;
+			const int64_t transform = 2000000 + i;
+			const bool root = i == first;
+			const bool leaf = i == last;
+			s << "--- !u!4 &" << transform << "\n"
+				<< "Transform:\n"
+				<< "  m_ObjectHideFlags: 0\n"
+				<< "  m_PrefabParentObject: {fileID: 0}\n"
+				<< "  m_PrefabInternal: {fileID: 0}\n"
+				<< "  m_GameObject: {fileID: " << gameObject << "}\n"
+				<< "  m_LocalRotation: {x: 0, y: 0, z: 0, w: 1}\n"
+				<< "  m_LocalPosition: {x: " << i << ", y: " << i % 7 << ", z: -" << i % 13 << "}\n"
+				<< "  m_LocalScale: {x: 1, y: " << 1 + i % 3 << ", z: 1}\n"
+				<< "  m_Children:" << (leaf ? " []\n" : "\n");
+			if (!leaf)
+				s << "  - {fileID: " << transform + 1 << "}\n";
+			s << "  m_Father: {fileID: " << (root ? 0 : transform - 1) << "}\n"
+				<< "  m_RootOrder: 0\n";
+			s << "--- !u!1 &" << gameObject << "\n"
+				<< "GameObject:\n"
+				<< "  m_ObjectHideFlags: 0\n"
+				<< "  m_PrefabParentObject: {fileID: 0}\n"
+				<< "  m_PrefabInternal: {fileID: 0}\n"
+				<< "  serializedVersion: 5\n"
+				<< "  m_Component:\n"
+				<< "  - component: {fileID: " << transform << "}\n"
+				<< "  m_Layer: 0\n"
+				<< "  m_Name: GameObject" << i << "\n"
+				<< "  m_TagString: Untagged\n"
+				<< "  m_IsActive: " << (i % 5 == 0 ? 0 : 1) << "\n";
+		}
+		if (first % 100 != 0)
+			continue;
+		const int64_t prefab = 3000000 + first;
+		s << "--- !u!4 &" << prefab + 1 << " stripped\n"
+			<< "Transform:\n"
+			<< "  m_PrefabParentObject: {fileID: 4000011, guid: " << SourcePrefabGUID << ", type: 2}\n"
+			<< "  m_PrefabInternal: {fileID: " << prefab << "}\n";
+		s << "--- !u!1001 &" << prefab << "\n"
+			<< "Prefab:\n"
+			<< "  m_ObjectHideFlags: 0\n"
+			<< "  serializedVersion: 2\n"
+			<< "  m_Modification:\n"
+			<< "    m_TransformParent: {fileID: 0}\n"
+			<< "    m_Modifications:\n"
+			<< "    - target: {fileID: 4000011, guid: " << SourcePrefabGUID << ", type: 2}\n"
+			<< "      propertyPath: m_LocalPosition.x\n"
+			<< "      value: " << first << "\n"
+			<< "      objectReference: {fileID: 0}\n"
+			<< "    m_RemovedComponents: []\n"
+			<< "  m_ParentPrefab: {fileID: 100100000, guid: " << SourcePrefabGUID << ", type: 2}\n"
+			<< "  m_IsPrefabParent: 0\n";
+	}
+	return s.str();
+}
+
+// loaded by two loaders from the same file: same class, serialized fields and links
+bool SameObject(Object* a, Object* b)
+{
+	if (a->GetClassID() != b->GetClassID() || a->GetLocalIdentifierInFile() != b->GetLocalIdentifierInFile() || a->GetName() != b->GetName())
+		return false;
+	if (a->GetClassID() == GameObject::ClassID)
+	{
+		auto ga = a->As<GameObject>();
+		auto gb = b->As<GameObject>();
+		if (ga->IsActive() != gb->IsActive() || ga->GetAllComponents().size() != gb->GetAllComponents().size())
+			return false;
+		auto tb = gb->GetTransform();
+		if (tb == nullptr || tb->GetGameObject() != gb || tb->GetLocalIdentifierInFile() != ga->GetTransform()->GetLocalIdentifierInFile())
+			return false;
+	}
+	else if (a->GetClassID() == Transform::ClassID)
+	{
+		auto ta = a->As<Transform>();
+		auto tb = b->As<Transform>();
+		if (ta->GetLocalPosition() != tb->GetLocalPosition() || ta->GetLocalRotation() != tb->GetLocalRotation() || ta->GetLocalScale() != tb->GetLocalScale())
+			return false;
+		if (ta->GetGameObject()->GetName() != tb->GetGameObject()->GetName())
+			return false;
+		auto pa = ta->GetParent();
+		auto pb = tb->GetParent();
+		if ((pa == nullptr) != (pb == nullptr) || (pa != nullptr && pa->GetLocalIdentifierInFile() != pb->GetLocalIdentifierInFile()))
+			return false;
+		if (ta->GetChildren().size() != tb->GetChildren().size())
+			return false;
+		for (size_t i = 0; i < ta->GetChildren().size(); ++i)
+		{
+			auto ca = ta->GetChildren()[i];
+			auto cb = tb->GetChildren()[i];
+			if (cb->GetParent() != tb || ca->GetLocalPosition() != cb->GetLocalPosition() || ca->GetGameObject()->GetName() != cb->GetGameObject()->GetName())
+				return false;
+		}
+	}
+	return true;
+}
+
+// the links written by GenerateScene
+bool CheckScene(const std::map<int64_t, Object*>& fileIDToObject, int gameObjectCount)
+{
+	if (fileIDToObject.size() != static_cast<size_t>(gameObjectCount * 2 + (gameObjectCount + 99) / 100 * 2))
+		return false;
+	for (int i = 0; i < gameObjectCount; ++i)
+	{
+		auto t = fileIDToObject.at(2000000 + i)->As<Transform>();
+		auto parent = t->GetParent();
+		if (t->GetGameObject() != fileIDToObject.at(1000000 + i) || t->GetLocalPosition().x != i)
+			return false;
+		if (i % 10 == 0 ? parent != nullptr : parent != fileIDToObject.at(2000000 + i - 1))
+			return false;
+	}
+	for (int first = 0; first < gameObjectCount; first += 100)
+	{
+		auto t = fileIDToObject.at(3000000 + first + 1)->As<Transform>();
+		if (t->GetGameObject() != fileIDToObject.at(3000000 + first) || t->GetLocalPosition().x != first || t->GetChildren().size() != 1)
+			return false;
+	}
+	return true;
+}
+
+// every fileID of a maps to the same object in b
+bool SameObjects(const std::map<int64_t, Object*>& a, const std::map<int64_t, Object*>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (auto&& p : a)
+	{
+		auto it = b.find(p.first);
+		if (it == b.end() || (p.second == nullptr) != (it->second == nullptr))
+			return false;
+		if (p.second != nullptr && !SameObject(p.second, it->second))
+			return false;
+	}
+	return true;
+}
+
+int main()
+{
+	constexpr int gameObjectCount = 50000;	// 100k objects
+	auto scene = SceneManager::CreateScene("SceneLoadBenchmark");
+	SceneManager::SetActiveScene(scene);
+
+	auto sourceImporter = new SourcePrefabImporter();
+	sourceImporter->SetGUID(SourcePrefabGUID);
+	AssetImporter::AddImporter(sourceImporter, SourcePrefabGUID);
+	AssetDatabase::AddAssetPathAndGUIDPair(SourcePrefabPath, SourcePrefabGUID);
+
+	auto str = GenerateScene(gameObjectCount);
+	printf("scene: %d objects, %d prefab instances, %.1f MB\n", gameObjectCount * 2, (gameObjectCount + 99) / 100, str.size() / (1024.0 * 1024.0));
+
+	std::map<int64_t, Object*> reference;
+	const int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		auto& js = JobSystem::GetInstance();
+		js.Init(threads);
+		YAMLInputArchive archive;
+		auto start = std::chrono::high_resolution_clock::now();
+		archive.LoadAllFromString(str);
+		auto end = std::chrono::high_resolution_clock::now();
+		js.Clean();
+
+		if (reference.empty())
+		{
+			reference = archive.GetFileIDToObject();
+			if (!CheckScene(reference, gameObjectCount))
+			{
+				puts("FAILED: LoadAllFromString did not build the links of the scene");
+				return 1;
+			}
+		}
+		else if (!SameObjects(reference, archive.GetFileIDToObject()))
+		{
+			printf("FAILED: %d threads loaded different objects\n", threads);
+			return 1;
+		}
+		auto& times = archive.GetLoadTimes();
+		printf("LoadAllFromString %2d threads: %.1f ms(parse %.1f ms, deserialize %.1f ms)\n", threads,
+			std::chrono::duration<double, std::milli>(end - start).count(), times.parse, times.deserialize);
+	}
+
+	{
+		std::istringstream is(str);
+		YAMLInputArchive archive;
+		auto start = std::chrono::high_resolution_clock::now();
+		archive.LoadAllFromStream(is);
+		auto end = std::chrono::high_resolution_clock::now();
+		if (!SameObjects(reference, archive.GetFileIDToObject()))
+		{
+			puts("FAILED: LoadAllFromStream loaded different objects");
+			return 1;
+		}
+		auto& times = archive.GetLoadTimes();
+		printf("LoadAllFromStream: %.1f ms(parse %.1f ms, deserialize %.1f ms)\n",
+			std::chrono::duration<double, std::milli>(end - start).count(), times.parse, times.deserialize);
+	}
+	return 0;
+}
@@ -0,0 +1,216 @@
+#include <FishEngine/Render/Skinning.hpp>
+#include <FishEngine/Internal/SIMD.hpp>
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace FishEngine;
+
+typedef void (*SkinFunction)(const SkinningData&, int, int);
+
+struct SkinnedMesh
+{
+	std::vector<Matrix4x4>	palette;
+	std::vector<Matrix3x4>	palette3x4;
+	std::vector<DualQuaternion>	dualQuaternions;
+	std::vector<BoneWeight>	boneWeights;
+	std::vector<Vector3>	positions;
+	std::vector<Vector3>	normals;
+	std::vector<Vector3>	skinnedPositions;
+	std::vector<Vector3>	skinnedNormals;
+
+	SkinningData Data()
+	{
+		return { palette3x4.data(), boneWeights.data(), positions.data(), normals.data(), skinnedPositions.data(), skinnedNormals.data(), dualQuaternions.data() };
+	}
+};
+
+SkinnedMesh CreateMesh(int vertexCount, int boneCount)
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> value(-1.f, 1.f);
+	SkinnedMesh mesh;
+	for (int i = 0; i < boneCount; ++i)
+	{
+		auto rotation = Quaternion::Euler(value(rng) * 180, value(rng) * 180, value(rng) * 180);
+		mesh.palette.push_back(Matrix4x4::TRS(Vector3(value(rng), value(rng), value(rng)), rotation, Vector3::one));
+		mesh.palette3x4.push_back(Matrix3x4(mesh.palette.back()));
+		mesh.dualQuaternions.push_back(DualQuaternion(mesh.palette.back()));
+	}
+	mesh.boneWeights.resize(vertexCount);
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		// 1 to 4 influences, like a real mesh
+		auto& bw = mesh.boneWeights[i];
+		int influences = 1 + rng() % 4;
+		float sum = 0;
+		for (int b = 0; b < influences; ++b)
+		{
+			bw.boneIndex[b] = rng() % boneCount;
+			bw.weight[b] = 0.1f + (value(rng) + 1);
+			sum += bw.weight[b];
+		}
+		for (int b = 0; b < influences; ++b)
+			bw.weight[b] /= sum;
+		mesh.positions.emplace_back(value(rng), value(rng), value(rng));
+		mesh.normals.push_back(Vector3(value(rng), value(rng), value(rng)).normalized());
+	}
+	mesh.skinnedPositions.resize(vertexCount);
+	mesh.skinnedNormals.resize(vertexCount);
+	return mesh;
+}
+
+// the previous implementation of SkinnedMeshRenderer: blend full Matrix4x4s
+void SkinReference(const SkinnedMesh& mesh, std::vector<Vector3>& positions, std::vector<Vector3>& normals)
+{
+	for (size_t i = 0; i < mesh.positions.size(); ++i)
+	{
+		auto& bw = mesh.boneWeights[i];
+		Matrix4x4 m = mesh.palette[bw.boneIndex[0]] * bw.weight[0];
+		for (int b = 1; b < 4; ++b)
+			m += mesh.palette[bw.boneIndex[b]] * bw.weight[b];
+		positions[i] = m.MultiplyPoint3x4(mesh.positions[i]);
+		normals[i] = m.MultiplyVector(mesh.normals[i]);
+	}
+}
+
+bool Matches(const SkinnedMesh& mesh, const std::vector<Vector3>& positions, const std::vector<Vector3>& normals)
+{
+	for (size_t i = 0; i < mesh.positions.size(); ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			if (std::fabs(positions[i][k] - mesh.skinnedPositions[i][k]) > 1e-4f || std::fabs(normals[i][k] - mesh.skinnedNormals[i][k]) > 1e-4f)
+				return false;
+		}
+	}
+	return true;
+}
+
+bool MatchesReference(const SkinnedMesh& mesh)
+{
+	std::vector<Vector3> positions(mesh.positions.size()), normals(mesh.positions.size());
+	SkinReference(mesh, positions, normals);
+	return Matches(mesh, positions, normals);
+}
+
+// a vertex bound to one rigid bone must land exactly where its matrix puts it,
+// and every dual quaternion kernel must agree with the scalar one
+bool CheckDualQuaternionKernels(SkinnedMesh mesh)
+{
+	const int vertexCount = static_cast<int>(mesh.positions.size());
+	std::vector<SkinFunction> kernels = { Skinning::SkinVerticesDQ_Scalar, Skinning::SkinVerticesDQ_SSE };
+	if (CPU::HasAVX())
+		kernels.push_back(Skinning::SkinVerticesDQ_AVX);
+
+	auto rigid = mesh;
+	for (auto& bw : rigid.boneWeights)
+	{
+		for (int b = 1; b < 4; ++b)
+			bw.weight[b] = 0;
+		bw.weight[0] = 1;
+	}
+	for (auto kernel : kernels)
+	{
+		kernel(rigid.Data(), 0, vertexCount);
+		if (!MatchesReference(rigid))
+			return false;
+	}
+
+	Skinning::SkinVerticesDQ_Scalar(mesh.Data(), 0, vertexCount);
+	auto positions = mesh.skinnedPositions;
+	auto normals = mesh.skinnedNormals;
+	for (auto kernel : kernels)
+	{
+		std::fill(mesh.skinnedPositions.begin(), mesh.skinnedPositions.end(), Vector3::zero);
+		kernel(mesh.Data(), 0, vertexCount);
+		if (!Matches(mesh, positions, normals))
+			return false;
+	}
+	return true;
+}
+
+double Benchmark(SkinFunction func, SkinnedMesh& mesh, int iterations)
+{
+	auto data = mesh.Data();
+	const int vertexCount = static_cast<int>(mesh.positions.size());
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		func(data, 0, vertexCount);
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+double BenchmarkParallel(int threadCount, SkinnedMesh& mesh, int iterations, SkinningMethod method)
+{
+	auto& js = JobSystem::GetInstance();
+	js.Init(threadCount);
+	auto data = mesh.Data();
+	const int vertexCount = static_cast<int>(mesh.positions.size());
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		Skinning::SkinVerticesParallel(data, vertexCount, method);
+	auto end = std::chrono::high_resolution_clock::now();
+	js.Clean();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int main()
+{
+	constexpr int vertexCount = 60000;
+	constexpr int boneCount = 60;
+	constexpr int iterations = 100;
+	auto mesh = CreateMesh(vertexCount, boneCount);
+
+	// the AVX kernels only when the CPU runs them
+	const int kernelCount = CPU::HasAVX() ? 3 : 2;
+	SkinFunction kernels[] = { Skinning::SkinVertices_Scalar, Skinning::SkinVertices_SSE, Skinning::SkinVertices_AVX };
+	const char* names[] = { "scalar   ", "SSE      ", "AVX      " };
+	for (int i = 0; i < kernelCount; ++i)
+	{
+		std::fill(mesh.skinnedPositions.begin(), mesh.skinnedPositions.end(), Vector3::zero);
+		kernels[i](mesh.Data(), 0, vertexCount);
+		if (!MatchesReference(mesh))
+		{
+			puts("FAILED: skinning kernel result differs from the Matrix4x4 reference");
+			return 1;
+		}
+	}
+
+	if (!CheckDualQuaternionKernels(mesh))
+	{
+		puts("FAILED: dual quaternion skinning kernels disagree");
+		return 1;
+	}
+
+	printf("vertices: %d, bones: %d\n", vertexCount, boneCount);
+	printf("kernel: %s\n", Skinning::KernelName());
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		SkinReference(mesh, mesh.skinnedPositions, mesh.skinnedNormals);
+	auto end = std::chrono::high_resolution_clock::now();
+	printf("Matrix4x4: %.3f ms/frame\n", std::chrono::duration<double, std::milli>(end - start).count() / iterations);
+	for (int i = 0; i < kernelCount; ++i)
+		printf("%s: %.3f ms/frame\n", names[i], Benchmark(kernels[i], mesh, iterations));
+
+	SkinFunction kernelsDQ[] = { Skinning::SkinVerticesDQ_Scalar, Skinning::SkinVerticesDQ_SSE, Skinning::SkinVerticesDQ_AVX };
+	for (int i = 0; i < kernelCount; ++i)
+		printf("DQ %s: %.3f ms/frame\n", names[i], Benchmark(kernelsDQ[i], mesh, iterations));
+	if (!CPU::HasAVX())
+		puts("AVX: not supported");
+
+	const int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	for (auto method : { SkinningMethod::LinearBlend, SkinningMethod::DualQuaternion })
+	{
+		const char* name = method == SkinningMethod::LinearBlend ? "LBS" : "DQ ";
+		for (int threads = 1; threads <= maxThreads; threads *= 2)
+			printf("%s %2d threads: %.3f ms/frame\n", name, threads, BenchmarkParallel(threads, mesh, iterations, method));
+	}
+	return 0;
+}
@@ -0,0 +1,496 @@
+#include <FishEngine/Animation/AnimationCurve.hpp>
+#include <FishEngine/Animation/AnimationClip.hpp>
+#include <FishEngine/Animation/Avatar.hpp>
+#include <FishEngine/Animation/SampledAnimationClip.hpp>
+#include <FishEngine/Animation/CompressedAnimationClip.hpp>
+#include <FishEngine/Animation/AnimationPose.hpp>
+#include <FishEngine/Internal/SIMD.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace FishEngine;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); exit(1); } } while (0)
+
+TAnimationCurve<float> RandomCurve(std::mt19937& rng, int keyCount)
+{
+	std::vector<TKeyframe<float>> keys;
+	float time = (rng() % 3) * 0.3f;
+	for (int i = 0; i < keyCount; ++i)
+	{
+		keys.push_back({time, static_cast<float>(rng() % 100), 0, 0});
+		time += 0.05f + (rng() % 10) * 0.1f;
+	}
+	return TAnimationCurve<float>(keys);
+}
+
+// the cursor must never change the result, whatever the time sequence
+void TestCursorMatchesSearch()
+{
+	std::mt19937 rng(42);
+	for (int trial = 0; trial < 200; ++trial)
+	{
+		auto curve = RandomCurve(rng, 1 + rng() % 20);
+		bool loop = (trial % 2) == 0;
+		AnimationCurveCursor cursor;
+		float time = 0;
+		for (int i = 0; i < 2000; ++i)
+		{
+			if (rng() % 10 == 0)
+				time = (rng() % 1000) * 0.01f - 1.0f;	// jump, also before the first key
+			else
+				time += (rng() % 5) * 0.0167f;			// playback
+			CHECK(curve.Evaluate(time, loop) == curve.Evaluate(time, cursor, loop));
+		}
+	}
+}
+
+void TestCursorAdvances()
+{
+	std::vector<TKeyframe<float>> keys;
+	for (int i = 0; i < 4; ++i)
+		keys.push_back({static_cast<float>(i), static_cast<float>(i * 10), 0, 0});
+	TAnimationCurve<float> curve(keys);
+
+	AnimationCurveCursor cursor;
+	CHECK(curve.Evaluate(0.5f, cursor, false) == 5.0f);
+	CHECK(cursor.leftKey == 0 && cursor.rightKey == 1);
+	CHECK(curve.Evaluate(1.5f, cursor, false) == 15.0f);
+	CHECK(cursor.leftKey == 1 && cursor.rightKey == 2);
+	CHECK(curve.Evaluate(0.25f, cursor, false) == 2.5f);	// backwards jump
+	CHECK(cursor.leftKey == 0 && cursor.rightKey == 1);
+}
+
+// keys on the sample grid: the sampled clip must reproduce the position curves at any time,
+// and the rotations(baked to quaternions) on every frame
+void TestSampledClipMatchesCurves()
+{
+	std::mt19937 rng(7);
+	AnimationClip clip;
+	clip.frameRate = 30;
+	for (int c = 0; c < 5; ++c)
+	{
+		std::vector<TKeyframe<Vector3>> keys;
+		for (int f = 0; f <= 60; f += 1 + rng() % 4)
+		{
+			Vector3 v(rng() % 100 * 0.1f, rng() % 100 * 0.1f, rng() % 100 * 0.1f);
+			keys.push_back({f / 30.0f, v, Vector3(0, 0, 0), Vector3(0, 0, 0)});
+		}
+		keys.back().time = 2.0f;	// all curves share the clip length
+		clip.m_positionCurve.push_back({"p", TAnimationCurve<Vector3>(keys)});
+		clip.m_eulersCurves.push_back({"r", TAnimationCurve<Vector3>(keys)});
+	}
+	clip.m_scaleCurves.push_back(clip.m_positionCurve[0]);
+
+	clip.BuildSampledClip();
+	auto& sampled = clip.m_sampledClip;
+	CHECK(sampled.IsValid());
+	CHECK(sampled.GetChannelCount() == 38);
+	CHECK(sampled.GetStride() == 40);
+	CHECK(sampled.GetRotationCount() == 5);
+	CHECK(sampled.GetFrameCount() == 61);
+
+	std::vector<float> pose(sampled.GetStride());
+	auto Near = [](float a, float b) { return std::fabs(a - b) < 1e-4f; };
+	for (int i = 0; i < 1000; ++i)
+	{
+		float time = (rng() % 5000) * 0.001f;
+		if (i % 2 == 0)
+			time = (rng() % 150) / 30.0f;
+		sampled.Sample(time, true, pose.data());
+		for (size_t c = 0; c < clip.m_positionCurve.size(); ++c)
+		{
+			auto p = clip.m_positionCurve[c].curve.Evaluate(time, true);
+			const float* sp = pose.data() + sampled.GetPositionOffset() + 3*c;
+			CHECK(Near(sp[0], p.x) && Near(sp[1], p.y) && Near(sp[2], p.z));
+			if (i % 2 != 0)
+				continue;
+			auto r = Quaternion::Euler(RotationOrder::XYZ, clip.m_eulersCurves[c].curve.Evaluate(time, true));
+			const float* sr = pose.data() + sampled.GetRotationOffset() + 4*c;
+			Quaternion q(sr[0], sr[1], sr[2], sr[3]);
+			CHECK(std::fabs(Quaternion::Dot(q, r)) > 1 - 1e-5f);
+		}
+	}
+}
+
+// rotation keys with flipping signs are baked on one hemisphere, so lerping frames takes the short path
+void TestSampledRotationsHemisphere()
+{
+	AnimationClip clip;
+	clip.frameRate = 30;
+	std::vector<TKeyframe<Quaternion>> keys;
+	Quaternion zero(0, 0, 0, 0);
+	for (int f = 0; f <= 30; ++f)
+	{
+		auto q = Quaternion::Euler(RotationOrder::XYZ, Vector3(0, f * 10.0f, 0));
+		keys.push_back({f / 30.0f, f % 2 == 0 ? q : -q, zero, zero});
+	}
+	clip.m_rotationCurves.push_back({"r", TAnimationCurve<Quaternion>(keys)});
+	clip.BuildSampledClip();
+	auto& sampled = clip.m_sampledClip;
+	CHECK(sampled.GetRotationCount() == 1);
+	for (int f = 1; f < sampled.GetFrameCount(); ++f)
+	{
+		const float* a = sampled.GetFrame(f - 1) + sampled.GetRotationOffset();
+		const float* b = sampled.GetFrame(f) + sampled.GetRotationOffset();
+		CHECK(a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3] > 0);
+	}
+	// halfway between 50 and 60 degrees
+	std::vector<float> pose(sampled.GetStride());
+	sampled.Sample(5.5f / 30.0f, false, pose.data());
+	const float* r = pose.data() + sampled.GetRotationOffset();
+	Quaternion q(r[0], r[1], r[2], r[3]);
+	CHECK(std::fabs(Quaternion::Dot(q, Quaternion::Euler(RotationOrder::XYZ, Vector3(0, 55, 0)))) > 1 - 1e-5f);
+}
+
+// FBX import fills both an euler and a quaternion curve per bone: only the quaternion one is baked,
+// an euler curve without a quaternion curve on its path still is
+void TestSampledClipEulersAndQuaternions()
+{
+	AnimationClip clip;
+	clip.frameRate = 30;
+	const Vector3 zero(0, 0, 0);
+	const Quaternion qzero(0, 0, 0, 0);
+	auto qa = Quaternion::Euler(RotationOrder::XYZ, Vector3(0, 40, 0));
+	clip.m_eulersCurves.push_back({"a", TAnimationCurve<Vector3>({{0, Vector3(90, 0, 0), zero, zero}, {1, Vector3(90, 0, 0), zero, zero}})});
+	clip.m_eulersCurves.push_back({"b", TAnimationCurve<Vector3>({{0, Vector3(0, 0, 20), zero, zero}, {1, Vector3(0, 0, 20), zero, zero}})});
+	clip.m_rotationCurves.push_back({"a", TAnimationCurve<Quaternion>({{0, qa, qzero, qzero}, {1, qa, qzero, qzero}})});
+
+	auto eulers = clip.GetEulersRotationSources();
+	CHECK(eulers.size() == 1 && eulers[0]->path == "b");
+	clip.BuildSampledClip();
+	auto& sampled = clip.m_sampledClip;
+	CHECK(sampled.GetRotationCount() == 2);
+
+	// rotations: the euler sources, then the quaternion curves
+	std::vector<float> pose(sampled.GetStride());
+	sampled.Sample(0.5f, false, pose.data());
+	const float* r = pose.data() + sampled.GetRotationOffset();
+	Quaternion b(r[0], r[1], r[2], r[3]);
+	Quaternion a(r[4], r[5], r[6], r[7]);
+	CHECK(std::fabs(Quaternion::Dot(b, Quaternion::Euler(RotationOrder::XYZ, Vector3(0, 0, 20)))) > 1 - 1e-5f);
+	CHECK(std::fabs(Quaternion::Dot(a, qa)) > 1 - 1e-5f);
+}
+
+// a length that is not a whole number of frames: the grid is stretched so the last frame lands on the
+// length and every interval stays uniform; a linear curve then resamples without error
+void TestSampledClipGrid()
+{
+	AnimationClip clip;
+	clip.frameRate = 30;
+	std::vector<TKeyframe<Vector3>> keys;
+	Vector3 slope(3, -2, 1);
+	keys.push_back({0, Vector3(0, 0, 0), slope, slope});
+	keys.push_back({1.05f, slope * 1.05f, slope, slope});
+	clip.m_positionCurve.push_back({"p", TAnimationCurve<Vector3>(keys)});
+
+	auto report = clip.BuildSampledClip();
+	auto& sampled = clip.m_sampledClip;
+	CHECK(sampled.GetFrameCount() == 33);	// 31.5 frames rounded up to 32 intervals
+	CHECK(std::fabs((sampled.GetFrameCount() - 1) / sampled.GetSampleRate() - 1.05f) < 1e-5f);
+	CHECK(report.maxPositionError < 1e-4f);
+
+	std::vector<float> pose(sampled.GetStride());
+	for (int i = 0; i <= 100; ++i)
+	{
+		float time = 1.05f * i / 100;
+		sampled.Sample(time, false, pose.data());
+		auto p = slope * time;
+		CHECK(std::fabs(pose[0] - p.x) < 1e-4f && std::fabs(pose[1] - p.y) < 1e-4f && std::fabs(pose[2] - p.z) < 1e-4f);
+	}
+
+	// a key between two frames is cut off by the lerp and reported, a finer grid hits it
+	keys.insert(keys.begin() + 1, {0.05f, Vector3(1, 0, 0), slope, slope});
+	clip.m_positionCurve[0].curve = TAnimationCurve<Vector3>(keys);
+	auto coarse = clip.BuildSampledClip(10);
+	auto fine = clip.BuildSampledClip(60);
+	CHECK(coarse.maxPositionError > 1e-3f);
+	CHECK(fine.maxPositionError < coarse.maxPositionError);
+	printf("SampledAnimationClip: resample error %g at 10 fps, %g at 60 fps\n", coarse.maxPositionError, fine.maxPositionError);
+}
+
+void TestLerpKernelsAgree()
+{
+	std::mt19937 rng(3);
+	std::vector<float> a(64), b(64), scalar(64), simd(64);
+	for (int i = 0; i < 64; ++i)
+	{
+		a[i] = (rng() % 1000) * 0.01f - 5.0f;
+		b[i] = (rng() % 1000) * 0.01f - 5.0f;
+	}
+	SampledAnimationClip::Lerp_Scalar(a.data(), b.data(), 0.3f, scalar.data(), 64);
+	SampledAnimationClip::Lerp_SSE(a.data(), b.data(), 0.3f, simd.data(), 64);
+	CHECK(scalar == simd);
+	if (CPU::HasAVX())
+	{
+		SampledAnimationClip::Lerp_AVX(a.data(), b.data(), 0.3f, simd.data(), 64);
+		CHECK(scalar == simd);
+	}
+	printf("SampledAnimationClip kernel: %s\n", SampledAnimationClip::KernelName());
+}
+
+// the measured error must stay within the settings, constant/linear tracks must collapse
+void TestCompressedClip()
+{
+	std::mt19937 rng(11);
+	AnimationClip clip;
+	clip.frameRate = 30;
+	auto Curve = [](std::vector<TKeyframe<Vector3>> keys) { return Vector3Curve{"bone", TAnimationCurve<Vector3>(keys)}; };
+	const Vector3 zero(0, 0, 0);
+	// constant, linear, noisy
+	clip.m_positionCurve.push_back(Curve({{0, Vector3(1, 2, 3), zero, zero}, {4, Vector3(1, 2, 3), zero, zero}}));
+	clip.m_positionCurve.push_back(Curve({{0, Vector3(0, 0, 0), zero, zero}, {4, Vector3(4, -8, 2), zero, zero}}));
+	std::vector<TKeyframe<Vector3>> noisy, noisyEulers;
+	for (int f = 0; f <= 120; f += 3)
+	{
+		noisy.push_back({f / 30.0f, Vector3(rng() % 100 * 0.1f, rng() % 100 * -0.1f, rng() % 100 * 0.01f), zero, zero});
+		noisyEulers.push_back({f / 30.0f, Vector3(rng() % 90 - 45.0f, rng() % 360 - 180.0f, rng() % 90 - 45.0f), zero, zero});
+	}
+	clip.m_positionCurve.push_back(Curve(noisy));
+	clip.m_eulersCurves.push_back(Curve(noisyEulers));
+	clip.m_eulersCurves.push_back(Curve({{0, Vector3(0, 0, 0), zero, zero}, {4, Vector3(0, 90, 0), zero, zero}}));
+	clip.m_scaleCurves.push_back(Curve({{0, Vector3(1, 1, 1), zero, zero}, {4, Vector3(1, 1, 1), zero, zero}}));
+	clip.BuildSampledClip();
+
+	CompressedAnimationClip::Settings settings;
+	CompressedAnimationClip compressed;
+	auto report = compressed.Compress(clip.m_sampledClip, settings);
+	CHECK(compressed.IsValid());
+	CHECK(report.trackCount == 6);
+	CHECK(report.sourceKeyCount == 6 * 121);
+	CHECK(report.keyCount < report.sourceKeyCount / 2);
+	CHECK(report.compressedBytes * 4 < report.sourceBytes);
+	CHECK(report.maxPositionError <= settings.positionError);
+	CHECK(report.maxRotationError <= settings.rotationError);
+	CHECK(report.maxScaleError <= settings.scaleError);
+	printf("CompressedAnimationClip: %d -> %d keys, %d -> %d bytes, error %g %g %g\n",
+		report.sourceKeyCount, report.keyCount, (int)report.sourceBytes, (int)report.compressedBytes,
+		report.maxPositionError, report.maxRotationError, report.maxScaleError);
+
+	// check the report independently: positions also between frames, rotations on frames
+	// (the rotation error bound is measured on frames)
+	std::vector<float> sampled(clip.m_sampledClip.GetStride());
+	std::vector<float> pose(compressed.GetPoseSize());
+	for (int i = 0; i <= 400; ++i)
+	{
+		float time = i * 0.01f;
+		clip.m_sampledClip.Sample(time, true, sampled.data());
+		compressed.Sample(time, true, pose.data());
+		const float* p = pose.data() + compressed.GetPositionOffset();
+		const float* s = sampled.data() + clip.m_sampledClip.GetPositionOffset();
+		for (int c = 0; c < 3 * compressed.GetPositionCount(); ++c)
+			CHECK(std::fabs(p[c] - s[c]) <= settings.positionError * 2);
+	}
+	for (int f = 0; f < clip.m_sampledClip.GetFrameCount(); ++f)
+	{
+		float time = f / clip.m_sampledClip.GetSampleRate();
+		clip.m_sampledClip.Sample(time, false, sampled.data());
+		compressed.Sample(time, false, pose.data());
+		for (int r = 0; r < compressed.GetRotationCount(); ++r)
+		{
+			const float* e = sampled.data() + clip.m_sampledClip.GetRotationOffset() + 4*r;
+			Quaternion expected(e[0], e[1], e[2], e[3]);
+			const float* q = pose.data() + compressed.GetRotationOffset() + 4*r;
+			float dot = std::fabs(expected.x*q[0] + expected.y*q[1] + expected.z*q[2] + expected.w*q[3]);
+			CHECK(dot >= std::cos(0.5f * settings.rotationError * Mathf::Deg2Rad) - 1e-6f);
+		}
+	}
+
+	// animation LOD: masked tracks are left untouched, the others match the full sample
+	const uint8_t mask[] = { 1, 0, 1, 0, 1, 0 };
+	CHECK(compressed.GetTrackCount() == 6);
+	std::vector<float> masked(compressed.GetPoseSize(), -100.0f);
+	compressed.Sample(1.3f, true, pose.data());
+	compressed.Sample(1.3f, true, masked.data(), mask);
+	const int trackOffsets[] = { 0, 3, 6, 9, 13, 17, 20 };
+	for (int t = 0; t < 6; ++t)
+	{
+		for (int c = trackOffsets[t]; c < trackOffsets[t + 1]; ++c)
+			CHECK(mask[t] ? masked[c] == pose[c] : masked[c] == -100.0f);
+	}
+
+	// compressing the clip keeps only the compressed form, the curves keep their paths for binding
+	CHECK(clip.HasSourceKeys());
+	auto clipReport = clip.Compress(settings);
+	CHECK(clipReport.keyCount == report.keyCount);
+	CHECK(clip.m_compressedClip.IsValid());
+	CHECK(!clip.m_sampledClip.IsValid());
+	CHECK(!clip.HasSourceKeys());
+	CHECK(clip.m_positionCurve.size() == 3 && clip.m_positionCurve[0].path == "bone");
+	clip.BuildSampledClip();	// nothing to resample from, the compressed form stays
+	CHECK(clip.m_compressedClip.IsValid());
+	clip.m_compressedClip.Sample(1.3f, true, masked.data());
+	CHECK(masked == pose);
+}
+
+// layers blend over the pose below them by weight and bone mask
+void TestPoseBlend()
+{
+	AnimationPose below, layer;
+	below.Resize(3);
+	layer.Resize(3);
+	for (int i = 0; i < 3; ++i)
+	{
+		below.positions[i] = Vector3(0, 0, 0);
+		below.rotations[i] = Quaternion::identity;
+		below.scales[i] = Vector3(1, 1, 1);
+		layer.positions[i] = Vector3(2, 4, 6);
+		layer.rotations[i] = Quaternion::Euler(RotationOrder::XYZ, Vector3(0, 90, 0));
+		layer.scales[i] = Vector3(3, 3, 3);
+	}
+	// the same rotation on the other hemisphere must not take the long way
+	layer.rotations[2] = -layer.rotations[2];
+
+	auto Near = [](float a, float b) { return std::fabs(a - b) < 1e-4f; };
+	const float mask[] = { 1, 0, 1 };
+	AnimationPose pose;
+	pose.Resize(3);
+	pose.CopyFrom(below);
+	pose.Blend(layer, 0.5f, mask);
+	CHECK(Near(pose.positions[0].x, 1) && Near(pose.positions[0].y, 2) && Near(pose.positions[0].z, 3));
+	CHECK(Near(pose.scales[0].x, 2));
+	CHECK(pose.positions[1] == below.positions[1] && pose.rotations[1] == below.rotations[1]);
+	auto halfway = Quaternion::Euler(RotationOrder::XYZ, Vector3(0, 45, 0));
+	for (int i : { 0, 2 })
+		CHECK(std::fabs(Quaternion::Dot(pose.rotations[i], halfway)) > 0.9999f);
+
+	pose.CopyFrom(below);
+	pose.Blend(layer, 1.0f, nullptr);
+	CHECK(pose.positions[1] == layer.positions[1] && pose.scales[1] == layer.scales[1]);
+	pose.Blend(below, 0.0f, nullptr);
+	CHECK(pose.positions[1] == layer.positions[1]);
+}
+
+// a cooked clip is sampled from the mapped file and must match the clip it was cooked from
+void TestCookedClip()
+{
+	AnimationClip clip;
+	clip.frameRate = 30;
+	const Vector3 zero(0, 0, 0);
+	clip.m_positionCurve.push_back(Vector3Curve{"bone", TAnimationCurve<Vector3>({{0, Vector3(0, 0, 0), zero, zero}, {2, Vector3(4, -8, 2), zero, zero}})});
+	clip.m_eulersCurves.push_back(Vector3Curve{"bone", TAnimationCurve<Vector3>({{0, Vector3(0, 0, 0), zero, zero}, {2, Vector3(0, 90, 30), zero, zero}})});
+	clip.m_scaleCurves.push_back(Vector3Curve{"bone", TAnimationCurve<Vector3>({{0, Vector3(1, 1, 1), zero, zero}, {2, Vector3(2, 1, 1), zero, zero}})});
+	clip.BuildSampledClip();
+	CompressedAnimationClip compressed;
+	compressed.Compress(clip.m_sampledClip, CompressedAnimationClip::Settings());
+
+	const std::string path = "TestAnimationCurve_cooked.bin";
+	{
+		CookedFileWriter writer(CookedFileType::AnimationClip);
+		clip.m_sampledClip.Cook(writer);
+		compressed.Cook(writer);
+		CHECK(writer.Write(path));
+	}
+	CHECK(CookedFile::Open(path, CookedFileType::Mesh) == nullptr);
+	auto file = CookedFile::Open(path, CookedFileType::AnimationClip);
+	CHECK(file != nullptr);
+
+	SampledAnimationClip cookedSampled;
+	CompressedAnimationClip cookedCompressed;
+	CHECK(cookedSampled.LoadCooked(file));
+	CHECK(cookedCompressed.LoadCooked(file));
+	file.reset();	// the clips keep the mapping
+	CHECK(cookedSampled.GetStride() == clip.m_sampledClip.GetStride());
+	CHECK(cookedCompressed.GetMemorySize() == compressed.GetMemorySize());
+
+	std::vector<float> a(clip.m_sampledClip.GetStride()), b(a.size());
+	std::vector<float> c(compressed.GetPoseSize()), d(c.size());
+	for (int i = 0; i <= 50; ++i)
+	{
+		float time = i * 0.043f;
+		clip.m_sampledClip.Sample(time, true, a.data());
+		cookedSampled.Sample(time, true, b.data());
+		CHECK(a == b);
+		compressed.Sample(time, true, c.data());
+		cookedCompressed.Sample(time, true, d.data());
+		CHECK(c == d);
+	}
+	cookedSampled.Clear();
+	cookedCompressed.Clear();
+	std::remove(path.c_str());
+}
+
+// a clip loaded from its cooked file keeps its name, paths and avatar
+void TestCookedAnimationClip()
+{
+	auto avatar = new Avatar;
+	avatar->SetLocalIdentifierInFile(9000000);
+	AnimationClip clip;
+	clip.SetName("Take 001");
+	clip.frameRate = 30;
+	clip.length = 2;
+	clip.m_avatar = avatar;
+	const Vector3 zero(0, 0, 0);
+	clip.m_positionCurve.push_back(Vector3Curve{"root/bone", TAnimationCurve<Vector3>({{0, Vector3(0, 0, 0), zero, zero}, {2, Vector3(4, -8, 2), zero, zero}})});
+	clip.m_eulersCurves.push_back(Vector3Curve{"root", TAnimationCurve<Vector3>({{0, Vector3(0, 0, 0), zero, zero}, {2, Vector3(0, 90, 30), zero, zero}})});
+
+	const std::string path = "TestAnimationCurve_clip.bin";
+	CHECK(clip.SaveCooked(path));
+	CHECK(AnimationClip::FromCookedFile(path) == nullptr);	// the avatar is missing
+
+	std::map<int64_t, Object*> fileIDToObject{ {9000000, avatar} };
+	auto cooked = AnimationClip::FromCookedFile(path, fileIDToObject);
+	CHECK(cooked != nullptr);
+	CHECK(cooked->GetName() == "Take 001");
+	CHECK(cooked->m_avatar == avatar);
+	CHECK(cooked->length == 2 && cooked->frameRate == 30);
+	CHECK(cooked->m_positionCurve.size() == 1 && cooked->m_positionCurve[0].path == "root/bone");
+	CHECK(cooked->m_eulersCurves.size() == 1 && cooked->m_eulersCurves[0].path == "root");
+	CHECK(cooked->m_sampledClip.GetStride() == clip.m_sampledClip.GetStride());
+	cooked->m_sampledClip.Clear();
+
+	// an avatar without a fileID can not be found again
+	avatar->SetLocalIdentifierInFile(0);
+	CHECK(!clip.SaveCooked(path));
+	std::remove(path.c_str());
+}
+
+// a cooked compressed clip whose tracks point outside its key sections is refused
+void TestCookedClipBadTracks()
+{
+	// the layout of CompressedAnimationClip::Cook
+	struct Info { float sampleRate, length; int32_t positionCount, rotationCount, scaleCount; };
+	struct Track { uint32_t firstKey, keyCount, range; };
+	const std::string path = "TestAnimationCurve_badtracks.bin";
+	auto cook = [&path](Track track) {
+		CookedFileWriter writer(CookedFileType::AnimationClip);
+		writer.AddValue(CookedFourCC('C', 'I', 'N', 'F'), Info{30, 1, 1, 0, 0});
+		writer.AddSection(CookedFourCC('C', 'T', 'R', 'K'), std::vector<Track>{track});
+		writer.AddSection(CookedFourCC('C', 'K', 'F', 'R'), std::vector<uint16_t>{0, 30});
+		writer.AddSection(CookedFourCC('C', 'K', 'V', 'L'), std::vector<uint16_t>(6, 0));
+		writer.AddSection(CookedFourCC('C', 'R', 'N', 'G'), std::vector<float>(6, 1.0f));
+		CHECK(writer.Write(path));
+		CompressedAnimationClip clip;
+		bool loaded = clip.LoadCooked(CookedFile::Open(path, CookedFileType::AnimationClip));
+		clip.Clear();
+		return loaded;
+	};
+	CHECK(cook({0, 2, 0}));
+	CHECK(!cook({1, 2, 0}));		// past the last key
+	CHECK(!cook({0, 0, 0}));		// no key
+	CHECK(!cook({0, 2, 1}));		// no such range
+	CHECK(!cook({0xffffffffu, 2, 0}));
+	std::remove(path.c_str());
+}
+
+int main()
+{
+	TestCursorMatchesSearch();
+	TestCursorAdvances();
+	TestSampledClipMatchesCurves();
+	TestSampledRotationsHemisphere();
+	TestSampledClipEulersAndQuaternions();
+	TestSampledClipGrid();
+	TestLerpKernelsAgree();
+	TestCompressedClip();
+	TestCookedClip();
+	TestCookedClipBadTracks();
+	TestCookedAnimationClip();
+	TestPoseBlend();
+	puts("TestAnimationCurve: all tests passed");
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <FishEngine/Render/InstanceBatcher.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace FishEngine;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); exit(1); } } while (0)
+
+// InstanceBatcher never dereferences mesh or material, any distinct address works as a key
+static char s_Dummy[4];
+Mesh* const meshA = reinterpret_cast<Mesh*>(&s_Dummy[0]);
+Mesh* const meshB = reinterpret_cast<Mesh*>(&s_Dummy[1]);
+Material* const matA = reinterpret_cast<Material*>(&s_Dummy[2]);
+Material* const matB = reinterpret_cast<Material*>(&s_Dummy[3]);
+
+Matrix4x4 Translate(float x)
+{
+	return Matrix4x4::TRS(Vector3(x, 0, 0), Quaternion::identity, Vector3::one);
+}
+
+void TestGrouping()
+{
+	InstanceBatcher batcher;
+	batcher.Add(meshA, matA, Translate(0), 0);
+	batcher.Add(meshB, matA, Translate(1), 1);
+	batcher.Add(meshA, matA, Translate(2), 2);
+	batcher.Add(meshA, matB, Translate(3), 3);
+	batcher.Add(meshA, matA, Translate(4), 4);
+	batcher.Build();
+
+	auto& batches = batcher.GetBatches();
+	CHECK(batches.size() == 3);
+
+	// ordered by first appearance
+	CHECK(batches[0].mesh == meshA && batches[0].material == matA);
+	CHECK(batches[0].first == 0 && batches[0].count == 3);
+	CHECK(batches[1].mesh == meshB && batches[1].count == 1);
+	CHECK(batches[2].material == matB && batches[2].first == 4);
+
+	// matrices are packed per batch and keep their relative order
+	auto& indices = batcher.GetObjectIndices();
+	auto& matrices = batcher.GetMatrices();
+	const int expected[] = { 0, 2, 4, 1, 3 };
+	for (int i = 0; i < 5; ++i)
+	{
+		CHECK(indices[i] == expected[i]);
+		CHECK(matrices[i] == Translate(static_cast<float>(expected[i])));
+	}
+}
+
+void TestNotInstanceable()
+{
+	InstanceBatcher batcher;
+	batcher.Add(meshA, matA, Translate(0), 0, false);
+	batcher.Add(meshA, matA, Translate(1), 1);
+	batcher.Add(meshA, matA, Translate(2), 2, false);
+	batcher.Add(meshA, matA, Translate(3), 3);
+	batcher.Build();
+
+	auto& batches = batcher.GetBatches();
+	CHECK(batches.size() == 3);
+	CHECK(batches[0].count == 1 && batcher.GetObjectIndices()[batches[0].first] == 0);
+	CHECK(batches[1].count == 2);
+	CHECK(batches[2].count == 1 && batcher.GetObjectIndices()[batches[2].first] == 2);
+}
+
+void TestClear()
+{
+	InstanceBatcher batcher;
+	batcher.Add(meshA, matA, Translate(0), 0);
+	batcher.Build();
+	batcher.Clear();
+	batcher.Add(meshB, matB, Translate(1), 7);
+	batcher.Build();
+	CHECK(batcher.GetBatches().size() == 1);
+	CHECK(batcher.GetBatches()[0].mesh == meshB);
+	CHECK(batcher.GetObjectIndices().size() == 1 && batcher.GetObjectIndices()[0] == 7);
+}
+
+int main()
+{
+	TestGrouping();
+	TestNotInstanceable();
+	TestClear();
+	puts("TestInstancing: all tests passed");
+	return 0;
+}
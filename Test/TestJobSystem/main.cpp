@@ -0,0 +1,179 @@
+#include <FishEngine/System/JobSystem.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace FishEngine;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); exit(1); } } while (0)
+
+void TestParallelFor()
+{
+	auto& js = JobSystem::GetInstance();
+	constexpr int count = 100000;
+	std::vector<int> hits(count, 0);
+	js.ParallelFor(0, count, 64, [&hits](int first, int last) {
+		for (int i = first; i < last; ++i)
+			hits[i]++;
+	});
+	for (int i = 0; i < count; ++i)
+		CHECK(hits[i] == 1);
+
+	// empty and single-chunk ranges
+	int calls = 0;
+	js.ParallelFor(5, 5, 1, [&calls](int, int) { calls++; });
+	CHECK(calls == 0);
+	js.ParallelFor(3, 10, 100, [&calls](int first, int last) { calls++; CHECK(first == 3 && last == 10); });
+	CHECK(calls == 1);
+}
+
+void TestNestedParallelFor()
+{
+	auto& js = JobSystem::GetInstance();
+	std::atomic<int> sum {0};
+	js.ParallelFor(0, 64, 1, [&](int first, int last) {
+		for (int i = first; i < last; ++i)
+		{
+			js.ParallelFor(0, 100, 10, [&sum](int a, int b) { sum += b - a; });
+		}
+	});
+	CHECK(sum == 64 * 100);
+}
+
+void TestChildJobs()
+{
+	auto& js = JobSystem::GetInstance();
+	std::atomic<int> done {0};
+	JobHandle root = js.CreateJob(nullptr);
+	for (int i = 0; i < 100; ++i)
+	{
+		js.Run(js.CreateChildJob(root, [&done]() { done++; }));
+	}
+	js.Run(root);
+	js.Wait(root);
+	CHECK(js.IsFinished(root));
+	CHECK(done == 100);
+}
+
+void TestDependencies()
+{
+	auto& js = JobSystem::GetInstance();
+	std::atomic<int> stage {0};
+	std::atomic<bool> ordered {true};
+
+	// a, b -> c
+	JobHandle a = js.CreateJob([&]() { stage++; });
+	JobHandle b = js.CreateJob([&]() { stage++; });
+	JobHandle c = js.CreateJob([&]() { if (stage != 2) ordered = false; stage++; });
+	js.AddDependency(a, c);
+	js.AddDependency(b, c);
+	js.Run(c);
+	CHECK(!js.IsFinished(c));	// still waiting for a and b
+	js.Run(a);
+	js.Run(b);
+	js.Wait(c);
+	CHECK(ordered);
+	CHECK(stage == 3);
+}
+
+void TestRingWrapAround()
+{
+	// more jobs than the ring holds: CreateJob must wait for the oldest slot instead of reusing it
+	auto& js = JobSystem::GetInstance();
+	constexpr int blockCount = 9;
+	constexpr int blockSize = 1000;
+	static_assert(4 * (blockSize+1) < JobSystem::MaxJobsPerThread && 9 * (blockSize+1) > 2 * JobSystem::MaxJobsPerThread, "");
+	std::atomic<int> done {0};
+	JobHandle roots[blockCount];
+	for (int b = 0; b < blockCount; ++b)
+	{
+		roots[b] = js.CreateJob(nullptr);
+		for (int i = 0; i < blockSize; ++i)
+			js.Run(js.CreateChildJob(roots[b], [&done]() { done++; }));
+		js.Run(roots[b]);
+	}
+	// older roots were recycled, so they had finished; the last 4 still own their slots
+	for (int b = blockCount - 4; b < blockCount; ++b)
+		js.Wait(roots[b]);
+	CHECK(done == blockCount * blockSize);
+}
+
+void TestForeignThreads()
+{
+	// threads not created by the JobSystem share the locked foreign pool
+	auto& js = JobSystem::GetInstance();
+	std::atomic<int> sum {0};
+	std::atomic<int> wrongIndex {0};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 3; ++t)
+	{
+		threads.emplace_back([&]() {
+			if (JobSystem::GetThreadIndex() != -1)
+				wrongIndex++;
+			for (int i = 0; i < 20; ++i)
+				js.ParallelFor(0, 1000, 10, [&sum](int first, int last) { sum += last - first; });
+		});
+	}
+	js.ParallelFor(0, 1000, 10, [&sum](int first, int last) { sum += last - first; });
+	for (auto& t : threads)
+		t.join();
+	CHECK(wrongIndex == 0);
+	CHECK(sum == 61 * 1000);
+}
+
+void TestMainThreadQueue()
+{
+	auto& js = JobSystem::GetInstance();
+	std::atomic<int> wrongThread {0};
+	int executed = 0;
+	js.ParallelFor(0, 32, 1, [&](int first, int last) {
+		for (int i = first; i < last; ++i)
+		{
+			js.RunOnMainThread([&]() {
+				if (JobSystem::GetThreadIndex() != 0)
+					wrongThread++;
+				executed++;
+			});
+		}
+	});
+	CHECK(executed == 0);
+	js.ExecuteMainThreadJobs();
+	CHECK(executed == 32);
+	CHECK(wrongThread == 0);
+}
+
+void TestWithoutWorkers()
+{
+	// before Init, ParallelFor runs inline
+	auto& js = JobSystem::GetInstance();
+	CHECK(js.GetThreadCount() == 1);
+	int calls = 0;
+	js.ParallelFor(0, 1000, 1, [&calls](int first, int last) { calls++; CHECK(first == 0 && last == 1000); });
+	CHECK(calls == 1);
+}
+
+int main()
+{
+	TestWithoutWorkers();
+
+	auto& js = JobSystem::GetInstance();
+	for (int threads : { 1, 2, 4, 8 })
+	{
+		js.Init(threads);
+		CHECK(js.GetThreadCount() == threads);
+		TestParallelFor();
+		TestNestedParallelFor();
+		TestChildJobs();
+		TestDependencies();
+		TestRingWrapAround();
+		TestForeignThreads();
+		TestMainThreadQueue();
+		js.Clean();
+	}
+	puts("TestJobSystem: all tests passed");
+	return 0;
+}
@@ -1,7 +1,10 @@
 #include <FishEditor/Serialization/YAMLArchive.hpp>
+#include <FishEditor/Serialization/BinaryArchive.hpp>
 #include <FishEditor/Serialization/NativeFormatImporter.hpp>
 #include <FishEditor/Serialization/DefaultImporter.hpp>
+#include <FishEngine/Serialization/Serialize.hpp>
 #include <FishEngine/Scene.hpp>
+#include <FishEngine/Prefab.hpp>
 
 #include <FishEditor/EditorApplication.hpp>
 #include <FishEditor/AssetDatabase.hpp>
@@ -14,8 +17,294 @@
 using namespace FishEngine;
 using namespace FishEditor;
 
+// A prefab and a scene that instantiates it. The scene references objects before their documents:
+// the child Transform comes before its GameObject and its father, the stripped Transform before its
+// prefab instance.
+const char* SourcePrefabGUID = "5e7100000000000000000000000000a1";
+const char* SourcePrefabPath = "Assets/TestSerialization/Source.prefab";
+
+const char* SourcePrefab = R"(%YAML 1.1
+%TAG !u! tag:unity3d.com,2011:
+--- !u!1001 &100100000
+Prefab:
+  m_ObjectHideFlags: 1
+  serializedVersion: 2
+  m_Modification:
+    m_TransformParent: {fileID: 0}
+    m_Modifications: []
+    m_RemovedComponents: []
+  m_ParentPrefab: {fileID: 0}
+  m_RootGameObject: {fileID: 1000011}
+  m_IsPrefabParent: 1
+--- !u!1 &1000011
+GameObject:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  serializedVersion: 5
+  m_Component:
+  - component: {fileID: 4000011}
+  m_Layer: 0
+  m_Name: SourceRoot
+  m_IsActive: 1
+--- !u!4 &4000011
+Transform:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  m_GameObject: {fileID: 1000011}
+  m_LocalRotation: {x: 0, y: 0, z: 0, w: 1}
+  m_LocalPosition: {x: 0, y: 0, z: 0}
+  m_LocalScale: {x: 1, y: 1, z: 1}
+  m_Children:
+  - {fileID: 4000013}
+  m_Father: {fileID: 0}
+  m_RootOrder: 0
+--- !u!1 &1000013
+GameObject:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  serializedVersion: 5
+  m_Component:
+  - component: {fileID: 4000013}
+  m_Layer: 0
+  m_Name: SourceChild
+  m_IsActive: 1
+--- !u!4 &4000013
+Transform:
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 100100000}
+  m_GameObject: {fileID: 1000013}
+  m_LocalRotation: {x: 0, y: 0, z: 0, w: 1}
+  m_LocalPosition: {x: 0, y: 5, z: 0}
+  m_LocalScale: {x: 1, y: 1, z: 1}
+  m_Children: []
+  m_Father: {fileID: 4000011}
+  m_RootOrder: 0
+)";
+
+const char* ForwardReferenceScene = R"(%YAML 1.1
+%TAG !u! tag:unity3d.com,2011:
+--- !u!4 &401
+Transform:
+  m_ObjectHideFlags: 0
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 0}
+  m_GameObject: {fileID: 301}
+  m_LocalRotation: {x: 0, y: 0.70710677, z: 0, w: 0.70710677}
+  m_LocalPosition: {x: 1, y: 2, z: 3}
+  m_LocalScale: {x: 2, y: 2, z: 2}
+  m_Children: []
+  m_Father: {fileID: 400}
+  m_RootOrder: 0
+--- !u!1 &301
+GameObject:
+  m_ObjectHideFlags: 0
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 0}
+  serializedVersion: 5
+  m_Component:
+  - component: {fileID: 401}
+  m_Layer: 0
+  m_Name: Child
+  m_TagString: Untagged
+  m_IsActive: 0
+--- !u!4 &400
+Transform:
+  m_ObjectHideFlags: 0
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 0}
+  m_GameObject: {fileID: 300}
+  m_LocalRotation: {x: 0, y: 0, z: 0, w: 1}
+  m_LocalPosition: {x: -1, y: 0, z: 0}
+  m_LocalScale: {x: 1, y: 1, z: 1}
+  m_Children:
+  - {fileID: 401}
+  m_Father: {fileID: 0}
+  m_RootOrder: 1
+--- !u!1 &300
+GameObject:
+  m_ObjectHideFlags: 0
+  m_PrefabParentObject: {fileID: 0}
+  m_PrefabInternal: {fileID: 0}
+  serializedVersion: 5
+  m_Component:
+  - component: {fileID: 400}
+  m_Layer: 0
+  m_Name: Root
+  m_TagString: Untagged
+  m_IsActive: 1
+--- !u!4 &101 stripped
+Transform:
+  m_PrefabParentObject: {fileID: 4000011, guid: 5e7100000000000000000000000000a1,
+    type: 2}
+  m_PrefabInternal: {fileID: 100}
+--- !u!1001 &100
+Prefab:
+  m_ObjectHideFlags: 0
+  serializedVersion: 2
+  m_Modification:
+    m_TransformParent: {fileID: 0}
+    m_Modifications:
+    - target: {fileID: 4000011, guid: 5e7100000000000000000000000000a1, type: 2}
+      propertyPath: m_LocalPosition.x
+      value: 3
+      objectReference: {fileID: 0}
+    m_RemovedComponents: []
+  m_ParentPrefab: {fileID: 100100000, guid: 5e7100000000000000000000000000a1, type: 2}
+  m_IsPrefabParent: 0
+)";
+
+// the importer of SourcePrefab, loaded from the string above instead of a project file
+class SourcePrefabImporter : public NativeFormatImporter
+{
+public:
+	virtual void Import() override
+	{
+		YAMLInputArchive archive;
+		archive.LoadAllFromString(SourcePrefab);
+		m_FileIDToObject = archive.GetFileIDToObject();
+		auto prefab = m_FileIDToObject[100100000]->As<Prefab>();
+		for (auto&& p : m_FileIDToObject)
+			prefab->AddObject(p.first, p.second);
+		m_MainAsset = prefab;
+		m_Imported = true;
+	}
+};
+
+// a loaded by one archive and b by another from the same file: same class and serialized fields
+void AssertSameObject(Object* a, Object* b)
+{
+	assert((a == nullptr) == (b == nullptr));
+	if (a == nullptr)
+		return;
+	assert(a->GetClassID() == b->GetClassID());
+	assert(a->GetLocalIdentifierInFile() == b->GetLocalIdentifierInFile());
+	assert(a->GetName() == b->GetName());
+	if (a->Is<GameObject>())
+	{
+		auto ga = a->As<GameObject>(), gb = b->As<GameObject>();
+		assert(ga->IsActive() == gb->IsActive());
+		assert(ga->GetAllComponents().size() == gb->GetAllComponents().size());
+		for (auto ca = ga->GetAllComponents().begin(), cb = gb->GetAllComponents().begin(); ca != ga->GetAllComponents().end(); ++ca, ++cb)
+			assert((*ca)->GetClassID() == (*cb)->GetClassID() && (*cb)->GetGameObject() == gb);
+		assert((ga->GetTransform() == nullptr) == (gb->GetTransform() == nullptr));
+	}
+	else if (a->Is<Transform>())
+	{
+		auto ta = a->As<Transform>(), tb = b->As<Transform>();
+		assert(ta->GetLocalPosition() == tb->GetLocalPosition());
+		assert(ta->GetLocalRotation() == tb->GetLocalRotation());
+		assert(ta->GetLocalScale() == tb->GetLocalScale());
+		assert(ta->GetRootOrder() == tb->GetRootOrder());
+		assert(ta->GetChildren().size() == tb->GetChildren().size());
+		for (size_t i = 0; i < ta->GetChildren().size(); ++i)
+		{
+			auto ca = ta->GetChildren()[i], cb = tb->GetChildren()[i];
+			assert(cb->GetParent() == tb);
+			assert(ca->GetGameObject()->GetName() == cb->GetGameObject()->GetName());
+			assert(ca->GetLocalPosition() == cb->GetLocalPosition());
+		}
+		assert(ta->GetGameObject()->GetName() == tb->GetGameObject()->GetName());
+		auto pa = ta->GetParent(), pb = tb->GetParent();
+		assert((pa == nullptr) == (pb == nullptr));
+		if (pa != nullptr)
+			assert(pa->GetLocalIdentifierInFile() == pb->GetLocalIdentifierInFile() && pa->GetGameObject()->GetName() == pb->GetGameObject()->GetName());
+	}
+}
+
+// every fileID of a maps to the same object in b
+void AssertSameFileIDs(const std::map<int64_t, Object*>& a, const std::map<int64_t, Object*>& b)
+{
+	assert(a.size() == b.size());
+	for (auto&& p : a)
+	{
+		auto it = b.find(p.first);
+		assert(it != b.end());
+		AssertSameObject(p.second, it->second);
+	}
+}
+
+// exposes the key index of YAMLInputArchive
+class KeyIndexArchive : public YAMLInputArchive
+{
+public:
+	using YAMLInputArchive::PushNode;
+	using YAMLInputArchive::PopNode;
+
+	size_t GetIndexSize() const { return m_keyIndex.size(); }
+	size_t GetValueCount() const { return m_keyValues.size(); }
+};
+
+struct KeyIndexItem
+{
+	std::string	name;
+	Vector3		value;
+};
+
+InputArchive& operator>>(InputArchive& archive, KeyIndexItem& item)
+{
+	archive.AddNVP("name", item.name);
+	archive.AddNVP("value", item.value);
+	return archive;
+}
+
+// MapKey lookups through the key index: missing and duplicated keys, maps inside sequence items, and
+// the tables of popped maps dropped from the pool
+void TestKeyIndex()
+{
+	auto document = YAML::Load(
+		"a: 1\n"
+		"position: {x: 1, y: 2, z: 3}\n"
+		"items:\n"
+		"- {name: first, value: {x: 4, y: 0, z: 0}}\n"
+		"- name: second\n"
+		"  value: {x: 5, y: 0, z: 0}\n"
+		"d: 8\n"
+		"d: 9\n");
+	const size_t keyCount = document.size();
+	KeyIndexArchive archive;
+	archive.PushNode(document);
+
+	int a = 0;
+	archive.AddNVP("a", a);
+	assert(a == 1);
+	const size_t rootIndexSize = archive.GetIndexSize();
+	assert(rootIndexSize > 0);
+
+	// a missing key leaves the value as is, and is not added to the document
+	int missing = -1;
+	archive.AddNVP("missing", missing);
+	assert(missing == -1);
+	assert(document.size() == keyCount);
+
+	// the first of duplicated keys wins, like node[key]
+	int d = 0;
+	archive.AddNVP("d", d);
+	assert(d == 8);
+
+	// nested maps, in the root and in sequence items, push their own tables and drop them on pop
+	Vector3 position;
+	archive.AddNVP("position", position);
+	assert(position == Vector3(1, 2, 3));
+	assert(archive.GetIndexSize() == rootIndexSize);
+	std::vector<KeyIndexItem> items;
+	archive.AddNVP("items", items);
+	assert(items.size() == 2);
+	assert(items[0].name == "first" && items[0].value == Vector3(4, 0, 0));
+	assert(items[1].name == "second" && items[1].value == Vector3(5, 0, 0));
+	assert(archive.GetIndexSize() == rootIndexSize);
+
+	// the root table is still valid after the pops
+	a = 0;
+	archive.AddNVP("a", a);
+	assert(a == 1);
+	archive.PopNode();
+	assert(archive.GetIndexSize() == 0 && archive.GetValueCount() == 0);
+}
+
 int main()
 {
+	TestKeyIndex();
+
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
@@ -69,6 +358,79 @@ int main()
 		auto str = ReadFileAsString(projectPath + '/' + scenePath);
 		YAMLInputArchive input;
 		auto objects = input.LoadAllFromString(str);
+
+		// cook and load back
+		std::stringstream buffer;
+		BinaryOutputArchive output(buffer);
+		output.Dump(objects, input.GetFileIDToObject());
+		auto cooked = buffer.str();
+		printf("YAML: %zu bytes, binary: %zu bytes\n", str.size(), cooked.size());
+
+		// every fileID of the file maps to the same object, prefab instances included
+		BinaryInputArchive binaryInput;
+		auto cookedObjects = binaryInput.LoadAllFromString(cooked);
+		assert(!cookedObjects.empty());
+		AssertSameFileIDs(input.GetFileIDToObject(), binaryInput.GetFileIDToObject());
+
+		// a damaged cooked file loads as nothing, the importers then use the YAML file
+		auto damaged = cooked;
+		damaged[damaged.size() / 2] ^= 0x20;
+		for (auto&& data : { cooked.substr(0, 10), cooked.substr(0, cooked.size() / 2), cooked.substr(0, cooked.size() - 1), damaged })
+		{
+			BinaryInputArchive damagedInput;
+			assert(damagedInput.LoadAllFromString(data).empty());
+		}
+	}
+
+	// the streaming loader must build the same objects as the DOM one
+	{
+		auto str = ReadFileAsString(projectPath + '/' + scenePath);
+		YAMLInputArchive input;
+		auto objects = input.LoadAllFromString(str);
+
+		std::ifstream is(projectPath + '/' + scenePath);
+		YAMLInputArchive streamInput;
+		auto streamObjects = streamInput.LoadAllFromStream(is);
+		assert(streamObjects.size() == objects.size());
+		for (size_t i = 0; i < objects.size(); ++i)
+			AssertSameObject(objects[i], streamObjects[i]);
+		AssertSameFileIDs(input.GetFileIDToObject(), streamInput.GetFileIDToObject());
+	}
+
+	// forward references and a prefab instance: the three loaders agree, and build the links of the file
+	{
+		auto sourceImporter = new SourcePrefabImporter();
+		sourceImporter->SetGUID(SourcePrefabGUID);
+		AssetImporter::AddImporter(sourceImporter, SourcePrefabGUID);
+		AssetDatabase::AddAssetPathAndGUIDPair(SourcePrefabPath, SourcePrefabGUID);
+
+		YAMLInputArchive input;
+		auto objects = input.LoadAllFromString(ForwardReferenceScene);
+		auto& fileIDToObject = input.GetFileIDToObject();
+		auto child = fileIDToObject.at(401)->As<Transform>();
+		assert(child->GetGameObject() == fileIDToObject.at(301));
+		assert(child->GetParent() == fileIDToObject.at(400));
+		assert(!child->GetGameObject()->IsActive());
+		assert(child->GetLocalPosition() == Vector3(1, 2, 3));
+		assert(child->GetLocalScale() == Vector3(2, 2, 2));
+		auto instance = fileIDToObject.at(101)->As<Transform>();
+		assert(instance->GetGameObject()->GetName() == "SourceRoot");
+		assert(instance->GetLocalPosition().x == 3);
+		assert(instance->GetChildren().size() == 1 && instance->GetChildren()[0]->GetLocalPosition().y == 5);
+		assert(fileIDToObject.at(100) == instance->GetGameObject());
+
+		std::istringstream is(ForwardReferenceScene);
+		YAMLInputArchive streamInput;
+		auto streamObjects = streamInput.LoadAllFromStream(is);
+		assert(streamObjects.size() == objects.size());
+		AssertSameFileIDs(fileIDToObject, streamInput.GetFileIDToObject());
+
+		std::stringstream buffer;
+		BinaryOutputArchive output(buffer);
+		output.Dump(objects, fileIDToObject);
+		BinaryInputArchive binaryInput;
+		assert(!binaryInput.LoadAllFromString(buffer.str()).empty());
+		AssertSameFileIDs(fileIDToObject, binaryInput.GetFileIDToObject());
 	}
 
 	{